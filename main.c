@@ -47,6 +47,14 @@ void UnitTestNNBaseFun() {
         sprintf(NeuraNetErr->_msg, "NNBaseFun failed");
         PBErrCatch(NeuraNetErr);
       }
+      float slope = 0.0;
+      float offset = 0.0;
+      NNBaseFunCoeff(param, &slope, &offset);
+      if (ISEQUALF(slope * x + offset, check[iTest * 10 + ix]) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNBaseFunCoeff failed");
+        PBErrCatch(NeuraNetErr);
+      }
     }
   }
   printf("UnitTestNNBaseFun OK\n");
@@ -110,6 +118,23 @@ void UnitTestNeuraNetCreateFullyConnected() {
       sprintf(NeuraNetErr->_msg, "NeuraNetCreateFullyConnected failed");
       PBErrCatch(NeuraNetErr);
     }
+  for (int i = 6; i--;) {
+    NNBasesSet(nn, i * NN_NBPARAMBASE, 0.5);
+    NNBasesSet(nn, i * NN_NBPARAMBASE + 2, 0.1 * (float)i);
+  }
+  VecFloat2D input = VecFloatCreateStatic2D();
+  VecFloat3D output = VecFloatCreateStatic3D();
+  VecSet(&input, 0, 0.5);
+  VecSet(&input, 1, -0.25);
+  NNEval(nn, (VecFloat*)&input, (VecFloat*)&output);
+  for (int iOut = 3; iOut--;) {
+    float check = tan(0.5 * NN_THETA) * 0.25 + 0.1 * (float)(2 * iOut + 3);
+    if (ISEQUALF(VecGet(&output, iOut), check) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NeuraNetCreateFullyConnected failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
   NeuraNetFree(&nn);
   nbIn = 5;
   nbOut = 2;
@@ -167,7 +192,6 @@ void UnitTestNeuraNetCreateConvolution() {
   VecSet(dimCell, 1, 2);
   NeuraNet* nn = NeuraNetCreateConvolution(dimIn, nbOut, dimCell, 
     depthConv, thickConv);
-  NNPrintln(nn, stdout);
   if (nn == NULL ||
     nn->_nbInputVal != 12 ||
     nn->_nbOutputVal != 2 ||
@@ -175,12 +199,25 @@ void UnitTestNeuraNetCreateConvolution() {
     nn->_nbMaxBases != 24 ||
     nn->_nbMaxLinks != 72 ||
     nn->_bases == NULL ||
-    nn->_links == NULL ||
+    nn->_links != NULL ||
+    nn->_nbPackedGroups != 0 ||
+    NNGetNbActiveLinks(nn) != 72 ||
     nn->_hidVal == NULL) {
     NeuraNetErr->_type = PBErrTypeUnitTestFailed;
     sprintf(NeuraNetErr->_msg, "NeuraNetCreateConvolution failed");
     PBErrCatch(NeuraNetErr);
   }
+  NNPrintln(nn, stdout);
+  if (nn->_links != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPrintln failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (NNLinks(nn) == NULL || NNLinks(nn) != nn->_links) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNExpandLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
   int check[216] = {
     0,0,12, 4,0,18, 1,1,12, 0,1,13, 5,1,18, 4,1,19, 1,2,13, 0,2,14,
     5,2,19, 4,2,20, 1,3,14, 5,3,20, 2,4,12, 0,4,15, 6,4,18, 4,4,21,
@@ -274,6 +311,20 @@ void UnitTestNeuraNetGetSet() {
       sprintf(NeuraNetErr->_msg, "NNSetBases failed");
       PBErrCatch(NeuraNetErr);
     }
+  NNBasesSet(nn, 3, 0.5);
+  for (int iBase = nbBase; iBase--;) {
+    const float* param = NNBases(nn)->_val + iBase * NN_NBPARAMBASE;
+    float slope = VecGet(nn->_basesCoeff, iBase * NN_NBCOEFFBASE);
+    float offset = VecGet(nn->_basesCoeff, iBase * NN_NBCOEFFBASE + 1);
+    for (int ix = -10; ix <= 10; ++ix) {
+      float x = 0.1 * (float)ix;
+      if (ISEQUALF(slope * x + offset, NNBaseFun(param, x)) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNUpdateBaseCoeff failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    }
+  }
   VecFree(&bases);
   VecLong* links = VecLongCreate(15);
   short data[15] = {2,2,35, 1,1,12, -1,0,0, 2,15,20, 3,20,15};
@@ -292,11 +343,626 @@ void UnitTestNeuraNetGetSet() {
     sprintf(NeuraNetErr->_msg, "NNGetNbActiveLinks failed");
     PBErrCatch(NeuraNetErr);
   }
+  long checkPlan[9] = {1,12,1, 2,35,1, 15,20,2};
+  if (nn->_nbPackedGroups != 3 || 
+    nn->_packedWidth != sizeof(uint16_t)) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (int i = 9; i--;)
+    if (((const uint16_t*)(nn->_packedPlan))[i] != checkPlan[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  // Links sharing their input and output keep their relative order, 
+  // links out of bounds don't split the groups of the others
+  short dataTie[15] = {3,2,35, 0,70,1, 1,35,2, 2,-3,20, 0,2,35};
+  for (int i = 15; i--;)
+    VecSet(links, i, dataTie[i]);
+  NNSetLinks(nn, links);
+  short checkTie[15] = {2,-3,20, 0,1,70, 3,2,35, 1,2,35, 0,2,35};
+  for (int i = 15; i--;)
+    if (VecGet(NNLinks(nn), i) != checkTie[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  long checkPlanTie[3] = {2,35,3};
+  if (nn->_nbPackedGroups != 1 || nn->_nbPackedLinks != 3 ||
+    nn->_nbActiveLinks != 5) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (int i = 3; i--;)
+    if (((const uint16_t*)(nn->_packedPlan))[i] != checkPlanTie[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  // The scratch memory of the sort is reused by the following updates
+  // of the links
+  long* scratch = nn->_scratch;
+  NNSetLinks(nn, links);
+  if (scratch == NULL || nn->_scratch != scratch) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
   VecFree(&links);
   NeuraNetFree(&nn);
   printf("UnitTestNeuraNetGetSet OK\n");
 }
 
+void UnitTestNeuraNetSetLinksScale() {
+  srandom(RANDOMSEED);
+  // A NeuraNet with one million values, far beyond the ids whose sort 
+  // keys would be exact as floats
+  int nbIn = 1000;
+  int nbOut = 10;
+  long nbHid = 1000000 - nbIn - nbOut;
+  long nbBase = 100;
+  long nbLink = 1000000;
+  long nbVal = nbIn + nbHid + nbOut;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  // Random links, some inactive, with input and output in any order
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  long nbActive = 0;
+  for (long iLink = nbLink; iLink--;) {
+    long in = (long)(rnd() * (float)(nbIn + nbHid)) % (nbIn + nbHid);
+    long out = nbIn + 
+      (long)(rnd() * (float)(nbHid + nbOut)) % (nbHid + nbOut);
+    long base = (iLink % 10 == 0 ? -1 : iLink % nbBase);
+    if (base != -1)
+      ++nbActive;
+    VecSet(links, iLink * NN_NBPARAMLINK, base);
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, (iLink % 2 ? in : out));
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, (iLink % 2 ? out : in));
+  }
+  NNSetLinks(nn, links);
+  if (NNGetNbActiveLinks(nn) != nbActive) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // The links are sorted on their input then output, with an input 
+  // not greater than the output
+  for (long iLink = 0; iLink < nbActive; ++iLink) {
+    long in = VecGet(NNLinks(nn), iLink * NN_NBPARAMLINK + 1);
+    long out = VecGet(NNLinks(nn), iLink * NN_NBPARAMLINK + 2);
+    long prevIn = (iLink > 0 ? 
+      VecGet(NNLinks(nn), (iLink - 1) * NN_NBPARAMLINK + 1) : 0);
+    long prevOut = (iLink > 0 ? 
+      VecGet(NNLinks(nn), (iLink - 1) * NN_NBPARAMLINK + 2) : 0);
+    if (in > out || in < prevIn || (in == prevIn && out < prevOut)) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  // The order of the execution plan is topologically valid: no value 
+  // receives a contribution after having been used as an input, 
+  // except from itself
+  VecShort* isRead = VecShortCreate(nbVal);
+  if (nn->_packedWidth != sizeof(uint32_t)) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iGroup = 0; iGroup < nn->_nbPackedGroups; ++iGroup) {
+    const uint32_t* group = (const uint32_t*)(nn->_packedPlan) + 
+      iGroup * 3;
+    long in = group[0];
+    long out = group[1];
+    if (in != out && VecGet(isRead, out) != 0) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    VecSet(isRead, in, 1);
+  }
+  if (NNGetNbLevel(nn) == -1) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdateLevels failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&isRead);
+  VecFree(&links);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetSetLinksScale OK\n");
+}
+
+void UnitTestNeuraNetUpdateLinks() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 2;
+  long nbHid = 4;
+  long nbBase = 12;
+  long nbLink = 12;
+  long nbVal = nbIn + nbHid + nbOut;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  NeuraNet* nnRef = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;) {
+    float v = 2.0 * (rnd() - 0.5);
+    NNBasesSet(nn, iBase, v);
+    NNBasesSet(nnRef, iBase, v);
+  }
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  for (long iLink = nbLink; iLink--;) {
+    VecSet(links, iLink * NN_NBPARAMLINK, 
+      (iLink % 4 == 0 ? -1 : iLink));
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+  }
+  NNSetLinks(nn, links);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputRef = VecFloatCreate(nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  // Modify the base functions only, then the base functions, inputs
+  // and outputs, including links becoming active or inactive
+  VecLong* indices = VecLongCreate(3);
+  VecLong* changes = VecLongCreate(3 * NN_NBPARAMLINK);
+  for (int iStep = 0; iStep < 20; ++iStep) {
+    for (long iChange = 3; iChange--;) {
+      long iLink = (iStep + 4 * iChange) % nbLink;
+      long base = VecGet(links, iLink * NN_NBPARAMLINK);
+      long in = VecGet(links, iLink * NN_NBPARAMLINK + 1);
+      long out = VecGet(links, iLink * NN_NBPARAMLINK + 2);
+      if (iStep % 2 == 0 && base != -1) {
+        base = (long)(rnd() * (float)nbBase) % nbBase;
+      } else if (iStep % 2 == 1) {
+        base = (iStep % 3 == 0 ? -1 : 
+          (long)(rnd() * (float)nbBase) % nbBase);
+        in = (long)(rnd() * (float)nbVal) % nbVal;
+        out = (long)(rnd() * (float)nbVal) % nbVal;
+      }
+      VecSet(indices, iChange, iLink);
+      VecSet(changes, iChange * NN_NBPARAMLINK, base);
+      VecSet(changes, iChange * NN_NBPARAMLINK + 1, in);
+      VecSet(changes, iChange * NN_NBPARAMLINK + 2, out);
+      VecSet(links, iLink * NN_NBPARAMLINK, base);
+      VecSet(links, iLink * NN_NBPARAMLINK + 1, in);
+      VecSet(links, iLink * NN_NBPARAMLINK + 2, out);
+    }
+    // The result is the same as setting the modified links
+    NNUpdateLinks(nn, indices, changes);
+    NNSetLinks(nnRef, links);
+    for (long iLink = 0; iLink < nbLink; ++iLink) {
+      bool isActive = 
+        (VecGet(NNLinks(nnRef), iLink * NN_NBPARAMLINK) != -1);
+      for (int iParam = (isActive ? NN_NBPARAMLINK : 1); iParam--;)
+        if (VecGet(NNLinks(nn), iLink * NN_NBPARAMLINK + iParam) != 
+          VecGet(NNLinks(nnRef), iLink * NN_NBPARAMLINK + iParam)) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+          PBErrCatch(NeuraNetErr);
+        }
+    }
+    NNEval(nn, input, output);
+    NNEval(nnRef, input, outputRef);
+    if (VecIsEqual(output, outputRef) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  NeuraNetFree(&nn);
+  // Links moved in bounds are moved in place, the levels are updated 
+  // with the plan per destination and rebuilt when needed without it
+  VecLong* index = VecLongCreate(1);
+  VecLong* change = VecLongCreate(NN_NBPARAMLINK);
+  for (int iPlan = 2; iPlan--;) {
+    nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+    for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+      NNBasesSet(nn, iBase, VecGet(NNBases(nnRef), iBase));
+    NNSetPlanPerDst(nn, iPlan == 1);
+    NNSetPlanPerDst(nnRef, iPlan == 1);
+    for (long iLink = nbLink; iLink--;) {
+      VecSet(links, iLink * NN_NBPARAMLINK, iLink);
+      VecSet(links, iLink * NN_NBPARAMLINK + 1, 
+        (long)(rnd() * (float)(nbIn + nbHid)) % (nbIn + nbHid));
+      VecSet(links, iLink * NN_NBPARAMLINK + 2, 
+        nbIn + (long)(rnd() * (float)(nbHid + nbOut)) % (nbHid + nbOut));
+    }
+    NNSetLinks(nn, links);
+    for (int iStep = 0; iStep < 20; ++iStep) {
+      long iLink = (iStep * 5) % nbLink;
+      long in = (long)(rnd() * (float)(nbIn + nbHid)) % (nbIn + nbHid);
+      long out = 
+        nbIn + (long)(rnd() * (float)(nbHid + nbOut)) % (nbHid + nbOut);
+      VecSet(index, 0, iLink);
+      VecSet(change, 0, (iStep % 7 == 6 ? -1 : iLink));
+      VecSet(change, 1, in);
+      VecSet(change, 2, out);
+      for (int iParam = NN_NBPARAMLINK; iParam--;)
+        VecSet(links, iLink * NN_NBPARAMLINK + iParam, 
+          VecGet(change, iParam));
+      NNUpdateLinks(nn, index, change);
+      NNSetLinks(nnRef, links);
+      long nbLevel = NNGetNbLevel(nnRef);
+      if (NNGetNbLevel(nn) != nbLevel ||
+        NNHasPlanPerDst(nn) != NNHasPlanPerDst(nnRef)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+        PBErrCatch(NeuraNetErr);
+      }
+      for (long iLevel = 0; iLevel <= nbLevel; ++iLevel)
+        if (VecGet(nn->_levelStart, iLevel) != 
+          VecGet(nnRef->_levelStart, iLevel)) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+          PBErrCatch(NeuraNetErr);
+        }
+      for (long i = VecGet(nnRef->_levelStart, nbLevel); i--;)
+        if (VecGet(nn->_levelDst, i) != VecGet(nnRef->_levelDst, i)) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+          PBErrCatch(NeuraNetErr);
+        }
+      NNEval(nn, input, output);
+      NNEval(nnRef, input, outputRef);
+      if (VecIsEqual(output, outputRef) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    }
+    NeuraNetFree(&nn);
+  }
+  VecFree(&index);
+  VecFree(&change);
+  // The dense layers of a fully connected NeuraNet are discarded when 
+  // a link is modified
+  VecLong* hiddenLayers = VecLongCreate(1);
+  VecSet(hiddenLayers, 0, 4);
+  nn = NeuraNetCreateFullyConnected(3, 2, hiddenLayers);
+  VecSetNull(indices);
+  for (long iChange = 3; iChange--;)
+    for (int iParam = NN_NBPARAMLINK; iParam--;)
+      VecSet(changes, iChange * NN_NBPARAMLINK + iParam, 
+        VecGet(NNLinks(nn), iParam));
+  NNUpdateLinks(nn, indices, changes);
+  if (nn->_layers == NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecSet(changes, 0, 1);
+  NNUpdateLinks(nn, indices, changes);
+  if (nn->_layers != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdateLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&hiddenLayers);
+  VecFree(&indices);
+  VecFree(&changes);
+  VecFree(&links);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputRef);
+  NeuraNetFree(&nn);
+  NeuraNetFree(&nnRef);
+  printf("UnitTestNeuraNetUpdateLinks OK\n");
+}
+
+void UnitTestNeuraNetBind() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 2;
+  long nbHid = 4;
+  long nbBase = 10;
+  long nbLink = 10;
+  long nbVal = nbIn + nbHid + nbOut;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  NeuraNet* nnRef = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  VecFloat* bases = VecFloatCreate(nbBase * NN_NBPARAMBASE);
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+    VecSet(bases, iBase, 2.0 * (rnd() - 0.5));
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  for (long iLink = nbLink; iLink--;) {
+    VecSet(links, iLink * NN_NBPARAMLINK, 
+      (iLink % 4 == 0 ? -1 : iLink));
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+  }
+  NNSetBases(nnRef, bases);
+  NNSetLinks(nnRef, links);
+  // Bind the sorted links of the reference NeuraNet
+  VecLong* sortedLinks = VecClone(NNLinks(nnRef));
+  NNSetBases(nn, bases);
+  NNBindLinks(nn, sortedLinks);
+  if (NNLinks(nn) != sortedLinks) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNBindLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputRef = VecFloatCreate(nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  NNEval(nn, input, output);
+  NNEval(nnRef, input, outputRef);
+  if (VecIsEqual(output, outputRef) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNBindLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // Modifying the links unbinds the bound vector without modifying it
+  VecLong* indices = VecLongCreate(1);
+  VecLong* change = VecLongCreate(NN_NBPARAMLINK);
+  VecSet(change, 0, 1);
+  VecSet(change, 1, 0);
+  VecSet(change, 2, nbVal - 1);
+  NNUpdateLinks(nn, indices, change);
+  if (NNLinks(nn) == sortedLinks ||
+    VecIsEqual(sortedLinks, NNLinks(nnRef)) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUnbindLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // Replacing entirely the bound vector doesn't use it anymore, it can
+  // be freed before
+  VecLong* linksTmp = VecClone(sortedLinks);
+  NNBindLinks(nn, linksTmp);
+  VecFree(&linksTmp);
+  NNSetLinks(nn, links);
+  NNSetLinks(nnRef, links);
+  if (NNLinks(nn) == sortedLinks ||
+    VecIsEqual(NNLinks(nn), NNLinks(nnRef)) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // The bound vector is not freed with the NeuraNet
+  NNBindLinks(nn, sortedLinks);
+  NeuraNetFree(&nn);
+  VecFree(&indices);
+  VecFree(&change);
+  VecFree(&bases);
+  VecFree(&links);
+  VecFree(&sortedLinks);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputRef);
+  NeuraNetFree(&nnRef);
+  printf("UnitTestNeuraNetBind OK\n");
+}
+
+void UnitTestNeuraNetClone() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 2;
+  long nbHid = 4;
+  long nbBase = 10;
+  long nbLink = 10;
+  long nbVal = nbIn + nbHid + nbOut;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  VecFloat* bases = VecFloatCreate(nbBase * NN_NBPARAMBASE);
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+    VecSet(bases, iBase, 2.0 * (rnd() - 0.5));
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  for (long iLink = nbLink; iLink--;) {
+    VecSet(links, iLink * NN_NBPARAMLINK, 
+      (iLink % 4 == 0 ? -1 : (iLink + 1) % nbBase));
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, 
+      (long)(rnd() * (float)nbVal) % nbVal);
+  }
+  NNSetBases(nn, bases);
+  NNSetLinks(nn, links);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputClone = VecFloatCreate(nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  NNEval(nn, input, output);
+  NNSetPlanPerDst(nn, true);
+  // The clone is in its own memory aligned on cache lines, and the 
+  // plan per destination is copied
+  NeuraNet* clone = NNClone(nn);
+  if ((uintptr_t)clone % NN_CACHELINE != 0 ||
+    (uintptr_t)NNBases(clone) % NN_CACHELINE != 0 ||
+    (uintptr_t)NNLinks(clone) % NN_CACHELINE != 0 ||
+    NNBases(clone) == bases || NNLinks(clone) == NNLinks(nn) ||
+    VecIsEqual(NNBases(clone), bases) == false ||
+    VecIsEqual(NNLinks(clone), NNLinks(nn)) == false ||
+    clone->_dstArena == NULL || clone->_dstPlan == nn->_dstPlan ||
+    memcmp(clone->_dstPlan, nn->_dstPlan, 
+      nn->_packedWidth * 3 * nn->_nbPackedGroups) != 0 ||
+    memcmp(clone->_dstBase, nn->_dstBase, 
+      nn->_packedWidth * nn->_nbPackedLinks) != 0) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNClone failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNEval(clone, input, outputClone);
+  if (VecIsEqual(output, outputClone) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNClone failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // Modifying the clone doesn't modify the cloned NeuraNet
+  NNBasesSet(clone, 0, -0.5);
+  NNSetLinks(clone, links);
+  if (VecGet(bases, 0) == -0.5 || VecGet(NNBases(nn), 0) == -0.5) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNClone failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // Copy back the NeuraNet into the clone, including its plan per 
+  // destination
+  NNSetPlanPerDst(clone, false);
+  NNCloneInto(clone, nn);
+  NNEval(clone, input, outputClone);
+  if (VecIsEqual(output, outputClone) == false ||
+    clone->_dstArena == NULL || clone->_dstPlan == nn->_dstPlan ||
+    memcmp(clone->_dstPlan, nn->_dstPlan, 
+      nn->_packedWidth * 3 * nn->_nbPackedGroups) != 0 ||
+    memcmp(clone->_dstBase, nn->_dstBase, 
+      nn->_packedWidth * nn->_nbPackedLinks) != 0) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNCloneInto failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NeuraNetFree(&clone);
+  NeuraNetFree(&nn);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputClone);
+  // Clone a NeuraNet with implicit links, then expand them and copy 
+  // it again into the clone
+  VecShort* dimIn = VecShortCreate(2);
+  VecSet(dimIn, 0, 4);
+  VecSet(dimIn, 1, 3);
+  VecShort* dimCell = VecShortCreate(2);
+  VecSet(dimCell, 0, 2);
+  VecSet(dimCell, 1, 2);
+  nn = NeuraNetCreateConvolution(dimIn, nbOut, dimCell, 2, 2);
+  for (long iBase = NNGetNbMaxBases(nn) * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nn, iBase, 2.0 * (rnd() - 0.5));
+  input = VecFloatCreate(NNGetNbInput(nn));
+  output = VecFloatCreate(nbOut);
+  outputClone = VecFloatCreate(nbOut);
+  for (long iIn = NNGetNbInput(nn); iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  NNEval(nn, input, output);
+  clone = NNClone(nn);
+  NNEval(clone, input, outputClone);
+  if (NNConv(clone) == NULL || NNConv(clone) == NNConv(nn) ||
+    clone->_links != NULL ||
+    VecIsEqual(output, outputClone) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNClone failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNExpandLinks(nn);
+  NNCloneInto(clone, nn);
+  NNEval(clone, input, outputClone);
+  if (NNLinks(clone) == NULL || NNLinks(clone) == NNLinks(nn) ||
+    VecIsEqual(NNLinks(clone), NNLinks(nn)) == false ||
+    VecIsEqual(output, outputClone) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNCloneInto failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NeuraNetFree(&clone);
+  NeuraNetFree(&nn);
+  VecFree(&dimIn);
+  VecFree(&dimCell);
+  VecFree(&bases);
+  VecFree(&links);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputClone);
+  printf("UnitTestNeuraNetClone OK\n");
+}
+
+void UnitTestNeuraNetPlanCache() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 2;
+  long nbHid = 4;
+  long nbBase = 10;
+  long nbLink = 12;
+  long nbVal = nbIn + nbHid + nbOut;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  NeuraNet* nnRef = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;) {
+    float v = 2.0 * (rnd() - 0.5);
+    NNBasesSet(nn, iBase, v);
+    NNBasesSet(nnRef, iBase, v);
+  }
+  // Three sets of links
+  VecLong* links[3];
+  for (int iSet = 3; iSet--;) {
+    links[iSet] = VecLongCreate(nbLink * NN_NBPARAMLINK);
+    for (long iLink = nbLink; iLink--;) {
+      VecSet(links[iSet], iLink * NN_NBPARAMLINK, 
+        (iLink % 5 == 0 ? -1 : (long)(rnd() * (float)nbBase) % nbBase));
+      VecSet(links[iSet], iLink * NN_NBPARAMLINK + 1, 
+        (long)(rnd() * (float)nbVal) % nbVal);
+      VecSet(links[iSet], iLink * NN_NBPARAMLINK + 2, 
+        (long)(rnd() * (float)nbVal) % nbVal);
+    }
+  }
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputRef = VecFloatCreate(nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  // Set the links in an order making the least recently used entry 
+  // replaced, with the expected hits
+  NNPlanCache* cache = NNPlanCacheCreate(nn, 2);
+  int seq[8] = {0, 1, 0, 2, 1, 0, 0, 2};
+  bool hit[8] = {false, false, true, false, false, false, true, false};
+  for (int iStep = 0; iStep < 8; ++iStep) {
+    // Change the order of the groups of links before a hit on links 
+    // cached in the previous order, their plan per destination is 
+    // built
+    if (iStep == 6)
+      NNSetLinkOrder(nn, NNLinkOrderOutputMajor);
+    unsigned long nbHit = NNPlanCacheGetNbHit(cache);
+    NNSetLinksCached(nn, links[seq[iStep]], cache);
+    NNSetLinks(nnRef, links[seq[iStep]]);
+    NNEval(nn, input, output);
+    NNEval(nnRef, input, outputRef);
+    if ((NNPlanCacheGetNbHit(cache) != nbHit) != hit[iStep] ||
+      VecIsEqual(NNLinks(nn), NNLinks(nnRef)) == false ||
+      nn->_nbPackedGroups != nnRef->_nbPackedGroups ||
+      memcmp(nn->_packedPlan, nnRef->_packedPlan, 
+        nn->_packedWidth * 3 * nn->_nbPackedGroups) != 0 ||
+      VecIsEqual(nn->_linksOrigin, nnRef->_linksOrigin) == false ||
+      VecIsEqual(output, outputRef) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNSetLinksCached failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  // The ids of inactive links are ignored
+  VecSet(links[2], 1, (VecGet(links[2], 1) + 1) % nbVal);
+  NNSetLinksCached(nn, links[2], cache);
+  if (NNPlanCacheGetNbHit(cache) != 3 || 
+    NNPlanCacheGetNbMiss(cache) != 6 ||
+    ISEQUALF(NNPlanCacheGetHitRate(cache), 3.0 / 9.0) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinksCached failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNPlanCacheFlush(cache);
+  if (NNPlanCacheGetNbHit(cache) != 0 || 
+    NNPlanCacheGetNbMiss(cache) != 0 ||
+    NNPlanCacheGetHitRate(cache) != 0.0) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPlanCacheFlush failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNPlanCacheFree(&cache);
+  if (cache != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPlanCacheFree failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (int iSet = 3; iSet--;)
+    VecFree(links + iSet);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputRef);
+  NeuraNetFree(&nn);
+  NeuraNetFree(&nnRef);
+  printf("UnitTestNeuraNetPlanCache OK\n");
+}
+
 void UnitTestNeuraNetSaveLoadPrune() {
   int nbIn = 10;
   int nbOut = 20;
@@ -353,7 +1019,7 @@ void UnitTestNeuraNetSaveLoadPrune() {
     }
   fclose(fd);
   NeuraNetFree(&loaded);
-  NNPrune(nn);
+  NNPruneStats stats = NNPrune(nn);
   short checkprune[15] = {-1,1,12,-1,2,35,-1,15,20,-1,15,20,-1,0,0};
   for (int i = 15; i--;)
     if (VecGet(NNLinks(nn), i) != checkprune[i]) {
@@ -361,40 +1027,162 @@ void UnitTestNeuraNetSaveLoadPrune() {
       sprintf(NeuraNetErr->_msg, "NNPrune failed");
       PBErrCatch(NeuraNetErr);
     }
+  if (stats._nbLinkRemoved != 4 || stats._nbHiddenFreed != 4) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPrune failed");
+    PBErrCatch(NeuraNetErr);
+  }
   NeuraNetFree(&nn);
   printf("UnitTestNeuraNetSaveLoadPrune OK\n");
 }
 
-void UnitTestNeuraNetEvalPrintHiddenLinkSimpsonDiv() {
-  int nbIn = 3;
-  int nbOut = 3;
-  int nbHid = 3;
+void UnitTestNeuraNetPrune() {
+  srandom(RANDOMSEED);
+  int nbIn = 2;
+  int nbOut = 1;
+  int nbHid = 5;
   int nbBase = 3;
-  int nbLink = 7;
+  int nbLink = 10;
   NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
-  // hidden[0] = tan(0.5*NN_THETA)*tan(-0.5*NN_THETA)*input[0]^2
-  // hidden[1] = tan(0.5*NN_THETA)*input[1]
-  // hidden[2] = 0
-  // output[0] = tan(0.5*NN_THETA)*hidden[0]+tan(0.5*NN_THETA)*hidden[1]
-  // output[1] = tan(0.5*NN_THETA)*hidden[1]
-  // output[2] = 0
+  for (int i = nbBase * NN_NBPARAMBASE; i--;)
+    NNBasesSet(nn, i, 2.0 * (rnd() - 0.5));
+  // Two chains from the inputs to the output through the hidden 
+  // values 2 and 6, and a dead chain through the hidden values 3, 4 
+  // and 5 ending with a loop on 5
+  short data[30] = {0,0,2, 1,2,7, -1,0,0, 2,1,3, 0,3,4, 1,4,5, 2,5,5, 
+    0,1,6, 1,6,7, -1,0,0};
+  VecLong* links = VecLongCreate(30);
+  for (int i = 30; i--;)
+    VecSet(links, i, data[i]);
+  NNSetLinks(nn, links);
+  VecFree(&links);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputPruned = VecFloatCreate(nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+  NNEval(nn, input, output);
+  // The whole dead chain is removed and the remaining links are moved
+  // before the removed ones
+  NNPruneStats stats = NNPrune(nn);
+  short check[12] = {0,0,2, 0,1,6, 1,2,7, 1,6,7};
+  for (int i = 12; i--;)
+    if (VecGet(NNLinks(nn), i) != check[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNPrune failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  for (int iLink = 4; iLink < nbLink; ++iLink)
+    if (VecGet(NNLinks(nn), iLink * NN_NBPARAMLINK) != -1) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNPrune failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  if (stats._nbLinkRemoved != 4 || stats._nbHiddenFreed != 3) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPrune failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // The pruned links give the same outputs
+  NNEval(nn, input, outputPruned);
+  if (VecIsEqual(output, outputPruned) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPrune failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // Pruning again removes nothing
+  stats = NNPrune(nn);
+  if (stats._nbLinkRemoved != 0 || stats._nbHiddenFreed != 0) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNPrune failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputPruned);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetPrune OK\n");
+}
+
+// Create the NeuraNet shared by the unit tests of the evaluation, with
+// 3 input values, 3 output values, 3 hidden values, 3 base functions 
+// and 7 links, through the 2 first hidden values and directly from 
+// the 3rd input value to the 3rd output value
+static NeuraNet* UnitTestCreateNeuraNetSmall() {
+  NeuraNet* nn = NeuraNetCreate(3, 3, 3, 3, 7);
   NNBasesSet(nn, 0, 0.5);
   NNBasesSet(nn, 3, -0.5);
+  NNBasesSet(nn, 5, 0.2);
   NNBasesSet(nn, 8, -0.5);
-  short data[21] = {0,0,3, 1,0,3, 0,1,4, 0,3,6, 0,4,6, 0,4,7, -1,0,0};
+  short data[21] = {0,0,3, 1,0,3, 0,1,4, 2,3,6, 0,4,6, 1,4,7, 2,2,8};
   VecLong *links = VecLongCreate(21);
   for (int i = 21; i--;)
     VecSet(links, i, data[i]);
   NNSetLinks(nn, links);
   VecFree(&links);
-  VecFloat3D input = VecFloatCreateStatic3D();
-  VecFloat3D output = VecFloatCreateStatic3D();
-  VecFloat3D check = VecFloatCreateStatic3D();
-  VecFloat3D checkhidden = VecFloatCreateStatic3D();
-  NNPrintln(nn, stdout);
-  for (int i = -10; i <= 10; ++i) {
-    for (int j = -10; j <= 10; ++j) {
-      for (int k = -10; k <= 10; ++k) {
+  return nn;
+}
+
+void UnitTestNeuraNetSaveAsC() {
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  FILE* fd = fopen("./nn.c", "w");
+  if (NNSaveAsC(nn, fd) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSaveAsC failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  fclose(fd);
+  fd = fopen("./nn.c", "r");
+  char line[256];
+  bool hasEval = false;
+  int nbClamp = 0;
+  while (fgets(line, 256, fd) != NULL) {
+    if (strcmp(line, 
+      "void nn_eval(const float* input, float* output) {\n") == 0)
+      hasEval = true;
+    if (strstr(line, "NN_MIN(1.0f, NN_MAX(-1.0f,") != NULL)
+      ++nbClamp;
+  }
+  fclose(fd);
+  if (hasEval == false || nbClamp != 2) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSaveAsC failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetSaveAsC OK\n");
+}
+
+void UnitTestNeuraNetEvalPrintHiddenLinkSimpsonDiv() {
+  int nbIn = 3;
+  int nbOut = 3;
+  int nbHid = 3;
+  int nbBase = 3;
+  int nbLink = 7;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  // hidden[0] = tan(0.5*NN_THETA)*tan(-0.5*NN_THETA)*input[0]^2
+  // hidden[1] = tan(0.5*NN_THETA)*input[1]
+  // hidden[2] = 0
+  // output[0] = tan(0.5*NN_THETA)*hidden[0]+tan(0.5*NN_THETA)*hidden[1]
+  // output[1] = tan(0.5*NN_THETA)*hidden[1]
+  // output[2] = 0
+  NNBasesSet(nn, 0, 0.5);
+  NNBasesSet(nn, 3, -0.5);
+  NNBasesSet(nn, 8, -0.5);
+  short data[21] = {0,0,3, 1,0,3, 0,1,4, 0,3,6, 0,4,6, 0,4,7, -1,0,0};
+  VecLong *links = VecLongCreate(21);
+  for (int i = 21; i--;)
+    VecSet(links, i, data[i]);
+  NNSetLinks(nn, links);
+  VecFree(&links);
+  VecFloat3D input = VecFloatCreateStatic3D();
+  VecFloat3D output = VecFloatCreateStatic3D();
+  VecFloat3D check = VecFloatCreateStatic3D();
+  VecFloat3D checkhidden = VecFloatCreateStatic3D();
+  NNPrintln(nn, stdout);
+  for (int i = -10; i <= 10; ++i) {
+    for (int j = -10; j <= 10; ++j) {
+      for (int k = -10; k <= 10; ++k) {
         VecSet(&input, 0, 0.1 * (float)i); 
         VecSet(&input, 1, 0.1 * (float)j); 
         VecSet(&input, 2, 0.1 * (float)k);
@@ -428,6 +1216,1142 @@ void UnitTestNeuraNetEvalPrintHiddenLinkSimpsonDiv() {
   printf("UnitTestNeuraNetEvalPrintHiddenLinkSimpsonDiv OK\n");
 }
 
+void UnitTestNeuraNetEvalBatch() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  long nbSample = NN_BATCHTILE * 2 + 5;
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  VecFloat* inputsCol = VecFloatCreate(nbSample * nbIn);
+  for (long iSample = nbSample; iSample--;)
+    for (int iIn = nbIn; iIn--;) {
+      float v = 2.0 * (rnd() - 0.5);
+      VecSet(inputs, iSample * nbIn + iIn, v);
+      VecSet(inputsCol, iIn * nbSample + iSample, v);
+    }
+  VecFloat* outputs = VecFloatCreate(nbSample * nbOut);
+  VecFloat* outputsCol = VecFloatCreate(nbSample * nbOut);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  NNEvalKernel defaultKernel = NNGetEvalKernel();
+  if (NNIsEvalKernelSupported(defaultKernel) == false ||
+    NNIsEvalKernelSupported(NNEvalKernelScalar) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNIsEvalKernelSupported failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (int iKernel = 0; iKernel < NN_NBEVALKERNEL; ++iKernel) {
+    if (NNSetEvalKernel(iKernel) != NNIsEvalKernelSupported(iKernel)) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNSetEvalKernel failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    if (NNIsEvalKernelSupported(iKernel) == false)
+      continue;
+    if (NNGetEvalKernel() != (NNEvalKernel)iKernel) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNGetEvalKernel failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputs);
+    NNEvalBatch(nn, nbSample, inputsCol, NNBatchColMajor, outputsCol);
+    for (long iSample = nbSample; iSample--;) {
+      for (int iIn = nbIn; iIn--;)
+        VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+      NNEval(nn, input, output);
+      for (int iOut = nbOut; iOut--;) 
+        if (ISEQUALF(VecGet(output, iOut), 
+          VecGet(outputs, iSample * nbOut + iOut)) == false ||
+          ISEQUALF(VecGet(output, iOut), 
+          VecGet(outputsCol, iOut * nbSample + iSample)) == false) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNEvalBatch failed");
+          PBErrCatch(NeuraNetErr);
+        }
+    }
+  }
+  NNSetEvalKernel(defaultKernel);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&inputs);
+  VecFree(&inputsCol);
+  VecFree(&outputs);
+  VecFree(&outputsCol);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetEvalBatch OK\n");
+}
+
+void UnitTestNeuraNetPopulation() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 3;
+  int nbBase = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  // Create a population of candidates with random base functions, 
+  // the last tile of candidates being incomplete
+  long nbCandidate = NN_POPTILE + 3;
+  NNPopulation* pop = NNPopulationCreate(nn, nbCandidate);
+  VecFloat** bases = PBErrMalloc(NeuraNetErr, 
+    sizeof(VecFloat*) * nbCandidate);
+  for (long iCandidate = nbCandidate; iCandidate--;) {
+    bases[iCandidate] = VecFloatCreate(nbBase * NN_NBPARAMBASE);
+    for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+      VecSet(bases[iCandidate], iBase, 2.0 * (rnd() - 0.5));
+    NNPopulationSetBases(pop, iCandidate, bases[iCandidate]);
+  }
+  long nbSample = NN_BATCHTILE + 5;
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  VecFloat* inputsCol = VecFloatCreate(nbSample * nbIn);
+  for (long iSample = nbSample; iSample--;)
+    for (int iIn = nbIn; iIn--;) {
+      float v = 2.0 * (rnd() - 0.5);
+      VecSet(inputs, iSample * nbIn + iIn, v);
+      VecSet(inputsCol, iIn * nbSample + iSample, v);
+    }
+  VecFloat* outputs = VecFloatCreate(nbCandidate * nbSample * nbOut);
+  VecFloat* outputsCol = VecFloatCreate(nbCandidate * nbSample * nbOut);
+  VecFloat* outputsRef = VecFloatCreate(nbSample * nbOut);
+  // The results are the same as NNEvalBatch for each candidate and 
+  // each kernel
+  NNEvalKernel defaultKernel = NNGetEvalKernel();
+  for (int iKernel = 0; iKernel < NN_NBEVALKERNEL; ++iKernel) {
+    if (NNSetEvalKernel(iKernel) == false)
+      continue;
+    NNPopulationEval(pop, nbSample, inputs, NNBatchRowMajor, outputs);
+    NNPopulationEval(pop, nbSample, inputsCol, NNBatchColMajor, 
+      outputsCol);
+    for (long iCandidate = nbCandidate; iCandidate--;) {
+      NNSetBases(nn, bases[iCandidate]);
+      NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputsRef);
+      long shift = iCandidate * nbSample * nbOut;
+      for (long iSample = nbSample; iSample--;)
+        for (int iOut = nbOut; iOut--;) 
+          if (ISEQUALF(VecGet(outputsRef, iSample * nbOut + iOut), 
+            VecGet(outputs, shift + iSample * nbOut + iOut)) == false ||
+            ISEQUALF(VecGet(outputsRef, iSample * nbOut + iOut), 
+            VecGet(outputsCol, shift + iOut * nbSample + iSample)) == 
+            false) {
+            NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+            sprintf(NeuraNetErr->_msg, "NNPopulationEval failed");
+            PBErrCatch(NeuraNetErr);
+          }
+    }
+  }
+  NNSetEvalKernel(defaultKernel);
+  for (long iCandidate = nbCandidate; iCandidate--;)
+    VecFree(bases + iCandidate);
+  free(bases);
+  VecFree(&inputs);
+  VecFree(&inputsCol);
+  VecFree(&outputs);
+  VecFree(&outputsCol);
+  VecFree(&outputsRef);
+  NNPopulationFree(&pop);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetPopulation OK\n");
+}
+
+void UnitTestNeuraNetEvalDense() {
+  srandom(RANDOMSEED);
+  int nbIn = 5;
+  int nbOut = 2;
+  VecLong* hiddenLayers = VecLongCreate(2);
+  VecSet(hiddenLayers, 0, NN_DENSEBLOCK + 8);
+  VecSet(hiddenLayers, 1, 3);
+  NeuraNet* nn = NeuraNetCreateFullyConnected(nbIn, nbOut, hiddenLayers);
+  if (nn->_layers == NULL || VecGetDim(nn->_layers) != 4 ||
+    VecGet(nn->_layers, 0) != nbIn || 
+    VecGet(nn->_layers, 1) != NN_DENSEBLOCK + 8 ||
+    VecGet(nn->_layers, 2) != 3 || VecGet(nn->_layers, 3) != nbOut) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NeuraNetCreateFullyConnected failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iBase = NNGetNbMaxBases(nn) * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nn, iBase, 2.0 * (rnd() - 0.5));
+  // The same NeuraNet evaluated with its links
+  NeuraNet* nnLinks = NeuraNetCreate(nbIn, nbOut, NNGetNbMaxHidden(nn),
+    NNGetNbMaxBases(nn), NNGetNbMaxLinks(nn));
+  NNSetBases(nnLinks, NNBases(nn));
+  VecLong* links = VecClone(NNLinks(nn));
+  NNSetLinks(nnLinks, links);
+  if (nnLinks->_layers != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  long nbSample = NN_BATCHTILE + 7;
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  for (long iVal = nbSample * nbIn; iVal--;)
+    VecSet(inputs, iVal, 2.0 * (rnd() - 0.5));
+  VecFloat* outputs = VecFloatCreate(nbSample * nbOut);
+  VecFloat* outputsLinks = VecFloatCreate(nbSample * nbOut);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputLinks = VecFloatCreate(nbOut);
+  for (long iSample = nbSample; iSample--;) {
+    for (int iIn = nbIn; iIn--;)
+      VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+    NNEval(nn, input, output);
+    NNEval(nnLinks, input, outputLinks);
+    for (int iOut = nbOut; iOut--;) 
+      if (VecGet(output, iOut) != VecGet(outputLinks, iOut)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    for (long iHid = NNGetNbMaxHidden(nn); iHid--;)
+      if (NNGetHiddenValue(nn, iHid) != NNGetHiddenValue(nnLinks, iHid)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+  }
+  NNEvalKernel defaultKernel = NNGetEvalKernel();
+  for (int iKernel = 0; iKernel < NN_NBEVALKERNEL; ++iKernel) {
+    if (NNSetEvalKernel(iKernel) == false)
+      continue;
+    NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputs);
+    NNEvalBatch(nnLinks, nbSample, inputs, NNBatchRowMajor, 
+      outputsLinks);
+    for (long iVal = nbSample * nbOut; iVal--;)
+      if (VecGet(outputs, iVal) != VecGet(outputsLinks, iVal)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEvalBatch failed");
+        PBErrCatch(NeuraNetErr);
+      }
+  }
+  NNSetEvalKernel(defaultKernel);
+  // The layers are kept through JSON encoding
+  JSONNode* json = NNEncodeAsJSON(nn);
+  NeuraNet* nnLoaded = NULL;
+  if (!NNDecodeAsJSON(&nnLoaded, json) || nnLoaded->_layers == NULL ||
+    VecGetDim(nnLoaded->_layers) != VecGetDim(nn->_layers)) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNDecodeAsJSON failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iLayer = VecGetDim(nn->_layers); iLayer--;)
+    if (VecGet(nnLoaded->_layers, iLayer) != 
+      VecGet(nn->_layers, iLayer)) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNDecodeAsJSON failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  JSONFree(&json);
+  NeuraNetFree(&nnLoaded);
+  // The layers are kept as long as the links match them
+  for (long iLink = NNGetNbMaxLinks(nn); iLink-- > 1;) {
+    long jLink = (long)(rnd() * (float)(iLink + 1)) % (iLink + 1);
+    for (int iParam = NN_NBPARAMLINK; iParam--;) {
+      long v = VecGet(links, iLink * NN_NBPARAMLINK + iParam);
+      VecSet(links, iLink * NN_NBPARAMLINK + iParam, 
+        VecGet(links, jLink * NN_NBPARAMLINK + iParam));
+      VecSet(links, jLink * NN_NBPARAMLINK + iParam, v);
+    }
+  }
+  NNSetLinks(nn, links);
+  if (nn->_layers == NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecSet(links, 0, (VecGet(links, 0) + 1) % NNGetNbMaxBases(nn));
+  NNSetLinks(nn, links);
+  if (nn->_layers != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&links);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputLinks);
+  VecFree(&inputs);
+  VecFree(&outputs);
+  VecFree(&outputsLinks);
+  VecFree(&hiddenLayers);
+  NeuraNetFree(&nn);
+  NeuraNetFree(&nnLinks);
+  printf("UnitTestNeuraNetEvalDense OK\n");
+}
+
+void UnitTestNeuraNetPackedPlan() {
+  srandom(RANDOMSEED);
+  // The links of a fully connected NeuraNet use their own base 
+  // functions, they are implicit in the packed plan
+  VecLong* hiddenLayers = VecLongCreate(1);
+  VecSet(hiddenLayers, 0, 4);
+  NeuraNet* nn = NeuraNetCreateFullyConnected(3, 2, hiddenLayers);
+  if (nn->_packedWidth != sizeof(uint16_t) || 
+    nn->_nbPackedGroups != 20 || nn->_packedBases != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NeuraNetFree(&nn);
+  VecFree(&hiddenLayers);
+  // The links and their execution plan take 48 bytes per link with 
+  // 16 bits integers, the values taking at most 32 bytes each
+  nn = NeuraNetCreate(4, 3, 10, 100, 10000);
+  NNPlanCache* cache = NNPlanCacheCreate(nn, 1);
+  if (cache->_sizeLinks > 
+    48 * 10000 + 32 * (4 + 10 + 3) + 16 * NN_CACHELINE) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNArenaLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNPlanCacheFree(&cache);
+  NeuraNetFree(&nn);
+  // A NeuraNet whose ids don't fit in 16 bits, with links sharing 
+  // their input and output and base functions shared between links
+  int nbIn = 4;
+  int nbOut = 3;
+  long nbHid = UINT16_MAX;
+  long nbBase = 10;
+  long nbLink = 60;
+  nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nn, iBase, 2.0 * (rnd() - 0.5));
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  for (long iLink = nbLink; iLink--;) {
+    long in = (long)(rnd() * (float)(nbIn + 3)) % (nbIn + 3);
+    if (in >= nbIn)
+      in += nbHid - 3;
+    long out = nbIn + nbHid - 2 + 
+      (long)(rnd() * (float)(nbOut + 2)) % (nbOut + 2);
+    if (iLink % 5 == 1) {
+      in = VecGet(links, (iLink + 1) * NN_NBPARAMLINK + 1);
+      out = VecGet(links, (iLink + 1) * NN_NBPARAMLINK + 2);
+    }
+    VecSet(links, iLink * NN_NBPARAMLINK, iLink % nbBase);
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, in);
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, out);
+  }
+  NNSetLinks(nn, links);
+  if (nn->_packedWidth != sizeof(uint32_t) || 
+    nn->_packedBases == NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNUpdatePlan failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // NNEval gives the same results as the execution plan evaluated by
+  // NNEvalBatch with the scalar kernel
+  long nbSample = 10;
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  for (long iVal = nbSample * nbIn; iVal--;)
+    VecSet(inputs, iVal, 2.0 * (rnd() - 0.5));
+  VecFloat* outputs = VecFloatCreate(nbSample * nbOut);
+  NNEvalKernel defaultKernel = NNGetEvalKernel();
+  NNSetEvalKernel(NNEvalKernelScalar);
+  NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputs);
+  NNSetEvalKernel(defaultKernel);
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  for (long iSample = nbSample; iSample--;) {
+    for (int iIn = nbIn; iIn--;)
+      VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+    NNEval(nn, input, output);
+    for (int iOut = nbOut; iOut--;) 
+      if (VecGet(output, iOut) != 
+        VecGet(outputs, iSample * nbOut + iOut)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+  }
+  VecFree(&links);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&inputs);
+  VecFree(&outputs);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetPackedPlan OK\n");
+}
+
+void UnitTestNeuraNetLinkOrder() {
+  srandom(RANDOMSEED);
+  int nbIn = 4;
+  int nbOut = 3;
+  long nbHid = 20;
+  long nbBase = 40;
+  long nbLink = 120;
+  NeuraNet* nn = NeuraNetCreate(nbIn, nbOut, nbHid, nbBase, nbLink);
+  if (NNGetLinkOrder(nn) != NNLinkOrderInputMajor) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNGetLinkOrder failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iBase = nbBase * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nn, iBase, 2.0 * (rnd() - 0.5));
+  // Random links, some of them looping on their output or sharing 
+  // their input and output with the previous one
+  VecLong* links = VecLongCreate(nbLink * NN_NBPARAMLINK);
+  for (long iLink = nbLink; iLink--;) {
+    long in = (long)(rnd() * (float)(nbIn + nbHid)) % (nbIn + nbHid);
+    long out = nbIn + 
+      (long)(rnd() * (float)(nbHid + nbOut)) % (nbHid + nbOut);
+    if (iLink % 7 == 3)
+      in = out;
+    if (iLink % 5 == 1) {
+      in = VecGet(links, (iLink + 1) * NN_NBPARAMLINK + 1);
+      out = VecGet(links, (iLink + 1) * NN_NBPARAMLINK + 2);
+    }
+    VecSet(links, iLink * NN_NBPARAMLINK, iLink % nbBase);
+    VecSet(links, iLink * NN_NBPARAMLINK + 1, in);
+    VecSet(links, iLink * NN_NBPARAMLINK + 2, out);
+  }
+  NNSetLinks(nn, links);
+  // Evaluate the samples in input major order
+  long nbSample = 10;
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  VecFloat* outputs = VecFloatCreate(nbSample * (nbHid + nbOut));
+  for (long iVal = nbSample * nbIn; iVal--;)
+    VecSet(inputs, iVal, 2.0 * (rnd() - 0.5));
+  for (long iSample = nbSample; iSample--;) {
+    for (int iIn = nbIn; iIn--;)
+      VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+    NNEval(nn, input, output);
+    for (long iHid = nbHid; iHid--;)
+      VecSet(outputs, iSample * (nbHid + nbOut) + iHid, 
+        VecGet(NNHiddenValues(nn), iHid));
+    for (int iOut = nbOut; iOut--;)
+      VecSet(outputs, iSample * (nbHid + nbOut) + nbHid + iOut, 
+        VecGet(output, iOut));
+  }
+  // Switch to output major order, the groups of the plan per 
+  // destination are sorted on their output
+  NNSetLinkOrder(nn, NNLinkOrderOutputMajor);
+  if (NNGetLinkOrder(nn) != NNLinkOrderOutputMajor) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNGetLinkOrder failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iGroup = 1; iGroup < nn->_nbPackedGroups; ++iGroup) {
+    const uint16_t* plan = nn->_dstPlan;
+    if (plan[3 * iGroup + 1] < plan[3 * (iGroup - 1) + 1]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNSetLinkOrder failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  // The order is kept when the links are modified, and the hidden and
+  // output values are exactly the same as in input major order
+  NNSetLinks(nn, links);
+  for (long iSample = nbSample; iSample--;) {
+    for (int iIn = nbIn; iIn--;)
+      VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+    NNEval(nn, input, output);
+    for (long iHid = nbHid; iHid--;)
+      if (VecGet(NNHiddenValues(nn), iHid) != 
+        VecGet(outputs, iSample * (nbHid + nbOut) + iHid)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    for (int iOut = nbOut; iOut--;)
+      if (VecGet(output, iOut) != 
+        VecGet(outputs, iSample * (nbHid + nbOut) + nbHid + iOut)) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+  }
+  VecFree(&links);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&inputs);
+  VecFree(&outputs);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetLinkOrder OK\n");
+}
+
+void UnitTestNeuraNetEvalCtx() {
+  int nbIn = 3;
+  int nbOut = 3;
+  int nbHid = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  NNEvalContext* ctx = NNEvalContextCreate(nn);
+  if (ctx == NULL || 
+    VecGetDim(NNEvalContextHiddenValues(ctx)) != nbHid) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalContextCreate failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputCtx = VecFloatCreate(nbOut);
+  VecSet(input, 0, 0.5);
+  VecSet(input, 1, -0.5);
+  VecSet(input, 2, 0.25);
+  NNEval(nn, input, output);
+  VecFloat* hidVal = VecClone(NNHiddenValues(nn));
+  VecSet(input, 0, -0.25);
+  VecSet(input, 2, 0.75);
+  NNEvalCtx(nn, ctx, input, outputCtx);
+  if (VecIsEqual(hidVal, NNHiddenValues(nn)) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalCtx failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNEval(nn, input, output);
+  if (VecIsEqual(output, outputCtx) == false ||
+    VecIsEqual(NNHiddenValues(nn), 
+      NNEvalContextHiddenValues(ctx)) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalCtx failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFloat* inputs = VecFloatCreate(2 * nbIn);
+  VecFloat* outputs = VecFloatCreate(2 * nbOut);
+  for (int iIn = nbIn; iIn--;)
+    VecSet(inputs, nbIn + iIn, VecGet(input, iIn));
+  NNEvalBatchCtx(nn, ctx, 2, inputs, NNBatchRowMajor, outputs);
+  for (int iOut = nbOut; iOut--;) 
+    if (ISEQUALF(VecGet(output, iOut), 
+      VecGet(outputs, nbOut + iOut)) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNEvalBatchCtx failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  NNEvalContextFree(&ctx);
+  if (ctx != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalContextFree failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&hidVal);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputCtx);
+  VecFree(&inputs);
+  VecFree(&outputs);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetEvalCtx OK\n");
+}
+
+void UnitTestNeuraNetEvalParallel() {
+  srandom(RANDOMSEED);
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  if (NNHasPlanPerDst(nn) == true || nn->_dstArena != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNHasPlanPerDst failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNSetPlanPerDst(nn, true);
+  if (NNHasPlanPerDst(nn) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetPlanPerDst failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (NNGetNbLevel(nn) != 2) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNGetNbLevel failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  long checkLevelStart[3] = {0, 3, 5};
+  long checkLevelDst[5] = {0, 1, 5, 3, 4};
+  for (int i = 3; i--;)
+    if (VecGet(nn->_levelStart, i) != checkLevelStart[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdateLevels failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  for (int i = 5; i--;)
+    if (VecGet(nn->_levelDst, i) != checkLevelDst[i]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNUpdateLevels failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  VecLong* hiddenLayers = VecLongCreate(2);
+  VecSet(hiddenLayers, 0, 64);
+  VecSet(hiddenLayers, 1, 48);
+  NeuraNet* nnFC = NeuraNetCreateFullyConnected(40, 20, hiddenLayers);
+  VecFree(&hiddenLayers);
+  for (long iBase = NNGetNbMaxBases(nnFC) * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nnFC, iBase, 2.0 * (rnd() - 0.5));
+  if (NNGetNbLevel(nnFC) != 3) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNGetNbLevel failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNSetPlanPerDst(nnFC, true);
+  NeuraNet* nets[2] = {nn, nnFC};
+  for (int nbThread = 1; nbThread <= 4; ++nbThread) {
+    NNThreadTeam* team = NNThreadTeamCreate(nbThread);
+    if (NNThreadTeamGetNbThread(team) != nbThread) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNThreadTeamCreate failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    for (int iNet = 2; iNet--;) {
+      NeuraNet* net = nets[iNet];
+      NNEvalContext* ctx = NNEvalContextCreate(net);
+      VecFloat* input = VecFloatCreate(NNGetNbInput(net));
+      VecFloat* output = VecFloatCreate(NNGetNbOutput(net));
+      VecFloat* outputPar = VecFloatCreate(NNGetNbOutput(net));
+      for (int iSample = 10; iSample--;) {
+        for (long iIn = NNGetNbInput(net); iIn--;)
+          VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+        NNEval(net, input, output);
+        NNEvalParallel(net, ctx, team, input, outputPar);
+        if (VecIsEqual(output, outputPar) == false ||
+          (NNGetNbMaxHidden(net) > 0 && VecIsEqual(NNHiddenValues(net), 
+            NNEvalContextHiddenValues(ctx)) == false)) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNEvalParallel failed");
+          PBErrCatch(NeuraNetErr);
+        }
+      }
+      VecFree(&input);
+      VecFree(&output);
+      VecFree(&outputPar);
+      NNEvalContextFree(&ctx);
+    }
+    NNThreadTeamFree(&team);
+    if (team != NULL) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNThreadTeamFree failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  NNSetPlanPerDst(nn, false);
+  if (NNHasPlanPerDst(nn) == true || nn->_dstArena != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetPlanPerDst failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NeuraNetFree(&nn);
+  NeuraNetFree(&nnFC);
+  printf("UnitTestNeuraNetEvalParallel OK\n");
+}
+
+void UnitTestNeuraNetEvalSparse() {
+  int nbIn = 3;
+  int nbOut = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputSparse = VecFloatCreate(nbOut);
+  NNSetPlanPerDst(nn, true);
+  NNEvalState* state = NNEvalStateCreate(nn);
+  NNEval(nn, input, output);
+  if (state == NULL || 
+    VecIsEqual(NNEvalStateInput(state), input) == false ||
+    VecIsEqual(NNEvalStateHiddenValues(state), 
+      NNHiddenValues(nn)) == false ||
+    VecIsEqual(state->_output, output) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalStateCreate failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  long iInputs[2][2] = {{0, 2}, {1, 0}};
+  float values[2][2] = {{0.5, -0.25}, {0.75, 0.0}};
+  long nbInputs[2] = {2, 1};
+  for (int iTest = 0; iTest < 2; ++iTest) {
+    VecLong* iSparse = VecLongCreate(nbInputs[iTest]);
+    VecFloat* valSparse = VecFloatCreate(nbInputs[iTest]);
+    VecSetNull(input);
+    for (int i = nbInputs[iTest]; i--;) {
+      VecSet(iSparse, i, iInputs[iTest][i]);
+      VecSet(valSparse, i, values[iTest][i]);
+      VecSet(input, iInputs[iTest][i], values[iTest][i]);
+    }
+    NNEvalSparse(nn, state, iSparse, valSparse, outputSparse);
+    NNEval(nn, input, output);
+    if (VecIsEqual(NNEvalStateInput(state), input) == false ||
+      VecIsEqual(NNEvalStateHiddenValues(state), 
+        NNHiddenValues(nn)) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNEvalSparse failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    for (int iOut = nbOut; iOut--;) 
+      if (ISEQUALF(VecGet(output, iOut), 
+        VecGet(outputSparse, iOut)) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEvalSparse failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    VecFree(&iSparse);
+    VecFree(&valSparse);
+  }
+  NNEvalStateFree(&state);
+  if (state != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalStateFree failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputSparse);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetEvalSparse OK\n");
+}
+
+void UnitTestNeuraNetEvalDelta() {
+  int nbIn = 3;
+  int nbOut = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputDelta = VecFloatCreate(nbOut);
+  NNSetPlanPerDst(nn, true);
+  NNEvalState* state = NNEvalStateCreate(nn);
+  long iInputs[4][2] = {{0, 2}, {1, 0}, {2, 1}, {0, 1}};
+  float values[4][2] = {{0.5, -0.25}, {0.75, 0.0}, {1.0, -0.5}, 
+    {-0.5, 0.25}};
+  long nbInputs[4] = {2, 1, 2, 2};
+  for (int iTest = 0; iTest < 4; ++iTest) {
+    VecLong* iDelta = VecLongCreate(nbInputs[iTest]);
+    VecFloat* valDelta = VecFloatCreate(nbInputs[iTest]);
+    for (int i = nbInputs[iTest]; i--;) {
+      VecSet(iDelta, i, iInputs[iTest][i]);
+      VecSet(valDelta, i, values[iTest][i]);
+      VecSet(input, iInputs[iTest][i], values[iTest][i]);
+    }
+    // Mix with NNEvalSparse to check the reference evaluation is 
+    // correctly updated
+    if (iTest == 2) {
+      VecSetNull(input);
+      for (int i = nbInputs[iTest]; i--;)
+        VecSet(input, iInputs[iTest][i], values[iTest][i]);
+      NNEvalSparse(nn, state, iDelta, valDelta, outputDelta);
+    } else {
+      NNEvalDelta(nn, state, iDelta, valDelta, outputDelta);
+    }
+    NNEval(nn, input, output);
+    if (VecIsEqual(NNEvalStateInput(state), input) == false ||
+      VecIsEqual(NNEvalStateHiddenValues(state), 
+        NNHiddenValues(nn)) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNEvalDelta failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    for (int iOut = nbOut; iOut--;) 
+      if (ISEQUALF(VecGet(output, iOut), 
+        VecGet(outputDelta, iOut)) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEvalDelta failed");
+        PBErrCatch(NeuraNetErr);
+      }
+    VecFree(&iDelta);
+    VecFree(&valDelta);
+  }
+  NNEvalStateFree(&state);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputDelta);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetEvalDelta OK\n");
+}
+
+void UnitTestNeuraNetQuantized() {
+  srandom(RANDOMSEED);
+  int nbIn = 3;
+  int nbOut = 3;
+  NeuraNet* nn = UnitTestCreateNeuraNetSmall();
+  NNQuantized* q = NNQuantize(nn);
+  if (q == NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNQuantize failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  int nbSample = 20;
+  VecFloat* inputs = VecFloatCreate(nbSample * nbIn);
+  for (long i = nbSample * nbIn; i--;)
+    VecSet(inputs, i, 2.0 * (rnd() - 0.5));
+  VecFloat* input = VecFloatCreate(nbIn);
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputQ = VecFloatCreate(nbOut);
+  NNQuantizedContext* ctx = NNQuantizedContextCreate(q);
+  float maxDev = 0.0;
+  for (int iSample = 0; iSample < nbSample; ++iSample) {
+    for (int iIn = nbIn; iIn--;)
+      VecSet(input, iIn, VecGet(inputs, iSample * nbIn + iIn));
+    NNEval(nn, input, output);
+    NNQuantizedEval(q, ctx, input, outputQ);
+    for (int iOut = nbOut; iOut--;) {
+      float dev = fabs(VecGet(output, iOut) - VecGet(outputQ, iOut));
+      if (dev > 0.001) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNQuantizedEval failed");
+        PBErrCatch(NeuraNetErr);
+      }
+      if (dev > maxDev)
+        maxDev = dev;
+    }
+  }
+  if (ISEQUALF(NNQuantizedGetMaxDeviation(q, nn, nbSample, inputs), 
+    maxDev) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNQuantizedGetMaxDeviation failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNQuantizedContextFree(&ctx);
+  if (ctx != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNQuantizedContextFree failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNQuantizedFree(&q);
+  if (q != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNQuantizedFree failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&inputs);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputQ);
+  NeuraNetFree(&nn);
+  printf("UnitTestNeuraNetQuantized OK\n");
+}
+
+void UnitTestNeuraNetEvalConv() {
+  srandom(RANDOMSEED);
+  int nbOut = 3;
+  int thickConv = 2;
+  int depthConv = 2;
+  VecShort* dimIn = VecShortCreate(2);
+  VecSet(dimIn, 0, 6);
+  VecSet(dimIn, 1, 5);
+  VecShort* dimCell = VecShortCreate(2);
+  VecSet(dimCell, 0, 3);
+  VecSet(dimCell, 1, 2);
+  NeuraNet* nn = NeuraNetCreateConvolution(dimIn, nbOut, dimCell, 
+    depthConv, thickConv);
+  if (NNConv(nn) == NULL ||
+    VecIsEqual(NNConv(nn)->_dimIn, dimIn) == false ||
+    VecIsEqual(NNConv(nn)->_dimCell, dimCell) == false ||
+    NNConv(nn)->_depthConv != depthConv ||
+    NNConv(nn)->_thickConv != thickConv) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NeuraNetCreateConvolution failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iBase = NNGetNbMaxBases(nn) * NN_NBPARAMBASE; iBase--;)
+    NNBasesSet(nn, iBase, 2.0 * (rnd() - 0.5));
+  // Same NeuraNet evaluated with its links
+  NeuraNet* nnLink = NeuraNetCreateConvolution(dimIn, nbOut, dimCell, 
+    depthConv, thickConv);
+  NNSetBases(nnLink, NNBases(nn));
+  VecLong* links = VecClone(NNLinks(nnLink));
+  NNSetLinks(nnLink, links);
+  VecFree(&links);
+  if (NNConv(nnLink) != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSetLinks failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFloat* input = VecFloatCreate(NNGetNbInput(nn));
+  VecFloat* output = VecFloatCreate(nbOut);
+  VecFloat* outputLink = VecFloatCreate(nbOut);
+  for (int iTest = 0; iTest < 10; ++iTest) {
+    for (long iIn = NNGetNbInput(nn); iIn--;)
+      VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+    NNEval(nn, input, output);
+    NNEval(nnLink, input, outputLink);
+    if (VecIsEqual(output, outputLink) == false ||
+      VecIsEqual(NNHiddenValues(nn), NNHiddenValues(nnLink)) == false) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNEval failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  if (nn->_links != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEval failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  // The batch, parallel and per difference evaluations don't expand 
+  // the implicit links
+  int nbSample = 5;
+  VecFloat* inputs = VecFloatCreate(nbSample * NNGetNbInput(nn));
+  VecFloat* outputs = VecFloatCreate(nbSample * nbOut);
+  for (long i = VecGetDim(inputs); i--;)
+    VecSet(inputs, i, 2.0 * (rnd() - 0.5));
+  NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputs);
+  for (int iSample = 0; iSample < nbSample; ++iSample) {
+    for (long iIn = NNGetNbInput(nn); iIn--;)
+      VecSet(input, iIn, 
+        VecGet(inputs, iSample * NNGetNbInput(nn) + iIn));
+    NNEval(nnLink, input, outputLink);
+    for (int iOut = nbOut; iOut--;)
+      if (ISEQUALF(VecGet(outputs, iSample * nbOut + iOut), 
+        VecGet(outputLink, iOut)) == false) {
+        NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(NeuraNetErr->_msg, "NNEvalBatch failed");
+        PBErrCatch(NeuraNetErr);
+      }
+  }
+  NNEvalContext* ctx = NNEvalContextCreate(nn);
+  NNThreadTeam* team = NNThreadTeamCreate(2);
+  NNEvalParallel(nn, ctx, team, input, output);
+  if (VecIsEqual(output, outputLink) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalParallel failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNEvalState* state = NNEvalStateCreate(nn);
+  VecLong* iInputs = VecLongCreate(NNGetNbInput(nn));
+  for (long iIn = NNGetNbInput(nn); iIn--;)
+    VecSet(iInputs, iIn, iIn);
+  NNEvalDelta(nn, state, iInputs, input, output);
+  if (VecIsEqual(output, outputLink) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalDelta failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nn->_links != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNEvalBatch failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNEvalStateFree(&state);
+  NNThreadTeamFree(&team);
+  NNEvalContextFree(&ctx);
+  VecFree(&iInputs);
+  VecFree(&inputs);
+  VecFree(&outputs);
+  // Quantizing and getting the mutability work on a clone with 
+  // expanded links and leave the links implicit
+  NNQuantized* q = NNQuantize(nn);
+  VecFloat* accuracy = VecFloatCreate(NNGetNbOutput(nn));
+  VecFloat* mutability = NNGetMutabilityLinks(nn, accuracy);
+  if (q == NULL || mutability == NULL || 
+    VecGetDim(mutability) != NNGetNbMaxLinks(nn) * NN_NBPARAMLINK || 
+    nn->_links != NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNQuantize failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNQuantizedFree(&q);
+  VecFree(&accuracy);
+  VecFree(&mutability);
+  // The implicit links are saved as the geometry of the convolution
+  FILE* fd = fopen("./nnConv.txt", "w");
+  if (NNSave(nn, fd, false) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNSave failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  fclose(fd);
+  NeuraNet* nnLoad = NULL;
+  fd = fopen("./nnConv.txt", "r");
+  if (NNLoad(&nnLoad, fd) == false ||
+    nnLoad->_links != NULL || NNConv(nnLoad) == NULL) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNLoad failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  fclose(fd);
+  NNEval(nn, input, output);
+  NNEval(nnLoad, input, outputLink);
+  if (VecIsEqual(output, outputLink) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNLoad failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&outputLink);
+  NeuraNetFree(&nn);
+  NeuraNetFree(&nnLink);
+  NeuraNetFree(&nnLoad);
+  VecFree(&dimIn);
+  VecFree(&dimCell);
+  printf("UnitTestNeuraNetEvalConv OK\n");
+}
+
+void UnitTestNeuraNetConvPooling() {
+  srandom(RANDOMSEED);
+  // 1D input of 8 values, cell of 1 value, one level with a pooling
+  // window of 4 values, the convolution copies its input
+  VecShort* dimIn = VecShortCreate(1);
+  VecSet(dimIn, 0, 8);
+  VecShort* dimCell = VecShortCreate(1);
+  VecSet(dimCell, 0, 1);
+  VecShort* stride = VecShortCreate(1);
+  VecSet(stride, 0, 1);
+  VecShort* poolKind = VecShortCreate(1);
+  VecShort* poolSize = VecShortCreate(1);
+  VecSet(poolSize, 0, 4);
+  VecFloat* input = VecFloatCreate(8);
+  VecFloat* output = VecFloatCreate(1);
+  for (int iKind = NNPoolAvg; iKind <= NNPoolMax; ++iKind) {
+    VecSet(poolKind, 0, iKind);
+    NeuraNet* nn = NeuraNetCreateConvolutionWithPooling(dimIn, 1, 
+      dimCell, 1, 1, stride, poolKind, poolSize);
+    // 8 values of the convolution, 2 pooled values and their 
+    // intermediate values for the maximum
+    long nbHid = (iKind == NNPoolAvg ? 10 : 20);
+    if (NNGetNbMaxHidden(nn) != nbHid ||
+      NNGetNbMaxBases(nn) != 1 + 
+      (iKind == NNPoolAvg ? NN_NBBASEPOOLAVG : NN_NBBASEPOOLMAX) + 2 ||
+      NNGetNbMaxLinks(nn) != 8 + (iKind == NNPoolAvg ? 8 : 24) + 2) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, 
+        "NeuraNetCreateConvolutionWithPooling failed");
+      PBErrCatch(NeuraNetErr);
+    }
+    NNBasesSet(nn, 0, atan(1.0) / NN_THETA);
+    for (int iTest = 0; iTest < 10; ++iTest) {
+      for (long iIn = 8; iIn--;)
+        VecSet(input, iIn, 2.0 * (rnd() - 0.5));
+      NNEval(nn, input, output);
+      for (int iPool = 0; iPool < 2; ++iPool) {
+        float avg = 0.0;
+        float max = -1.0;
+        for (int iIn = 0; iIn < 4; ++iIn) {
+          float v = VecGet(input, iPool * 4 + iIn);
+          avg += 0.25 * v;
+          if (v > max)
+            max = v;
+        }
+        float pool = NNGetHiddenValue(nn, nbHid - 2 + iPool);
+        if (fabs(pool - (iKind == NNPoolAvg ? avg : max)) > 1e-5) {
+          NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(NeuraNetErr->_msg, "NNEval failed");
+          PBErrCatch(NeuraNetErr);
+        }
+      }
+    }
+    NeuraNetFree(&nn);
+  }
+  // A stride 2 with a cell of 3 values gives 3 values out of 7
+  VecSet(dimIn, 0, 7);
+  VecSet(dimCell, 0, 3);
+  VecSet(stride, 0, 2);
+  VecSet(poolKind, 0, NNPoolNone);
+  NeuraNet* nn = NeuraNetCreateConvolutionWithPooling(dimIn, 1, 
+    dimCell, 1, 1, stride, poolKind, poolSize);
+  if (NNGetNbMaxHidden(nn) != 3 || NNGetNbMaxLinks(nn) != 12) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, 
+      "NeuraNetCreateConvolutionWithPooling failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  long check[36] = {
+    0,0,7, 1,1,7, 2,2,7, 0,2,8, 1,3,8, 2,4,8, 0,4,9, 1,5,9, 2,6,9,
+    3,7,10, 4,8,10, 5,9,10
+    };
+  for (int iCheck = 36; iCheck--;) {
+    if (VecGet(NNLinks(nn), iCheck) != check[iCheck]) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, 
+        "NeuraNetCreateConvolutionWithPooling failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  NeuraNetFree(&nn);
+  // A stride 2 with a cell of 3 values fits in 7 values but not in 2 
+  // values, at the first level or at the second level after a pooling
+  // window of 2 values
+  NNConvGeometry* conv = NNConvGeometryCreate(dimIn, dimCell, 1, 1, 
+    stride, poolKind, poolSize);
+  if (NNConvGeometryIsValid(conv) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNConvGeometryIsValid failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNConvGeometryFree(&conv);
+  VecSet(dimIn, 0, 2);
+  conv = NNConvGeometryCreate(dimIn, dimCell, 1, 1, stride, poolKind, 
+    poolSize);
+  if (NNConvGeometryIsValid(conv) == true) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNConvGeometryIsValid failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNConvGeometryFree(&conv);
+  conv = NNConvGeometryCreate(dimIn, dimCell, 0, 1, NULL, NULL, NULL);
+  if (NNConvGeometryIsValid(conv) == true) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNConvGeometryIsValid failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNConvGeometryFree(&conv);
+  VecShort* strideTwo = VecShortCreate(2);
+  VecShort* poolKindTwo = VecShortCreate(2);
+  VecShort* poolSizeTwo = VecShortCreate(2);
+  for (int iConv = 2; iConv--;) {
+    VecSet(strideTwo, iConv, 2);
+    VecSet(poolKindTwo, iConv, NNPoolAvg);
+    VecSet(poolSizeTwo, iConv, 2 - iConv);
+  }
+  VecSet(dimIn, 0, 7);
+  VecSet(dimCell, 0, 1);
+  conv = NNConvGeometryCreate(dimIn, dimCell, 2, 1, strideTwo, 
+    poolKindTwo, poolSizeTwo);
+  if (NNConvGeometryIsValid(conv) == false) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNConvGeometryIsValid failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNConvGeometryFree(&conv);
+  VecSet(dimIn, 0, 9);
+  VecSet(dimCell, 0, 3);
+  conv = NNConvGeometryCreate(dimIn, dimCell, 2, 1, strideTwo, 
+    poolKindTwo, poolSizeTwo);
+  if (NNConvGeometryIsValid(conv) == true) {
+    NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(NeuraNetErr->_msg, "NNConvGeometryIsValid failed");
+    PBErrCatch(NeuraNetErr);
+  }
+  NNConvGeometryFree(&conv);
+  VecFree(&strideTwo);
+  VecFree(&poolKindTwo);
+  VecFree(&poolSizeTwo);
+  // The links of a 2D NeuraNet with 2 levels, 2 convolutions in
+  // parallel, stride and pooling are generated in the order of
+  // NNSetLinks
+  VecShort* dimIn2D = VecShortCreate(2);
+  VecSet(dimIn2D, 0, 9);
+  VecSet(dimIn2D, 1, 8);
+  VecShort* dimCell2D = VecShortCreate(2);
+  VecSet(dimCell2D, 0, 2);
+  VecSet(dimCell2D, 1, 3);
+  VecShort* stride2D = VecShortCreate(2);
+  VecSet(stride2D, 0, 1);
+  VecSet(stride2D, 1, 2);
+  VecShort* poolKind2D = VecShortCreate(2);
+  VecSet(poolKind2D, 0, NNPoolMax);
+  VecSet(poolKind2D, 1, NNPoolAvg);
+  VecShort* poolSize2D = VecShortCreate(2);
+  VecSet(poolSize2D, 0, 2);
+  VecSet(poolSize2D, 1, 1);
+  nn = NeuraNetCreateConvolutionWithPooling(dimIn2D, 2, dimCell2D, 2, 2,
+    stride2D, poolKind2D, poolSize2D);
+  VecLong* links = VecClone(NNLinks(nn));
+  NNSetLinks(nn, links);
+  for (long iLink = NNGetNbMaxLinks(nn) * NN_NBPARAMLINK; iLink--;) {
+    if (VecGet(NNLinks(nn), iLink) != VecGet(links, iLink)) {
+      NeuraNetErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(NeuraNetErr->_msg, "NNExpandLinks failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  VecFree(&links);
+  NeuraNetFree(&nn);
+  VecFree(&dimIn2D);
+  VecFree(&dimCell2D);
+  VecFree(&stride2D);
+  VecFree(&poolKind2D);
+  VecFree(&poolSize2D);
+  VecFree(&input);
+  VecFree(&output);
+  VecFree(&dimIn);
+  VecFree(&dimCell);
+  VecFree(&stride);
+  VecFree(&poolKind);
+  VecFree(&poolSize);
+  printf("UnitTestNeuraNetConvPooling OK\n");
+}
+
 #ifdef GENALG_H
 float evaluate(const NeuraNet* const nn) {
   VecFloat3D input = VecFloatCreateStatic3D();
@@ -508,8 +2432,27 @@ void UnitTestNeuraNet() {
   UnitTestNeuraNetCreateFullyConnected();
   UnitTestNeuraNetCreateConvolution();
   UnitTestNeuraNetGetSet();
+  UnitTestNeuraNetSetLinksScale();
+  UnitTestNeuraNetUpdateLinks();
+  UnitTestNeuraNetBind();
+  UnitTestNeuraNetClone();
+  UnitTestNeuraNetPlanCache();
   UnitTestNeuraNetSaveLoadPrune();
+  UnitTestNeuraNetPrune();
+  UnitTestNeuraNetSaveAsC();
   UnitTestNeuraNetEvalPrintHiddenLinkSimpsonDiv();
+  UnitTestNeuraNetEvalBatch();
+  UnitTestNeuraNetPopulation();
+  UnitTestNeuraNetEvalDense();
+  UnitTestNeuraNetPackedPlan();
+  UnitTestNeuraNetLinkOrder();
+  UnitTestNeuraNetEvalCtx();
+  UnitTestNeuraNetEvalParallel();
+  UnitTestNeuraNetEvalSparse();
+  UnitTestNeuraNetEvalDelta();
+  UnitTestNeuraNetQuantized();
+  UnitTestNeuraNetEvalConv();
+  UnitTestNeuraNetConvPooling();
 #ifdef GENALG_H
   UnitTestNeuraNetGA();
 #endif
@@ -23,10 +23,59 @@ float NNBaseFun(const float* const param, const float x) {
   return tan(param[0] * NN_THETA) * (x + param[1]) + param[2];
 }
 
+// Calculate the linear form of the base function of parameters 
+// 'param', such as NNBaseFun(param,x)=slope*x+offset, and memorize it
+// in 'slope' and 'offset'
+// slope=tan(param[0]*NN_THETA), offset=slope*param[1]+param[2]
+#if BUILDMODE != 0
+static inline
+#endif
+void NNBaseFunCoeff(const float* const param, float* const slope, 
+  float* const offset) {
+#if BUILDMODE == 0
+  if (param == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'param' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (slope == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'slope' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (offset == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'offset' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Calculate the slope and offset in double precision as NNBaseFun
+  double s = tan(param[0] * NN_THETA);
+  *slope = s;
+  *offset = s * param[1] + param[2];
+}
+
 // ----- NeuraNet
 
 // ================ Functions implementation ====================
 
+// Get the geometry of the convolution layers of the NeuraNet 'that'
+// Return null if the NeuraNet is not evaluated as a convolution 
+// network (see NeuraNet::_conv)
+#if BUILDMODE != 0
+static inline
+#endif
+const NNConvGeometry* NNConv(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_conv;
+}
+
 // Get the nb of input values of the NeuraNet 'that'
 #if BUILDMODE != 0
 static inline
@@ -160,9 +209,46 @@ const VecLong* NNLinks(const NeuraNet* const that) {
     PBErrCatch(NeuraNetErr);
   }
 #endif
+  // Expand the links if they are implicit
+  NNExpandLinks(that);
   return that->_links;
 }
 
+// Get the order of the groups of links evaluated by NNEval for the 
+// NeuraNet 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+NNLinkOrder NNGetLinkOrder(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_linkOrder;
+}
+
+// Return true if the execution plan per destination of the NeuraNet
+// 'that' is built and usable (see NNSetPlanPerDst), else false
+#if BUILDMODE != 0
+static inline
+#endif
+bool NNHasPlanPerDst(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // The plan per destination is usable only if it has been requested,
+  // the links are explicit and the levels are available
+  return (that->_dstArena != NULL && that->_links != NULL &&
+    VecGet(that->_levelStart, 0) != -1);
+}
+
 // Get the hidden values of the NeuraNet 'that'
 #if BUILDMODE != 0
 static inline
@@ -228,6 +314,9 @@ void NNSetBases(NeuraNet* const that, const VecFloat* const bases) {
   }
 #endif
   VecCopy(that->_bases, bases);
+  // Update the cached linear form of the base functions
+  for (long iBase = NNGetNbMaxBases(that); iBase--;)
+    NNUpdateBaseCoeff(that, iBase);
 }
 // Set the 'iBase'-th parameter of the base functions of the NeuraNet 
 // 'that' to 'base'
@@ -251,6 +340,34 @@ void NNBasesSet(NeuraNet* const that, const long iBase,
   }
 #endif
   VecSet(that->_bases, iBase, base);
+  // Update the cached linear form of the modified base function
+  NNUpdateBaseCoeff(that, iBase / NN_NBPARAMBASE);
+}
+
+// Update the cached slope and offset of the 'iBase'-th base function 
+// of the NeuraNet 'that' according to its parameters
+// slope=tan(param[0]*NN_THETA), offset=slope*param[1]+param[2]
+#if BUILDMODE != 0
+static inline
+#endif
+void NNUpdateBaseCoeff(const NeuraNet* const that, const long iBase) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (iBase < 0 || iBase >= that->_nbMaxBases) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'iBase' is invalid (0<=%ld<%ld)", iBase, that->_nbMaxBases);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Update the cache
+  float* coeff = that->_basesCoeff->_val + iBase * NN_NBCOEFFBASE;
+  NNBaseFunCoeff(that->_bases->_val + iBase * NN_NBPARAMBASE, coeff, 
+    coeff + 1);
 }
 
 // Get the number of active links in the NeuraNet 'that'
@@ -265,6 +382,10 @@ long NNGetNbActiveLinks(const NeuraNet* const that) {
     PBErrCatch(NeuraNetErr);
   }
 #endif
+  // If the links are implicit
+  if (that->_links == NULL)
+    // All the links are active
+    return NNGetNbMaxLinks(that);
   // Declare a variable to memorize the result
   long nb = 0;
   // Loop on links
@@ -312,3 +433,130 @@ long NNGetGAAdnIntLength(const NeuraNet* const that) {
   return NNGetNbMaxLinks(that) * NN_NBPARAMLINK;
 }
 
+// ----- NNEvalContext
+
+// ================ Functions implementation ====================
+
+// Get the hidden values of the NNEvalContext 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalContextHiddenValues(
+  const NNEvalContext* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_hidVal;
+}
+
+// ----- NNPlanCache
+
+// ================ Functions implementation ====================
+
+// Get the nb of calls to NNSetLinksCached with the NNPlanCache 'that'
+// which found their links in it
+#if BUILDMODE != 0
+static inline
+#endif
+unsigned long NNPlanCacheGetNbHit(const NNPlanCache* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_nbHit;
+}
+
+// Get the nb of calls to NNSetLinksCached with the NNPlanCache 'that'
+// which didn't find their links in it
+#if BUILDMODE != 0
+static inline
+#endif
+unsigned long NNPlanCacheGetNbMiss(const NNPlanCache* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_nbMiss;
+}
+
+// Get the ratio of calls to NNSetLinksCached with the NNPlanCache 
+// 'that' which found their links in it, 0.0 if it hasn't been used
+#if BUILDMODE != 0
+static inline
+#endif
+float NNPlanCacheGetHitRate(const NNPlanCache* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  if (that->_nbHit + that->_nbMiss == 0)
+    return 0.0;
+  return (float)(that->_nbHit) / (float)(that->_nbHit + that->_nbMiss);
+}
+
+// ----- NNThreadTeam
+
+// ================ Functions implementation ====================
+
+// Get the number of threads of the NNThreadTeam 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int NNThreadTeamGetNbThread(const NNThreadTeam* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_nbThread;
+}
+
+// ----- NNEvalState
+
+// ================ Functions implementation ====================
+
+// Get the input values of the NNEvalState 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalStateInput(const NNEvalState* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_input;
+}
+
+// Get the hidden values of the NNEvalState 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalStateHiddenValues(const NNEvalState* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  return that->_hidVal;
+}
+
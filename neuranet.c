@@ -6,16 +6,259 @@
 #if BUILDMODE == 0
 #include "neuranet-inline.c"
 #endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NN_X86
+#endif
 
 // ----- NeuraNet
 
 // ================ Functions implementation ====================
 
+// Helper function for the NeuraNet
+// Return the size in bytes 'size' rounded up to a multiple of the size
+// of a cache line
+size_t NNArenaAlign(const size_t size) {
+  return (size + NN_CACHELINE - 1) / NN_CACHELINE * NN_CACHELINE;
+}
+
+// Helper function for the NeuraNet
+// Allocate a block of memory of 'size' bytes aligned on a cache line, 
+// as PBErrMalloc, reporting the failure with the PBErr 'that'
+// 'size' must be a multiple of the size of a cache line
+void* NNErrAlignedMalloc(PBErr* const that, const size_t size) {
+#if BUILDMODE == 0
+  if (size % NN_CACHELINE != 0) {
+    that->_type = PBErrTypeInvalidArg;
+    sprintf(that->_msg, "'size' is invalid (%zu%%%d!=0)", size, 
+      NN_CACHELINE);
+    PBErrCatch(that);
+  }
+#endif
+  // Allocate the memory
+  void* ret = aligned_alloc(NN_CACHELINE, size);
+  if (ret == NULL) {
+    that->_type = PBErrTypeMallocFailed;
+    sprintf(that->_msg, "aligned_alloc failed (%zu bytes)", size);
+    PBErrCatch(that);
+  }
+  // Return the allocated memory
+  return ret;
+}
+
+// Helper function for the NeuraNet
+// Lay out a VecFloat of dimension 'dim' in the memory 'arena' at 
+// the offset '*size' and set '*vec' to it, then add its size to 
+// '*size'
+// If 'arena' is null only its size is added
+void NNArenaVecFloat(VecFloat** const vec, char* const arena, 
+  size_t* const size, const long dim) {
+  if (arena != NULL) {
+    *vec = (VecFloat*)(arena + *size);
+    *(long*)&((*vec)->_dim) = dim;
+  }
+  *size += NNArenaAlign(sizeof(VecFloat) + sizeof(float) * dim);
+}
+
+// Helper function for the NeuraNet
+// Lay out a VecLong of dimension 'dim' in the memory 'arena' at 
+// the offset '*size' and set '*vec' to it, then add its size to 
+// '*size'
+// If 'arena' is null only its size is added
+void NNArenaVecLong(VecLong** const vec, char* const arena, 
+  size_t* const size, const long dim) {
+  if (arena != NULL) {
+    *vec = (VecLong*)(arena + *size);
+    *(long*)&((*vec)->_dim) = dim;
+  }
+  *size += NNArenaAlign(sizeof(VecLong) + sizeof(long) * dim);
+}
+
+// Helper function for the NeuraNet
+// Lay out an array of 'nb' unsigned integers of 'width' bytes in the 
+// memory 'arena' at the offset '*size' and set '*array' to it, then 
+// add its size to '*size'
+// If 'arena' is null only its size is added
+void NNArenaPacked(void** const array, char* const arena, 
+  size_t* const size, const long nb, const int width) {
+  if (arena != NULL)
+    *array = arena + *size;
+  *size += NNArenaAlign(width * nb);
+}
+
+// Helper function for the NeuraNet
+// Return the size in bytes of the unsigned integers of the execution
+// plan of the NeuraNet 'that', 2 if all the ids, base function 
+// indices, nb of links per group and indices of links fit in 16 bits,
+// else 4
+int NNGetPackedWidth(const NeuraNet* const that) {
+  return (NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
+    NNGetNbOutput(that) <= UINT16_MAX + 1L &&
+    NNGetNbMaxBases(that) <= UINT16_MAX + 1L &&
+    NNGetNbMaxLinks(that) <= UINT16_MAX ? 
+    sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+// Helper function for the NeuraNet
+// Return the 'i'-th unsigned integer of 'width' bytes of the array 
+// 'array'
+long NNPackedGet(const void* const array, const int width, 
+  const long i) {
+  if (width == sizeof(uint16_t))
+    return ((const uint16_t*)array)[i];
+  else
+    return ((const uint32_t*)array)[i];
+}
+
+// Helper function for the NeuraNet
+// Set the 'i'-th unsigned integer of 'width' bytes of the array 
+// 'array' to 'val'
+void NNPackedSet(void* const array, const int width, const long i,
+  const long val) {
+  if (width == sizeof(uint16_t))
+    ((uint16_t*)array)[i] = val;
+  else
+    ((uint32_t*)array)[i] = val;
+}
+
+// Helper function for the NeuraNet
+// Lay out the links and execution plan of the NeuraNet 'that' in the 
+// memory 'arena' and return their size in bytes
+// If 'arena' is null only their size is returned
+size_t NNArenaLinks(const NeuraNet* const that, char* const arena) {
+  // Declare variables for readability
+  long nbInput = NNGetNbInput(that);
+  long nbOutput = NNGetNbOutput(that);
+  long nbMaxHidden = NNGetNbMaxHidden(that);
+  long nbMaxLinks = NNGetNbMaxLinks(that);
+  int width = NNGetPackedWidth(that);
+  // Lay out the arrays
+  size_t size = 0;
+  NNArenaVecLong((VecLong**)&(that->_links), arena, &size, 
+    nbMaxLinks * NN_NBPARAMLINK);
+  NNArenaVecLong((VecLong**)&(that->_dstGroupStart), arena, &size, 
+    nbMaxHidden + nbOutput + 1);
+  NNArenaVecLong((VecLong**)&(that->_srcGroupStart), arena, &size, 
+    nbInput + nbMaxHidden + 1);
+  NNArenaVecLong((VecLong**)&(that->_levelStart), arena, &size, 
+    nbMaxHidden + nbOutput + 2);
+  NNArenaVecLong((VecLong**)&(that->_levelDst), arena, &size, 
+    nbMaxHidden + nbOutput);
+  NNArenaVecLong((VecLong**)&(that->_dstLevel), arena, &size, 
+    nbMaxHidden + nbOutput);
+  NNArenaVecLong((VecLong**)&(that->_linksOrigin), arena, &size, 
+    nbMaxLinks);
+  NNArenaVecLong((VecLong**)&(that->_linksPos), arena, &size, 
+    nbMaxLinks);
+  // The execution plan is followed by the memory for the base 
+  // function indices of its links, used only if they are not implicit
+  // (see NNUpdatePlan)
+  if (arena != NULL) {
+    *(int*)&(that->_packedWidth) = width;
+    *(void**)&(that->_packedBases) = NULL;
+  }
+  NNArenaPacked((void**)&(that->_packedPlan), arena, &size, 
+    3 * nbMaxLinks, width);
+  void* packedBases = NULL;
+  NNArenaPacked(&packedBases, arena, &size, nbMaxLinks, width);
+  // Return the size
+  return size;
+}
+
+// Helper function for the NeuraNet
+// Lay out the execution plan per destination of the NeuraNet 'that' 
+// in the memory 'arena' and return its size in bytes
+// If 'arena' is null only its size is returned
+size_t NNArenaPlanPerDst(const NeuraNet* const that, char* const arena) {
+  // Declare variables for readability
+  long nbMaxLinks = NNGetNbMaxLinks(that);
+  int width = NNGetPackedWidth(that);
+  // Lay out the arrays
+  size_t size = 0;
+  NNArenaPacked((void**)&(that->_dstPlan), arena, &size, 
+    3 * nbMaxLinks, width);
+  NNArenaPacked((void**)&(that->_dstBase), arena, &size, 
+    nbMaxLinks, width);
+  NNArenaPacked((void**)&(that->_dstLinkStart), arena, &size, 
+    nbMaxLinks, width);
+  NNArenaPacked((void**)&(that->_dstPos), arena, &size, 
+    nbMaxLinks, width);
+  // Return the size
+  return size;
+}
+
+// Helper function for the NeuraNet
+// Get the memory for the base function indices of the links of the 
+// execution plan of the NeuraNet 'that', following its execution plan
+void* NNArenaPackedBases(const NeuraNet* const that) {
+  return (char*)(that->_packedPlan) + 
+    NNArenaAlign(that->_packedWidth * 3 * NNGetNbMaxLinks(that));
+}
+
+// Helper function for the NeuraNet
+// Return the base function index of the 'iLink'-th link of the 
+// execution plan of the NeuraNet 'that'
+long NNGetPackedBase(const NeuraNet* const that, const long iLink) {
+  if (that->_packedBases == NULL)
+    return iLink;
+  else
+    return NNPackedGet(that->_packedBases, that->_packedWidth, iLink);
+}
+
+// Helper function for the NeuraNet
+// Return the scratch memory of the updates of the links of the 
+// NeuraNet 'that', allocating it on its first use
+long* NNGetScratch(const NeuraNet* const that) {
+  // If the scratch memory is not allocated yet
+  if (that->_scratch == NULL) {
+    // Allocate it, large enough for the sort of the links
+    long nbVal = NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
+      NNGetNbOutput(that);
+    *(long**)&(that->_scratch) = PBErrMalloc(NeuraNetErr, 
+      sizeof(long) * (2 * NNGetNbMaxLinks(that) + nbVal + 3));
+  }
+  // Return the scratch memory
+  return that->_scratch;
+}
+
+// Helper function for the NeuraNet
+// Lay out the NeuraNet 'that' and its arrays in the memory 'arena', 
+// starting with 'that' itself, and return their size in bytes
+// The links and execution plan are laid out at the end if 
+// 'withLinks' equals true
+// If 'arena' is null only the size is returned
+size_t NNArenaNeuraNet(const NeuraNet* const that, char* const arena,
+  const bool withLinks) {
+  // Lay out the arrays after the NeuraNet
+  size_t size = NNArenaAlign(sizeof(NeuraNet));
+  NNArenaVecFloat((VecFloat**)&(that->_bases), arena, &size, 
+    NNGetNbMaxBases(that) * NN_NBPARAMBASE);
+  NNArenaVecFloat((VecFloat**)&(that->_basesCoeff), arena, &size, 
+    NNGetNbMaxBases(that) * NN_NBCOEFFBASE);
+  if (NNGetNbMaxHidden(that) > 0)
+    NNArenaVecFloat((VecFloat**)&(that->_hidVal), arena, &size, 
+      NNGetNbMaxHidden(that));
+  // Lay out the links and execution plan if requested
+  if (withLinks) {
+    if (arena != NULL)
+      *(void**)&(that->_linksArena) = arena + size;
+    size += NNArenaLinks(that, (arena != NULL ? arena + size : NULL));
+  }
+  // Return the size
+  return size;
+}
+
+// Helper function for NeuraNetCreate, NeuraNetCreateConvolution and 
+// NNDecodeAsJSON
 // Create a new NeuraNet with 'nbInput' input values, 'nbOutput' 
 // output values, 'nbMaxHidden' hidden values, 'nbMaxBases' base 
-// functions, 'nbMaxLinks' links
-NeuraNet* NeuraNetCreate(const int nbInput, const int nbOutput, 
-  const long nbMaxHidden, const long nbMaxBases, const long nbMaxLinks) {
+// functions, 'nbMaxLinks' links, in one block of memory
+// The links and execution plan are allocated with the NeuraNet if 
+// 'withLinks' equals true, else they are allocated apart later if 
+// needed (see NNAllocateLinks)
+NeuraNet* NeuraNetCreateInArena(const int nbInput, 
+  const int nbOutput, const long nbMaxHidden, const long nbMaxBases, 
+  const long nbMaxLinks, const bool withLinks) {
 #if BUILDMODE == 0
   if (nbInput <= 0) {
     NeuraNetErr->_type = PBErrTypeInvalidArg;
@@ -46,40 +289,251 @@ NeuraNet* NeuraNetCreate(const int nbInput, const int nbOutput,
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Declare the new NeuraNet
-  NeuraNet* that = PBErrMalloc(NeuraNetErr, sizeof(NeuraNet));
+  // Get the size of the memory of the NeuraNet
+  NeuraNet dim = {._nbInputVal = nbInput, ._nbOutputVal = nbOutput,
+    ._nbMaxHidVal = nbMaxHidden, ._nbMaxBases = nbMaxBases, 
+    ._nbMaxLinks = nbMaxLinks};
+  size_t size = NNArenaNeuraNet(&dim, NULL, withLinks);
+  // Declare the new NeuraNet, its memory is set to 0, hence its 
+  // properties not set below are null, and its links, if any, are
+  // zero
+  NeuraNet* that = NNErrAlignedMalloc(NeuraNetErr, size);
+  memset(that, 0, size);
+  memcpy(that, &dim, sizeof(NeuraNet));
   // Set properties
-  *(int*)&(that->_nbInputVal) = nbInput;
-  *(int*)&(that->_nbOutputVal) = nbOutput;
-  *(long*)&(that->_nbMaxHidVal) = nbMaxHidden;
-  *(long*)&(that->_nbMaxBases) = nbMaxBases;
-  *(long*)&(that->_nbMaxLinks) = nbMaxLinks;
-  *(long*)&(that->_nbBasesConv) = 0;
-  *(long*)&(that->_nbBasesCellConv) = 0;
-  that->_bases = VecFloatCreate(nbMaxBases * NN_NBPARAMBASE);
-  that->_links = VecLongCreate(nbMaxLinks * NN_NBPARAMLINK);
-  if (nbMaxHidden > 0)
-    that->_hidVal = VecFloatCreate(nbMaxHidden);
-  else
-    that->_hidVal = NULL;
+  NNArenaNeuraNet(that, (char*)that, withLinks);
+  for (long iBase = nbMaxBases; iBase--;)
+    NNUpdateBaseCoeff(that, iBase);
+  *(NNLinkOrder*)&(that->_linkOrder) = NNLinkOrderInputMajor;
+  // Return the new NeuraNet
+  return that;  
+}
+
+// Helper function for the NeuraNet
+// Reset the origin of the links of the NeuraNet 'that' such as each 
+// active link is identified by its own index, used when the links 
+// are set otherwise than by NNSetLinks
+void NNResetLinksOrigin(const NeuraNet* const that) {
+  // Loop on the links
+  for (long iLink = NNGetNbMaxLinks(that); iLink--;) {
+    VecSet(that->_linksOrigin, iLink, iLink);
+    if (VecGet(that->_links, iLink * NN_NBPARAMLINK) != -1)
+      VecSet(that->_linksPos, iLink, iLink);
+    else
+      VecSet(that->_linksPos, iLink, -1);
+  }
+}
+
+// Helper function for the NeuraNet
+// Allocate the links and execution plan of the NeuraNet 'that' if 
+// they are not allocated yet, the new links are all inactive
+// They are allocated apart from the memory of the NeuraNet, unless 
+// it has already been allocated (see NNCloneInto)
+void NNAllocateLinks(const NeuraNet* const that) {
+  // If the links are already allocated
+  if (that->_links != NULL)
+    // Nothing to do
+    return;
+  // Allocate memory if necessary
+  size_t size = NNArenaLinks(that, NULL);
+  if (that->_linksArena == NULL)
+    *(void**)&(that->_linksArena) = 
+      NNErrAlignedMalloc(NeuraNetErr, size);
+  memset(that->_linksArena, 0, size);
+  // Lay out the links and execution plan
+  NNArenaLinks(that, that->_linksArena);
+  // Reset the origin of the links
+  NNResetLinksOrigin(that);
+}
+
+// Create a new NeuraNet with 'nbInput' input values, 'nbOutput' 
+// output values, 'nbMaxHidden' hidden values, 'nbMaxBases' base 
+// functions, 'nbMaxLinks' links
+NeuraNet* NeuraNetCreate(const int nbInput, const int nbOutput, 
+  const long nbMaxHidden, const long nbMaxBases, const long nbMaxLinks) {
+  // Declare the new NeuraNet with its links and execution plan
+  NeuraNet* that = NeuraNetCreateInArena(nbInput, nbOutput, 
+    nbMaxHidden, nbMaxBases, nbMaxLinks, true);
+  // Reset the origin of the links and update the execution plan
+  NNResetLinksOrigin(that);
+  NNUpdatePlan(that);
   // Return the new NeuraNet
   return that;  
 }
 
 // Free the memory used by the NeuraNet 'that'
+// The links bound to the NeuraNet, if any, are not freed
 void NeuraNetFree(NeuraNet** that) {
   // Check argument
   if (that == NULL || *that == NULL)
     // Nothing to do
     return;
+  // Free the memory of the links and execution plan if it is apart 
+  // from the memory of the NeuraNet
+  if ((char*)((*that)->_linksArena) != 
+    (char*)(*that) + NNArenaNeuraNet(*that, NULL, false))
+    free((*that)->_linksArena);
   // Free memory
-  VecFree(&((*that)->_bases));
-  VecFree(&((*that)->_links));
-  VecFree(&((*that)->_hidVal));
+  free((*that)->_dstArena);
+  free((*that)->_scratch);
+  NNConvGeometryFree(&((*that)->_conv));
+  VecFree(&((*that)->_layers));
   free(*that);
   *that = NULL;
 }
 
+// Helper function for NNClone and NNCloneInto
+// Fix the NeuraNet 'that' whose memory has just been copied from the
+// NeuraNet 'src', with its links and execution plan in 'linksArena'
+// and its execution plan per destination, if 'src' has one, in 
+// 'dstArena'
+void NNCloneFixup(NeuraNet* const that, const NeuraNet* const src,
+  void* const linksArena, void* const dstArena) {
+  // Lay out the arrays in the memory of 'that'
+  NNArenaNeuraNet(that, (char*)that, false);
+  that->_linksArena = linksArena;
+  if (src->_links != NULL) {
+    NNArenaLinks(that, linksArena);
+    if (src->_packedBases != NULL)
+      that->_packedBases = NNArenaPackedBases(that);
+  }
+  // Copy the execution plan per destination of 'src', if any
+  that->_dstArena = dstArena;
+  if (dstArena != NULL) {
+    memcpy(dstArena, src->_dstArena, NNArenaPlanPerDst(src, NULL));
+    NNArenaPlanPerDst(that, dstArena);
+  } else {
+    that->_dstPlan = NULL;
+    that->_dstBase = NULL;
+    that->_dstLinkStart = NULL;
+    that->_dstPos = NULL;
+  }
+  // The scratch memory of 'src' is not shared
+  that->_scratch = NULL;
+  // Copy the links bound to 'src', if any
+  that->_ownLinks = NULL;
+  if (src->_ownLinks != NULL)
+    VecCopy(that->_links, src->_links);
+  // Clone the geometry of the convolution and dense layers, if any
+  if (src->_conv != NULL)
+    that->_conv = NNConvGeometryCreate(src->_conv->_dimIn, 
+      src->_conv->_dimCell, src->_conv->_depthConv, 
+      src->_conv->_thickConv, src->_conv->_stride, 
+      src->_conv->_poolKind, src->_conv->_poolSize);
+  if (src->_layers != NULL)
+    that->_layers = VecClone(src->_layers);
+}
+
+// Return a clone of the NeuraNet 'that'
+// The clone doesn't share any memory with 'that', the links bound to 
+// 'that', if any, are copied in the clone
+NeuraNet* NNClone(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Get the size of the memory of the NeuraNet, the links and 
+  // execution plan of the clone are in its memory
+  bool withLinks = (that->_links != NULL);
+  size_t sizeMain = NNArenaNeuraNet(that, NULL, false);
+  size_t size = NNArenaNeuraNet(that, NULL, withLinks);
+  // Declare the clone
+  NeuraNet* clone = NNErrAlignedMalloc(NeuraNetErr, size);
+  // Copy the memory of the NeuraNet, at once if the links and 
+  // execution plan are in it, else in two parts
+  if (!withLinks || that->_linksArena == (char*)that + sizeMain) {
+    memcpy(clone, that, size);
+  } else {
+    memcpy(clone, that, sizeMain);
+    memcpy((char*)clone + sizeMain, that->_linksArena, 
+      size - sizeMain);
+  }
+  // Allocate the memory of the execution plan per destination of the
+  // clone if necessary
+  void* dstArena = NULL;
+  if (that->_dstArena != NULL)
+    dstArena = NNErrAlignedMalloc(NeuraNetErr, 
+      NNArenaPlanPerDst(that, NULL));
+  // Fix the clone
+  NNCloneFixup(clone, that, (withLinks ? (char*)clone + sizeMain : NULL),
+    dstArena);
+  // Return the clone
+  return clone;
+}
+
+// Copy the NeuraNet 'src' into the NeuraNet 'that', reusing the 
+// memory of 'that'
+// 'that' and 'src' must have the same nb of input, output, hidden 
+// values, base functions and links
+void NNCloneInto(NeuraNet* const that, const NeuraNet* const src) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (src == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'src' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (NNGetNbInput(that) != NNGetNbInput(src) ||
+    NNGetNbOutput(that) != NNGetNbOutput(src) ||
+    NNGetNbMaxHidden(that) != NNGetNbMaxHidden(src) ||
+    NNGetNbMaxBases(that) != NNGetNbMaxBases(src) ||
+    NNGetNbMaxLinks(that) != NNGetNbMaxLinks(src)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'src' 's dimensions are different from the ones of 'that'");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If 'that' and 'src' are the same NeuraNet
+  if (that == src)
+    // Nothing to do
+    return;
+  // Discard the geometry of the convolution and dense layers of 
+  // 'that', if any
+  NNConvGeometryFree(&(that->_conv));
+  VecFree(&(that->_layers));
+  // Allocate the memory of the links and execution plan of 'that' if
+  // necessary
+  size_t sizeMain = NNArenaNeuraNet(src, NULL, false);
+  size_t sizeLinks = NNArenaLinks(src, NULL);
+  if (src->_links != NULL && that->_linksArena == NULL)
+    that->_linksArena = NNErrAlignedMalloc(NeuraNetErr, sizeLinks);
+  void* linksArena = that->_linksArena;
+  // Allocate or free the memory of the execution plan per destination 
+  // of 'that' to match 'src'
+  void* dstArena = that->_dstArena;
+  if (src->_dstArena != NULL && dstArena == NULL) {
+    dstArena = NNErrAlignedMalloc(NeuraNetErr, 
+      NNArenaPlanPerDst(src, NULL));
+  } else if (src->_dstArena == NULL && dstArena != NULL) {
+    free(dstArena);
+    dstArena = NULL;
+  }
+  // Keep the scratch memory of 'that'
+  long* scratch = that->_scratch;
+  // Copy the memory of the NeuraNet, at once if the links and 
+  // execution plan are in it for both NeuraNet, else in two parts
+  if (src->_links != NULL && 
+    linksArena == (char*)that + sizeMain &&
+    src->_linksArena == (char*)src + sizeMain) {
+    memcpy(that, src, sizeMain + sizeLinks);
+  } else {
+    memcpy(that, src, sizeMain);
+    if (src->_links != NULL)
+      memcpy(linksArena, src->_linksArena, sizeLinks);
+  }
+  // Fix 'that'
+  NNCloneFixup(that, src, linksArena, dstArena);
+  that->_scratch = scratch;
+}
+
 // Create a new NeuraNet with 'nbIn' innput values, 'nbOut' 
 // output values and a set of hidden layers described by 
 // 'hiddenLayers' as follow:
@@ -165,10 +619,528 @@ NeuraNet* NeuraNetCreateFullyConnected(const int nbIn, const int nbOut,
     shiftOut += nOut;
     nIn = nOut;
   }
+  // The links are created already sorted, reset their origin and 
+  // update the execution plan
+  NNResetLinksOrigin(nn);
+  NNUpdatePlan(nn);
+  // Memorize the layers to evaluate them as dense layers
+  nn->_layers = VecLongCreate(nbHiddenLayer + 2);
+  VecSet(nn->_layers, 0, nbIn);
+  for (long iLayer = 0; iLayer < nbHiddenLayer; ++iLayer)
+    VecSet(nn->_layers, iLayer + 1, VecGet(hiddenLayers, iLayer));
+  VecSet(nn->_layers, nbHiddenLayer + 1, nbOut);
   // Return the new NeuraNet
   return nn;
 }
 
+// Helper function for NNSetLinks and NNDecodeAsJSON
+// Return true if the links of the NeuraNet 'that' are the ones created
+// by NeuraNetCreateFullyConnected for its layers, false else
+bool NNLinksMatchLayers(const NeuraNet* const that) {
+  // Declare variables for readability
+  long nbLayer = VecGetDim(that->_layers);
+  // Check the layers
+  long nbVal = 0;
+  long nbLink = 0;
+  for (long iLayer = 0; iLayer < nbLayer; ++iLayer) {
+    if (VecGet(that->_layers, iLayer) <= 0)
+      return false;
+    nbVal += VecGet(that->_layers, iLayer);
+    if (iLayer > 0)
+      nbLink += 
+        VecGet(that->_layers, iLayer - 1) * VecGet(that->_layers, iLayer);
+  }
+  if (nbLayer < 2 || 
+    VecGet(that->_layers, 0) != NNGetNbInput(that) ||
+    VecGet(that->_layers, nbLayer - 1) != NNGetNbOutput(that) ||
+    nbVal != NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
+      NNGetNbOutput(that) ||
+    nbLink != NNGetNbMaxLinks(that) || that->_links == NULL)
+    return false;
+  // Loop on the links in the order they are created
+  const long* link = that->_links->_val;
+  long iLink = 0;
+  long shiftIn = 0;
+  for (long iLayer = 0; iLayer < nbLayer - 1; ++iLayer) {
+    long nIn = VecGet(that->_layers, iLayer);
+    long nOut = VecGet(that->_layers, iLayer + 1);
+    long shiftOut = shiftIn + nIn;
+    for (long iIn = 0; iIn < nIn; ++iIn) {
+      for (long iOut = 0; iOut < nOut; ++iOut) {
+        // If the link doesn't match
+        if (link[0] != iLink || link[1] != iIn + shiftIn || 
+          link[2] != iOut + shiftOut)
+          return false;
+        link += NN_NBPARAMLINK;
+        ++iLink;
+      }
+    }
+    shiftIn = shiftOut;
+  }
+  // The links match
+  return true;
+}
+
+// Helper function for the convolution NeuraNet
+// Calculate the dimensions 'dimConv' of the output layer of the
+// convolution and 'dimPool' of the output layer of the pooling stage
+// of the 'iConv'-th level of the NNConvGeometry 'that', given the
+// dimensions 'dimIn' of the input layer of this level
+// 'dimPool' is equal to 'dimConv' if there is no pooling stage
+// Return the nb of values per pooling window, 0 if there is no
+// pooling stage
+long NNConvGeometryGetDimLevel(const NNConvGeometry* const that,
+  const long iConv, const long* const dimIn, long* const dimConv,
+  long* const dimPool) {
+  // Get the stride, kind of pooling and size of the pooling window
+  long stride = 1;
+  NNPoolKind poolKind = NNPoolNone;
+  long poolSize = 1;
+  if (that->_stride != NULL) {
+    stride = VecGet(that->_stride, iConv);
+    poolKind = VecGet(that->_poolKind, iConv);
+    poolSize = VecGet(that->_poolSize, iConv);
+  }
+  // Declare a variable to memorize the nb of values per pooling
+  // window
+  long nbWin = (poolKind == NNPoolNone ? 0 : 1);
+  // Loop on dimensions
+  for (long iDim = VecGetDim(that->_dimIn); iDim--;) {
+    // Calculate the dimensions of the convolution and pooling layers,
+    // there is no convolution if the input is smaller than the cell
+    // (the division would truncate toward zero)
+    if (dimIn[iDim] < VecGet(that->_dimCell, iDim))
+      dimConv[iDim] = 0;
+    else
+      dimConv[iDim] =
+        (dimIn[iDim] - VecGet(that->_dimCell, iDim)) / stride + 1;
+    if (poolKind == NNPoolNone) {
+      dimPool[iDim] = dimConv[iDim];
+    } else {
+      dimPool[iDim] = dimConv[iDim] / poolSize;
+      nbWin *= poolSize;
+    }
+  }
+  // Return the nb of values per pooling window
+  return nbWin;
+}
+
+// Helper function for the convolution NeuraNet
+// Return the nb of intermediate hidden values per pooling window of
+// 'nbWin' values for a pooling of kind 'poolKind'
+// The maximum of the window is calculated by comparing its values one
+// after the other with the maximum of the previous ones, each
+// comparison uses one hidden value for the difference and one for the
+// new maximum, the last one being the output of the pooling
+long NNConvGetNbHiddenPool(const NNPoolKind poolKind, const long nbWin) {
+  if (poolKind == NNPoolMax && nbWin > 1)
+    return 2 * nbWin - 3;
+  else
+    return 0;
+}
+
+// Helper function for the convolution NeuraNet
+// Return the nb of links per pooling window of 'nbWin' values for a
+// pooling of kind 'poolKind'
+long NNConvGetNbLinkPool(const NNPoolKind poolKind, const long nbWin) {
+  if (poolKind == NNPoolMax && nbWin > 1)
+    return 4 * (nbWin - 1);
+  else
+    return nbWin;
+}
+
+// Helper function for the convolution NeuraNet
+// Return the nb of base functions used by the pooling stages of the
+// NNConvGeometry 'that'
+long NNConvGeometryGetNbBasesPool(const NNConvGeometry* const that) {
+  // Declare a variable to memorize the result
+  long nb = 0;
+  // Loop on the levels
+  if (that->_poolKind != NULL) {
+    for (long iConv = that->_depthConv; iConv--;) {
+      if (VecGet(that->_poolKind, iConv) == NNPoolAvg)
+        nb += NN_NBBASEPOOLAVG;
+      else if (VecGet(that->_poolKind, iConv) == NNPoolMax)
+        nb += NN_NBBASEPOOLMAX;
+    }
+  }
+  // Return the result
+  return nb;
+}
+
+// Helper function for NeuraNetCreateConvolutionWithPooling and
+// NNSetGABoundsBases
+// Set the parameters of the base functions of the pooling stages of
+// the NeuraNet 'that' into 'bases' (of dimension
+// NNGetNbMaxBases(that) * NN_NBPARAMBASE)
+// The bases of the pooling stages follow the ones of the convolutions,
+// per level NN_NBBASEPOOLAVG base for an average pooling (slope
+// 1/nbWin) or NN_NBBASEPOOLMAX bases for a maximum pooling (slope and
+// offset (1,0), (-1,0), (1,-1), (-1,-1), (1,1))
+// Return the index of the first base of the pooling stages
+long NNConvSetBasesPool(const NeuraNet* const that,
+  VecFloat* const bases) {
+  // Declare variables for readability
+  const NNConvGeometry* conv = that->_conv;
+  long nbDim = VecGetDim(conv->_dimIn);
+  // Declare variables to memorize the dimensions of the layers
+  long* buffer = PBErrMalloc(NeuraNetErr, sizeof(long) * 3 * nbDim);
+  long* curDimIn = buffer;
+  long* dimConv = curDimIn + nbDim;
+  long* dimPool = dimConv + nbDim;
+  long nbLinkPerCell = 1;
+  for (long iDim = nbDim; iDim--;) {
+    curDimIn[iDim] = VecGet(conv->_dimIn, iDim);
+    nbLinkPerCell *= VecGet(conv->_dimCell, iDim);
+  }
+  // Declare a variable to memorize the index of the first base of the
+  // pooling stages
+  long iStartBase = conv->_depthConv * conv->_thickConv * nbLinkPerCell;
+  // Declare the parameters of the slopes 1 and -1
+  float paramOne = atan(1.0) / NN_THETA;
+  // Loop on levels
+  long iBase = iStartBase;
+  for (long iConv = 0; iConv < conv->_depthConv; ++iConv) {
+    long nbWin =
+      NNConvGeometryGetDimLevel(conv, iConv, curDimIn, dimConv, dimPool);
+    // Declare a variable to memorize the parameters of the bases of
+    // this level
+    float param[NN_NBBASEPOOLMAX][NN_NBPARAMBASE] = {{0.0}};
+    long nbBase = 0;
+    if (VecGet(conv->_poolKind, iConv) == NNPoolAvg) {
+      nbBase = NN_NBBASEPOOLAVG;
+      param[0][0] = atan(1.0 / (double)nbWin) / NN_THETA;
+    } else if (VecGet(conv->_poolKind, iConv) == NNPoolMax) {
+      nbBase = NN_NBBASEPOOLMAX;
+      param[0][0] = paramOne;
+      param[1][0] = -paramOne;
+      param[2][0] = paramOne;
+      param[2][2] = -1.0;
+      param[3][0] = -paramOne;
+      param[3][2] = -1.0;
+      param[4][0] = paramOne;
+      param[4][2] = 1.0;
+    }
+    // Set the bases of this level
+    for (long jBase = 0; jBase < nbBase; ++jBase, ++iBase)
+      for (long iParam = NN_NBPARAMBASE; iParam--;)
+        VecSet(bases, iBase * NN_NBPARAMBASE + iParam,
+          param[jBase][iParam]);
+    // Step to the next level
+    for (long iDim = nbDim; iDim--;)
+      curDimIn[iDim] = dimPool[iDim];
+  }
+  // Free memory
+  free(buffer);
+  // Return the index of the first base of the pooling stages
+  return iStartBase;
+}
+
+// Helper function for NeuraNetCreateConvolutionWithPooling and
+// NNExpandLinks
+// Helper function for NNConvGeometryGetLinks
+// Set the 'iLink'-th link of 'links' to ('base', 'in', 'out')
+void NNConvSetLink(VecLong* const links, const long iLink,
+  const long base, const long in, const long out) {
+  VecSet(links, iLink * NN_NBPARAMLINK, base);
+  VecSet(links, iLink * NN_NBPARAMLINK + 1, in);
+  VecSet(links, iLink * NN_NBPARAMLINK + 2, out);
+}
+
+// Set the links of a NeuraNet made of the convolution layers
+// described by the NNConvGeometry 'that' followed by a fully connected
+// layer toward 'nbOutput' output values into 'links'
+// 'nbHiddenVal' is the number of hidden values of the NeuraNet
+// For each level, the hidden values are the output layers of the
+// convolutions in parallel, followed if there is a pooling stage by
+// the intermediate values of the pooling (see NNConvGetNbHiddenPool)
+// and the output layers of the pooling
+// The links are generated directly in increasing order of their input
+// and output, as sorted by NNSetLinks, by looping on the values and
+// creating the links from each of them toward the values it feeds
+void NNConvGeometryGetLinks(const NNConvGeometry* const that,
+  const int nbOutput, const long nbHiddenVal, VecLong* const links) {
+  // Declare variables for readability
+  long nbDim = VecGetDim(that->_dimIn);
+  int depthConv = that->_depthConv;
+  int thickConv = that->_thickConv;
+  // Calculate the number of inputs and links per cell
+  long nbIn = 1;
+  long nbLinkPerCell = 1;
+  for (long iDim = nbDim; iDim--;) {
+    nbIn *= VecGet(that->_dimIn, iDim);
+    nbLinkPerCell *= VecGet(that->_dimCell, iDim);
+  }
+  // Declare variables to memorize the dimensions of the layers of the
+  // current level, their strides, the strides in the cell, the
+  // position in the input layer, the range of positions in the
+  // output layer of the convolution fed by this position, and the
+  // position in the output layer
+  long* buffer = PBErrMalloc(NeuraNetErr, sizeof(long) * 11 * nbDim);
+  long* curDimIn = buffer;
+  long* dimConv = curDimIn + nbDim;
+  long* dimPool = dimConv + nbDim;
+  long* strideIn = dimPool + nbDim;
+  long* strideConv = strideIn + nbDim;
+  long* stridePool = strideConv + nbDim;
+  long* strideCell = stridePool + nbDim;
+  long* pos = strideCell + nbDim;
+  long* posMin = pos + nbDim;
+  long* posMax = posMin + nbDim;
+  long* posOut = posMax + nbDim;
+  strideCell[0] = 1;
+  for (long iDim = 1; iDim < nbDim; ++iDim)
+    strideCell[iDim] =
+      strideCell[iDim - 1] * VecGet(that->_dimCell, iDim - 1);
+  for (long iDim = nbDim; iDim--;)
+    curDimIn[iDim] = VecGet(that->_dimIn, iDim);
+  // Declare a variable to memorize the index of the first value of
+  // the input layer of the current level, per convolution in parallel
+  long* iStartLayerIn = PBErrMalloc(NeuraNetErr,
+    sizeof(long) * thickConv);
+  for (long iThick = 0; iThick < thickConv; ++iThick)
+    iStartLayerIn[iThick] = 0;
+  // Declare a variable to memorize the index of the first value of
+  // the current level
+  long iStartLevel = nbIn;
+  // Declare a variable to memorize the size of the input layer of the
+  // current level
+  long sizeLayerIn = nbIn;
+  // Declare a variable to memorize the index of the first base of the
+  // current pooling stage, the bases of the pooling stages follow
+  // the ones of the convolutions
+  long iStartBasePool = depthConv * thickConv * nbLinkPerCell;
+  // Declare a variable to memorize the index of the currently
+  // created link
+  long iLink = 0;
+  // Loop on convolution levels
+  for (long iConv = 0; iConv < depthConv; ++iConv) {
+    // Get the dimensions and sizes of the layers at this level
+    long nbWin =
+      NNConvGeometryGetDimLevel(that, iConv, curDimIn, dimConv, dimPool);
+    long stride = VecGet(that->_stride, iConv);
+    NNPoolKind poolKind = VecGet(that->_poolKind, iConv);
+    long poolSize = VecGet(that->_poolSize, iConv);
+    strideIn[0] = strideConv[0] = stridePool[0] = 1;
+    for (long iDim = 1; iDim < nbDim; ++iDim) {
+      strideIn[iDim] = strideIn[iDim - 1] * curDimIn[iDim - 1];
+      strideConv[iDim] = strideConv[iDim - 1] * dimConv[iDim - 1];
+      stridePool[iDim] = stridePool[iDim - 1] * dimPool[iDim - 1];
+    }
+    long sizeConv = strideConv[nbDim - 1] * dimConv[nbDim - 1];
+    long sizePool = stridePool[nbDim - 1] * dimPool[nbDim - 1];
+    // The input layer of the first level is shared by the convolutions
+    // in parallel, the following levels have one input layer per
+    // convolution in parallel
+    long nbLayerIn = (iConv == 0 ? 1 : thickConv);
+    // Loop on the input layers
+    for (long iLayer = 0; iLayer < nbLayerIn; ++iLayer) {
+      // Loop on the values of the input layer, in increasing order of
+      // their index
+      for (long iDim = nbDim; iDim--;)
+        pos[iDim] = 0;
+      for (long iPos = 0; iPos < sizeLayerIn; ++iPos) {
+        // Get the range of positions in the output layer of the
+        // convolution whose cell contains the value, and the offset of
+        // the first one and of its base
+        bool isFed = true;
+        long offOut = 0;
+        long offBase = 0;
+        for (long iDim = nbDim; iDim--;) {
+          long over = pos[iDim] - VecGet(that->_dimCell, iDim) + 1;
+          posMin[iDim] = (over > 0 ? (over + stride - 1) / stride : 0);
+          posMax[iDim] = pos[iDim] / stride;
+          if (posMax[iDim] >= dimConv[iDim])
+            posMax[iDim] = dimConv[iDim] - 1;
+          if (posMin[iDim] > posMax[iDim])
+            isFed = false;
+          posOut[iDim] = posMin[iDim];
+          offOut += posMin[iDim] * strideConv[iDim];
+          offBase += (pos[iDim] - posMin[iDim] * stride) *
+            strideCell[iDim];
+        }
+        // If the value feeds at least one cell
+        if (isFed) {
+          // Loop on the convolutions in parallel fed by this layer
+          long iThickEnd = (iConv == 0 ? thickConv : iLayer + 1);
+          for (long iThick = (iConv == 0 ? 0 : iLayer);
+            iThick < iThickEnd; ++iThick) {
+            // Declare variables to memorize the index of the first
+            // value of the output layer of the convolution and its
+            // first base
+            long iStartConv = iStartLevel + iThick * sizeConv;
+            long iStartBase =
+              (iConv * thickConv + iThick) * nbLinkPerCell;
+            // Loop on the positions in the output layer in increasing
+            // order of their index
+            long iDim = 0;
+            do {
+              // Set the link
+              NNConvSetLink(links, iLink, iStartBase + offBase,
+                iStartLayerIn[iLayer] + iPos, iStartConv + offOut);
+              ++iLink;
+              // Step to the next position in the output layer
+              for (iDim = 0; iDim < nbDim; ++iDim) {
+                if (posOut[iDim] < posMax[iDim]) {
+                  ++(posOut[iDim]);
+                  offOut += strideConv[iDim];
+                  offBase -= stride * strideCell[iDim];
+                  break;
+                }
+                offOut -= (posOut[iDim] - posMin[iDim]) * 
+                  strideConv[iDim];
+                offBase += (posOut[iDim] - posMin[iDim]) * stride * 
+                  strideCell[iDim];
+                posOut[iDim] = posMin[iDim];
+              }
+            } while (iDim < nbDim);
+          }
+        }
+        // Step to the next position in the input layer
+        for (long iDim = 0; iDim < nbDim &&
+          ++(pos[iDim]) == curDimIn[iDim]; ++iDim)
+          pos[iDim] = 0;
+      }
+    }
+    // Memorize the index of the input layers of the next level
+    for (long iThick = 0; iThick < thickConv; ++iThick)
+      iStartLayerIn[iThick] = iStartLevel + iThick * sizeConv;
+    // Declare a variable to memorize the index of the first value of
+    // the next level
+    long iStartNext = iStartLevel + thickConv * sizeConv;
+    sizeLayerIn = sizeConv;
+    // If there is a pooling stage
+    if (nbWin > 0) {
+      // Declare variables to memorize the nb of intermediate values
+      // per window, the index of the first one and the first value of
+      // the output layer of the pooling
+      long nbHidPool = NNConvGetNbHiddenPool(poolKind, nbWin);
+      long iStartHidPool = iStartNext;
+      long iStartPool = iStartHidPool + thickConv * sizePool * nbHidPool;
+      // Loop on the output layers of the convolutions in parallel
+      for (long iThick = 0; iThick < thickConv; ++iThick) {
+        // Loop on the values of the output layer, in increasing order
+        // of their index
+        for (long iDim = nbDim; iDim--;)
+          pos[iDim] = 0;
+        for (long iPos = 0; iPos < sizeConv; ++iPos) {
+          // Get the index of the pooling window containing the value
+          // and the index of the value in the window
+          bool isPooled = true;
+          long iWindow = 0;
+          long iWin = 0;
+          for (long iDim = nbDim; iDim--;) {
+            if (pos[iDim] / poolSize >= dimPool[iDim])
+              isPooled = false;
+            iWindow += (pos[iDim] / poolSize) * stridePool[iDim];
+            iWin = iWin * poolSize + pos[iDim] % poolSize;
+          }
+          // If the value is in a pooling window
+          if (isPooled) {
+            // Declare variables to memorize the index of the value,
+            // the output of the window and the first of its
+            // intermediate values
+            long iVal = iStartLayerIn[iThick] + iPos;
+            long iOutput = iStartPool + iThick * sizePool + iWindow;
+            long iHid = iStartHidPool +
+              (iThick * sizePool + iWindow) * nbHidPool;
+            // If it's an average pooling or there is only one value in
+            // the window
+            if (poolKind == NNPoolAvg || nbWin == 1) {
+              // Add the link from the value to the output of the
+              // window
+              NNConvSetLink(links, iLink++, iStartBasePool, iVal,
+                iOutput);
+            // Else, if it's the first value of the window, it's the
+            // maximum compared to the second value
+            } else if (iWin == 0) {
+              // Add the links toward the first difference and first
+              // new maximum, diff=clip(val-max-1), newMax=max+diff+1
+              // The offset -1 of the difference is carried by the
+              // link of its input with the highest index, so that the
+              // intermediate sum is not clipped
+              NNConvSetLink(links, iLink++, iStartBasePool + 1, iVal,
+                iHid);
+              NNConvSetLink(links, iLink++, iStartBasePool, iVal,
+                (nbWin > 2 ? iHid + 1 : iOutput));
+            // Else, it's compared to the maximum of the previous ones
+            } else {
+              // Add the link toward the difference
+              NNConvSetLink(links, iLink++,
+                iStartBasePool + (iWin == 1 ? 2 : 0), iVal,
+                iHid + 2 * (iWin - 1));
+            }
+          }
+          // Step to the next position in the output layer
+          for (long iDim = 0; iDim < nbDim &&
+            ++(pos[iDim]) == dimConv[iDim]; ++iDim)
+            pos[iDim] = 0;
+        }
+      }
+      // Loop on the intermediate values of the pooling windows, in
+      // increasing order of their index
+      for (long iWindow = 0; iWindow < thickConv * sizePool; ++iWindow) {
+        long iHid = iStartHidPool + iWindow * nbHidPool;
+        long iOutput = iStartPool + iWindow;
+        for (long iCmp = 0; 2 * iCmp < nbHidPool; ++iCmp) {
+          // Get the index of the difference and new maximum of the
+          // comparison
+          long iDiff = iHid + 2 * iCmp;
+          long iNewMax = (iCmp < nbWin - 2 ? iDiff + 1 : iOutput);
+          // Add the link from the difference to the new maximum
+          NNConvSetLink(links, iLink++, iStartBasePool + 4, iDiff,
+            iNewMax);
+          // If the new maximum is not the output of the window
+          if (iNewMax != iOutput) {
+            // Add the links from the new maximum toward the
+            // difference and new maximum of the next comparison
+            NNConvSetLink(links, iLink++, iStartBasePool + 3, iNewMax,
+              iDiff + 2);
+            NNConvSetLink(links, iLink++, iStartBasePool, iNewMax,
+              (iCmp + 1 < nbWin - 2 ? iDiff + 3 : iOutput));
+          }
+        }
+      }
+      // Memorize the index of the input layers of the next level
+      for (long iThick = 0; iThick < thickConv; ++iThick)
+        iStartLayerIn[iThick] = iStartPool + iThick * sizePool;
+      // Update the index of the first value of the next level
+      iStartNext = iStartPool + thickConv * sizePool;
+      sizeLayerIn = sizePool;
+      // Update the index of the first base of the next pooling stage
+      iStartBasePool +=
+        (poolKind == NNPoolAvg ? NN_NBBASEPOOLAVG : NN_NBBASEPOOLMAX);
+    }
+    // Step to the next level
+    iStartLevel = iStartNext;
+    for (long iDim = nbDim; iDim--;)
+      curDimIn[iDim] = dimPool[iDim];
+  }
+  // If there is no convolution level, the fully connected layer takes
+  // its input values as if there was one level of convolution
+  if (depthConv == 0) {
+    sizeLayerIn = 1;
+    for (long iDim = nbDim; iDim--;)
+      sizeLayerIn *= curDimIn[iDim] - VecGet(that->_dimCell, iDim) + 1;
+  }
+  // Set the links of the last fully connected layer between last
+  // convolution and NeuraNet output, the bases of the fully connected
+  // layer follow the ones of the pooling stages
+  // Loop on the values of the last layers, they are consecutive
+  for (long iVal = 0; iVal < sizeLayerIn * thickConv; ++iVal) {
+    // Loop on output of the NeuraNet
+    for (long iOut = 0; iOut < nbOutput; ++iOut) {
+      // Set the link
+      NNConvSetLink(links, iLink, iStartBasePool + iVal * nbOutput + iOut,
+        iStartLayerIn[0] + iVal, iOut + nbIn + nbHiddenVal);
+      ++iLink;
+    }
+  }
+  // Free memory
+  free(buffer);
+  free(iStartLayerIn);
+}
+
 // Create a NeuraNet using convolution
 // The input's dimension is equal to the dimension of 'dimIn', for 
 // example if dimIn==<2,3> the input is a 2D array of width 2 and 
@@ -209,9 +1181,21 @@ NeuraNet* NeuraNetCreateFullyConnected(const int nbIn, const int nbOut,
 //    10,16,25, 11,17,25, 12,18,26, 13,19,26, 12,19,27, 13,20,27, 
 //    14,21,26, 15,22,26, 14,22,27, 15,23,27, 16,24,28, 17,24,29, 
 //    18,25,28, 19,25,29, 20,26,28, 21,26,29, 22,27,28, 23,27,29
-NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn, 
-  const int nbOutput, const VecShort* const dimCell, 
+NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn,
+  const int nbOutput, const VecShort* const dimCell,
   const int depthConv, const int thickConv) {
+  // Create the NeuraNet with a stride 1 and without pooling
+  return NeuraNetCreateConvolutionWithPooling(dimIn, nbOutput, dimCell,
+    depthConv, thickConv, NULL, NULL, NULL);
+}
+
+// Create a NeuraNet using convolution as NeuraNetCreateConvolution,
+// with a stride and a pooling stage per convolution level
+NeuraNet* NeuraNetCreateConvolutionWithPooling(
+  const VecShort* const dimIn, const int nbOutput,
+  const VecShort* const dimCell, const int depthConv,
+  const int thickConv, const VecShort* const stride,
+  const VecShort* const poolKind, const VecShort* const poolSize) {
 #if BUILDMODE == 0
   if (dimIn == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
@@ -250,12 +1234,25 @@ NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn,
     }
   if (depthConv < 0) {
     NeuraNetErr->_type = PBErrTypeInvalidArg;
-    sprintf(NeuraNetErr->_msg, "'depthConv' is invalid (0<=%d)", 
+    sprintf(NeuraNetErr->_msg, "'depthConv' is invalid (0<=%d)",
       depthConv);
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Declare a variable to memorize the nb of input, hidden values, 
+  // Declare a variable to memorize the geometry of the convolution
+  // layers
+  NNConvGeometry* conv = NNConvGeometryCreate(dimIn, dimCell,
+    depthConv, thickConv, stride, poolKind, poolSize);
+#if BUILDMODE == 0
+  if (!NNConvGeometryIsValid(conv)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "the input of a level is smaller than the cell or its output is "
+      "empty");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare a variable to memorize the nb of input, hidden values,
   // bases and links
   long nbIn = 0;
   long nbHiddenVal = 0;
@@ -270,43 +1267,57 @@ NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn,
   long nbLinkPerCell = 1;
   for (long iDim = VecGetDim(dimCell); iDim--;)
     nbLinkPerCell *= VecGet(dimCell, iDim);
-  // Declare a variable to memorize the position of the convolution
-  // cell in the current convolution layer
-  VecShort* pos = VecShortCreate(VecGetDim(dimIn));
-  // Declare a variable to memorize the position in the convolution cell
-  VecShort* posCell = VecShortCreate(VecGetDim(dimIn));
-  // Declare variables to memorize the dimension and size of the input 
-  // layer at current convolution level
-  VecShort* curDimIn = VecClone(dimIn);
-  long sizeLayerIn = 1;
-  for (long iDim = VecGetDim(curDimIn); iDim--;)
-    sizeLayerIn *= VecGet(curDimIn, iDim);
-  // Declare variables to memorize the dimension and size of the 
-  // output layer at current convolution level
-  VecShort* curDimOut = VecClone(curDimIn);
+  // Declare variables to memorize the dimensions of the input layer,
+  // output layer of the convolution and output layer of the pooling
+  // at current convolution level
+  long nbDim = VecGetDim(dimIn);
+  long* buffer = PBErrMalloc(NeuraNetErr, sizeof(long) * 3 * nbDim);
+  long* curDimIn = buffer;
+  long* dimConv = curDimIn + nbDim;
+  long* dimPool = dimConv + nbDim;
+  // Declare a variable to memorize the size of the output layer at
+  // current convolution level, if there is no convolution level the
+  // fully connected layer takes its input values as if there was one
+  // level of convolution
   long sizeLayerOut = 1;
-  for (long iDim = VecGetDim(curDimOut); iDim--;) {
-    VecSetAdd(curDimOut, iDim, -1 * VecGet(dimCell, iDim) + 1);
-    sizeLayerOut *= VecGet(curDimOut, iDim);
+  for (long iDim = nbDim; iDim--;) {
+    curDimIn[iDim] = VecGet(dimIn, iDim);
+    sizeLayerOut *= curDimIn[iDim] - VecGet(dimCell, iDim) + 1;
   }
   // Loop on convolution levels
   for (long iConv = 0; iConv < depthConv; ++iConv) {
+    // Get the dimensions of the layers at this level
+    long nbWin =
+      NNConvGeometryGetDimLevel(conv, iConv, curDimIn, dimConv, dimPool);
+    long sizeConv = 1;
+    sizeLayerOut = 1;
+    for (long iDim = nbDim; iDim--;) {
+#if BUILDMODE == 0
+      if (dimPool[iDim] <= 0) {
+        NeuraNetErr->_type = PBErrTypeInvalidArg;
+        sprintf(NeuraNetErr->_msg,
+          "the %ldth level's %ldth dim is invalid (%ld>0)",
+          iConv, iDim, dimPool[iDim]);
+        PBErrCatch(NeuraNetErr);
+      }
+#endif
+      sizeConv *= dimConv[iDim];
+      sizeLayerOut *= dimPool[iDim];
+      curDimIn[iDim] = dimPool[iDim];
+    }
     // Update the number of bases
     nbBases += nbLinkPerCell;
     // Update the number of hidden values
-    nbHiddenVal += sizeLayerOut;
+    nbHiddenVal += sizeConv;
     // Update the number of links
-    nbLinks += sizeLayerOut * nbLinkPerCell;
-    // If we are not a the last convolution level
-    if (iConv < depthConv - 1) {
-      // Update input and output dimensions at next convolution level 
-      VecCopy(curDimIn, curDimOut);
-      sizeLayerIn = sizeLayerOut;
-      sizeLayerOut = 1;
-      for (long iDim = VecGetDim(curDimOut); iDim--;) {
-        VecSetAdd(curDimOut, iDim, -1 * VecGet(dimCell, iDim) + 1);
-        sizeLayerOut *= VecGet(curDimOut, iDim);
-      }
+    nbLinks += sizeConv * nbLinkPerCell;
+    // If there is a pooling stage
+    if (nbWin > 0) {
+      // Update the number of hidden values and links
+      NNPoolKind kind = VecGet(conv->_poolKind, iConv);
+      nbHiddenVal +=
+        sizeLayerOut * (NNConvGetNbHiddenPool(kind, nbWin) + 1);
+      nbLinks += sizeLayerOut * NNConvGetNbLinkPool(kind, nbWin);
     }
   }
   // Multiply by the number of convolution in parallel
@@ -314,536 +1325,5229 @@ NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn,
   nbBases *= thickConv;
   nbLinks *= thickConv;
   long nbBasesConv = nbBases;
+  // Add the bases of the pooling stages
+  nbBases += NNConvGeometryGetNbBasesPool(conv);
   // Add the links and bases for the fully connected layer toward output
   nbBases += sizeLayerOut * thickConv * nbOutput;
   nbLinks += sizeLayerOut * thickConv * nbOutput;
-  // Create the NeuraNet
-  NeuraNet* nn = 
-    NeuraNetCreate(nbIn, nbOutput, nbHiddenVal, nbBases, nbLinks);
+  // Declare a variable to memorize the new NeuraNet
+  NeuraNet* nn = NULL;
+  // If there are convolution levels
+  if (depthConv > 0) {
+    // Create the NeuraNet without its links, they are implicitly
+    // described by the geometry of the convolution layers and only
+    // expanded on demand (see NNExpandLinks)
+    nn = NeuraNetCreateInArena(nbIn, nbOutput, nbHiddenVal,
+      nbBases, nbLinks, false);
+    nn->_conv = conv;
+    // Set the bases of the pooling stages
+    for (long iBase = NNConvSetBasesPool(nn, nn->_bases);
+      iBase < nbBasesConv + NNConvGeometryGetNbBasesPool(conv); ++iBase)
+      NNUpdateBaseCoeff(nn, iBase);
+  // Else, there is no convolution level
+  } else {
+    // Create the NeuraNet and set its links, the NeuraNet is evaluated
+    // with its links
+    nn = NeuraNetCreate(nbIn, nbOutput, nbHiddenVal, nbBases, nbLinks);
+    VecLong* links = VecLongCreate(nbLinks * NN_NBPARAMLINK);
+    NNConvGeometryGetLinks(conv, nbOutput, nbHiddenVal, links);
+    NNSetLinks(nn, links);
+    VecFree(&links);
+    NNConvGeometryFree(&conv);
+  }
   *(long*)&(nn->_nbBasesConv) = nbBasesConv;
   *(long*)&(nn->_nbBasesCellConv) = nbLinkPerCell;
-  // Declare variables to create the links
-  VecLong* links = VecLongCreate(nbLinks * NN_NBPARAMLINK);
-  // Declare a variable to memorize the index of the currenlty 
-  // created link
-  long iLink = 0;
-  // Reset the dimension and size of the input layer at current 
-  // convolution level
-  VecCopy(curDimIn, dimIn);
-  sizeLayerIn = 1;
-  for (long iDim = VecGetDim(curDimIn); iDim--;) {
-    sizeLayerIn *= VecGet(curDimIn, iDim);
-  }
-  // Reset the dimension and size of the output layer at current 
-  // convolution level
-  VecCopy(curDimOut, dimIn);
-  sizeLayerOut = 1;
-  for (long iDim = VecGetDim(curDimOut); iDim--;) {
-    VecSetAdd(curDimOut, iDim, -1 * VecGet(dimCell, iDim) + 1);
-    sizeLayerOut *= VecGet(curDimOut, iDim);
-  }
-  // Declare variables to memorize the index of the beginning of the
-  // input and output layer and base functions at current convolution 
-  // level
-  long* iStartBase = PBErrMalloc(NeuraNetErr, sizeof(long) * thickConv);
-  long* iStartLayerIn = PBErrMalloc(NeuraNetErr, 
-    sizeof(long) * thickConv);
-  long* iStartLayerOut = PBErrMalloc(NeuraNetErr, 
-    sizeof(long) * thickConv);
-  for (long iThick = 0; iThick < thickConv; ++iThick) {
-    iStartLayerIn[iThick] = 0;
-    iStartLayerOut[iThick] = sizeLayerIn + iThick * sizeLayerOut;
-    iStartBase[iThick] = iThick * nbLinkPerCell;
-  }
-  // Loop on convolution levels
-  for (long iConv = 0; iConv < depthConv; ++iConv) {
-    // Reset the position of the convolution cell in the input layer
-    VecSetNull(pos);
-    // Loop on position of the convolution cell at the current 
-    // convolution levels
-    do {
-      do {
-        // Loop on convolution in parallel
-        for (long iThick = 0; iThick < thickConv; ++iThick) {
-          // Declare a variable to memorize the index of the input of the
-          // current link
-          long iInput = 0;
-          for (long iDim = VecGetDim(curDimIn); iDim--;) {
-            iInput *= VecGet(curDimIn, iDim);
-            iInput += VecGet(posCell, iDim) + VecGet(pos, iDim);
-          }
-          iInput += iStartLayerIn[iThick];
-          // Declare a variable to memorize the index of the output of 
-          // the current link
-          long iOutput = 0;
-          for (long iDim = VecGetDim(curDimOut); iDim--;) {
-            iOutput *= VecGet(curDimOut, iDim);
-            iOutput += VecGet(pos, iDim);
-          }
-          iOutput += iStartLayerOut[iThick];
-          // Declare a variable to memorize the index of the base of the
-          // current link
-          long iBase = 0;
-          for (long iDim = VecGetDim(posCell); iDim--;) {
-            iBase *= VecGet(dimCell, iDim);
-            iBase += VecGet(posCell, iDim);
-          }
-          iBase += iStartBase[iThick];
-          // Set the current link's parameters
-          VecSet(links, iLink * NN_NBPARAMLINK, iBase);
-          VecSet(links, iLink * NN_NBPARAMLINK + 1, iInput);
-          VecSet(links, iLink * NN_NBPARAMLINK + 2, iOutput);
-          // Increment the index of the current link
-          ++iLink;
-        }
-      } while (VecPStep(posCell, dimCell));
-    } while (VecPStep(pos, curDimOut));
-    // If we are not at the last convolution level
-    if (iConv < depthConv - 1) {
-      // Update input and output dimensions at next convolution level 
-      VecCopy(curDimIn, curDimOut);
-      sizeLayerIn = sizeLayerOut;
-      sizeLayerOut = 1;
-      for (long iDim = VecGetDim(curDimOut); iDim--;) {
-        VecSetAdd(curDimOut, iDim, -1 * VecGet(dimCell, iDim) + 1);
-        sizeLayerOut *= VecGet(curDimOut, iDim);
-      }
-    }
-    // Update the start index of input and output layers and bases
-    // for each convolution in parallel
-    for (long iThick = 0; iThick < thickConv; ++iThick) {
-      iStartLayerIn[iThick] = iStartLayerOut[iThick];
-      iStartLayerOut[iThick] = iStartLayerIn[0] + 
-        thickConv * sizeLayerIn + iThick * sizeLayerOut;
-      iStartBase[iThick] = 
-        ((iConv + 1) * thickConv + iThick) * nbLinkPerCell;
-    }
-  }
-  // Set the links of the last fully connected layer between last 
-  // convolution and NeuraNet output
-  // Declare a variable to remember the index of the base
-  long iBase = iStartBase[0];
-  // Loop on the last output of convolution layer
-  for (long iLayerOut = 0; iLayerOut < sizeLayerOut; ++iLayerOut) {
-    // Loop on parallel convolution
-    for (long iThick = 0; iThick < thickConv; ++iThick) {
-      // Loop on output of the NeuraNet
-      for (long iOut = 0; iOut < nbOutput; ++iOut) {
-        // Declare a variable to memorize the index of the input of 
-        // the link
-        long iInput = iStartLayerIn[0] + 
-          iLayerOut * thickConv + iThick;
-        // Declare a variable to memorize the index of the output of 
-        // the link
-        long iOutput = iOut + nbIn + nbHiddenVal;
-        // Set the link's parameters
-        VecSet(links, iLink * NN_NBPARAMLINK, iBase);
-        VecSet(links, iLink * NN_NBPARAMLINK + 1, iInput);
-        VecSet(links, iLink * NN_NBPARAMLINK + 2, iOutput);
-        // Increment the link index
-        ++iLink;
-        // Increment the base function
-        ++iBase;
-      }
-    }
-  } 
-  // Set up the links
-  NNSetLinks(nn, links);
   // Free memory
-  VecFree(&links);
-  VecFree(&pos);
-  VecFree(&posCell);
-  VecFree(&curDimIn);
-  VecFree(&curDimOut);
-  free(iStartBase);
-  free(iStartLayerIn);
-  free(iStartLayerOut);
+  free(buffer);
   // Return the new NeuraNet
   return nn;
 }
 
-// Calculate the output values for the input values 'input' for the 
-// NeuraNet 'that' and memorize the result in 'output'
-// input values in [-1,1] and output values in [-1,1]
-// All values of 'output' are set to 0.0 before evaluating
-// Links which refer to values out of bounds of 'input' or 'output'
-// are ignored
-void NNEval(const NeuraNet* const that, const VecFloat* const input, VecFloat* const output) {
+// Create a new NNConvGeometry for convolution layers on input values
+// of dimension 'dimIn', with cells of dimension 'dimCell', 'depthConv'
+// levels and 'thickConv' convolutions in parallel per level
+// 'stride', 'poolKind' and 'poolSize' are the stride and pooling per
+// level (see NeuraNetCreateConvolutionWithPooling), null for the
+// default
+NNConvGeometry* NNConvGeometryCreate(const VecShort* const dimIn,
+  const VecShort* const dimCell, const int depthConv,
+  const int thickConv, const VecShort* const stride,
+  const VecShort* const poolKind, const VecShort* const poolSize) {
 #if BUILDMODE == 0
-  if (that == NULL) {
+  if (dimIn == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'that' is null");
+    sprintf(NeuraNetErr->_msg, "'dimIn' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (input == NULL) {
+  if (dimCell == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'input' is null");
+    sprintf(NeuraNetErr->_msg, "'dimCell' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (output == NULL) {
-    NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'output' is null");
+  if (VecGetDim(dimCell) != VecGetDim(dimIn)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'dimCell' 's dim is invalid (%ld==%ld)",
+      VecGetDim(dimCell), VecGetDim(dimIn));
     PBErrCatch(NeuraNetErr);
   }
-  if (VecGetDim(input) != that->_nbInputVal) {
+  if (stride != NULL && VecGetDim(stride) != depthConv) {
     NeuraNetErr->_type = PBErrTypeInvalidArg;
-    sprintf(NeuraNetErr->_msg, 
-      "'input' 's dimension is invalid (%ld!=%d)", 
-      VecGetDim(input), that->_nbInputVal);
+    sprintf(NeuraNetErr->_msg, "'stride' 's dim is invalid (%ld==%d)",
+      VecGetDim(stride), depthConv);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (poolKind != NULL && VecGetDim(poolKind) != depthConv) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'poolKind' 's dim is invalid (%ld==%d)",
+      VecGetDim(poolKind), depthConv);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (poolSize != NULL && VecGetDim(poolSize) != depthConv) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'poolSize' 's dim is invalid (%ld==%d)",
+      VecGetDim(poolSize), depthConv);
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iConv = depthConv; iConv--;) {
+    if (stride != NULL && VecGet(stride, iConv) <= 0) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg, "'stride' %ldth value is invalid (%d>0)",
+        iConv, VecGet(stride, iConv));
+      PBErrCatch(NeuraNetErr);
+    }
+    if (poolKind != NULL && (VecGet(poolKind, iConv) < 0 ||
+      VecGet(poolKind, iConv) >= NN_NBPOOLKIND)) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg,
+        "'poolKind' %ldth value is invalid (0<=%d<%d)",
+        iConv, VecGet(poolKind, iConv), NN_NBPOOLKIND);
+      PBErrCatch(NeuraNetErr);
+    }
+    if (poolSize != NULL && VecGet(poolSize, iConv) <= 0) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg,
+        "'poolSize' %ldth value is invalid (%d>0)",
+        iConv, VecGet(poolSize, iConv));
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+#endif
+  // Declare the new geometry
+  NNConvGeometry* that = PBErrMalloc(NeuraNetErr,
+    sizeof(NNConvGeometry));
+  // Set properties
+  that->_dimIn = VecClone(dimIn);
+  that->_dimCell = VecClone(dimCell);
+  that->_depthConv = depthConv;
+  that->_thickConv = thickConv;
+  that->_stride = NULL;
+  that->_poolKind = NULL;
+  that->_poolSize = NULL;
+  // If there are convolution levels
+  if (depthConv > 0) {
+    // Set the stride and pooling per level, by default stride 1 and
+    // no pooling
+    that->_stride = VecShortCreate(depthConv);
+    that->_poolKind = VecShortCreate(depthConv);
+    that->_poolSize = VecShortCreate(depthConv);
+    for (long iConv = depthConv; iConv--;) {
+      VecSet(that->_stride, iConv,
+        (stride != NULL ? VecGet(stride, iConv) : 1));
+      VecSet(that->_poolKind, iConv,
+        (poolKind != NULL ? VecGet(poolKind, iConv) : NNPoolNone));
+      VecSet(that->_poolSize, iConv,
+        (poolSize != NULL ? VecGet(poolSize, iConv) : 1));
+    }
+  }
+  // Return the new geometry
+  return that;
+}
+
+// Free the memory used by the NNConvGeometry 'that'
+void NNConvGeometryFree(NNConvGeometry** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  VecFree(&((*that)->_dimIn));
+  VecFree(&((*that)->_dimCell));
+  VecFree(&((*that)->_stride));
+  VecFree(&((*that)->_poolKind));
+  VecFree(&((*that)->_poolSize));
+  free(*that);
+  *that = NULL;
+}
+
+// Return true if the NNConvGeometry 'that' is valid, i.e. along each 
+// dimension the input of each level is at least as large as the cell 
+// and the output of its pooling stage is not empty, else false
+bool NNConvGeometryIsValid(const NNConvGeometry* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare variables to memorize the dimensions of the input layer,
+  // output layer of the convolution and output layer of the pooling
+  // at current convolution level
+  long nbDim = VecGetDim(that->_dimIn);
+  long* buffer = PBErrMalloc(NeuraNetErr, sizeof(long) * 3 * nbDim);
+  long* curDimIn = buffer;
+  long* dimConv = curDimIn + nbDim;
+  long* dimPool = dimConv + nbDim;
+  for (long iDim = nbDim; iDim--;)
+    curDimIn[iDim] = VecGet(that->_dimIn, iDim);
+  // Declare a variable to memorize the result
+  bool isValid = true;
+  // Loop on convolution levels, if there is no convolution level the 
+  // fully connected layer takes its input values as if there was one 
+  // level of convolution, hence its input is checked the same way
+  for (long iConv = 0; iConv < MAX(1, that->_depthConv); ++iConv) {
+    // Check the input of the level is not smaller than the cell
+    for (long iDim = nbDim; iDim--;)
+      if (curDimIn[iDim] < VecGet(that->_dimCell, iDim))
+        isValid = false;
+    if (!isValid || that->_depthConv == 0)
+      break;
+    // Check the output of the level is not empty, it's the input of 
+    // the next level
+    NNConvGeometryGetDimLevel(that, iConv, curDimIn, dimConv, dimPool);
+    for (long iDim = nbDim; iDim--;) {
+      if (dimPool[iDim] <= 0)
+        isValid = false;
+      curDimIn[iDim] = dimPool[iDim];
+    }
+  }
+  // Free memory
+  free(buffer);
+  // Return the result
+  return isValid;
+}
+
+// Helper function for NNEvalConv
+// Return a pointer to the 'iVal'-th value (input values followed by 
+// hidden values) among 'input' and 'hidVal' of the NeuraNet 'that'
+float* NNConvValue(const NeuraNet* const that, const float* const input, 
+  float* const hidVal, const long iVal) {
+  // The input values are only read by NNEvalConv
+  if (iVal < NNGetNbInput(that))
+    return (float*)input + iVal;
+  else
+    return hidVal + iVal - NNGetNbInput(that);
+}
+
+// Helper function for NNEvalConv
+// Evaluate the pooling stage of kind 'poolKind' with windows of
+// 'nbWin' values ('poolSize' along each of the 'nbDim' dimensions)
+// from the layer 'layerIn' of dimensions 'dimIn' into the layer
+// 'layerOut' of dimensions 'dimOut', using 'hidPool' to memorize the
+// intermediate values of the windows, and the coefficients 'coeff' of
+// the bases of the pooling stage
+// 'pos' and 'posWin' are scratch memory of 'nbDim' values
+// Each value accumulates its links in the same order as NNEval
+void NNEvalConvPool(const NNPoolKind poolKind, const long nbDim,
+  const long poolSize, const long nbWin, const long* const dimIn,
+  const long* const dimOut, const float* const layerIn,
+  float* const layerOut, float* const hidPool, const float* const coeff,
+  long* const pos, long* const posWin) {
+  // Declare a variable to memorize the nb of intermediate values per
+  // window
+  long nbHidPool = NNConvGetNbHiddenPool(poolKind, nbWin);
+  // Declare a variable to memorize the size of the output layer
+  long sizeOut = 1;
+  for (long iDim = nbDim; iDim--;) {
+    sizeOut *= dimOut[iDim];
+    pos[iDim] = posWin[iDim] = 0;
+  }
+  // Loop on the windows
+  for (long iPos = 0; iPos < sizeOut; ++iPos) {
+    float* hid = hidPool + iPos * nbHidPool;
+    // Declare a variable to memorize the maximum so far, or the sum
+    // of the values of the window
+    float acc = 0.0;
+    // Loop on the values of the window, in increasing order of their
+    // index
+    for (long iWin = 0; iWin < nbWin; ++iWin) {
+      // Get the value
+      long iVal = 0;
+      for (long iDim = nbDim; iDim--;)
+        iVal = iVal * dimIn[iDim] + pos[iDim] * poolSize + posWin[iDim];
+      float x = layerIn[iVal];
+      // If it's an average pooling or there is only one value in the
+      // window
+      if (poolKind == NNPoolAvg || nbWin == 1) {
+        // Add the link from the value to the output of the window
+        float v = acc + (coeff[0] * x + coeff[1]);
+        acc = (v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v));
+      // Else, if it's the first value of the window
+      } else if (iWin == 0) {
+        // It's the maximum so far
+        acc = x;
+      // Else, it's a maximum pooling
+      } else {
+        // Calculate diff=clip(val-max-1), the offset -1 being carried
+        // by the link of the input with the highest index
+        const float* cMax = coeff + (iWin == 1 ? 1 : 3) * NN_NBCOEFFBASE;
+        const float* cVal = coeff + (iWin == 1 ? 2 : 0) * NN_NBCOEFFBASE;
+        float first = (iWin == 1 ? cMax[0] * acc + cMax[1] :
+          cVal[0] * x + cVal[1]);
+        float second = (iWin == 1 ? cVal[0] * x + cVal[1] :
+          cMax[0] * acc + cMax[1]);
+        float diff = (first > 1.0f ? 1.0f :
+          (first < -1.0f ? -1.0f : first));
+        diff += second;
+        diff = (diff > 1.0f ? 1.0f : (diff < -1.0f ? -1.0f : diff));
+        // Calculate newMax=max+diff+1
+        float newMax = coeff[0] * acc + coeff[1];
+        newMax = (newMax > 1.0f ? 1.0f :
+          (newMax < -1.0f ? -1.0f : newMax));
+        newMax += coeff[4 * NN_NBCOEFFBASE] * diff +
+          coeff[4 * NN_NBCOEFFBASE + 1];
+        newMax = (newMax > 1.0f ? 1.0f :
+          (newMax < -1.0f ? -1.0f : newMax));
+        // Memorize the intermediate values
+        hid[2 * (iWin - 1)] = diff;
+        if (iWin < nbWin - 1)
+          hid[2 * (iWin - 1) + 1] = newMax;
+        acc = newMax;
+      }
+      // Step to the next position in the window
+      for (long iDim = 0; iDim < nbDim &&
+        ++(posWin[iDim]) == poolSize; ++iDim)
+        posWin[iDim] = 0;
+    }
+    // Set the output of the window
+    layerOut[iPos] = acc;
+    // Step to the next window
+    for (long iDim = 0; iDim < nbDim &&
+      ++(pos[iDim]) == dimOut[iDim]; ++iDim)
+      pos[iDim] = 0;
+  }
+}
+
+// Helper function for NNEvalConv, NNEvalContextCreate and NNEvalBatch
+// Return the number of longs of the scratch memory used by NNEvalConv 
+// for the convolution NeuraNet 'that'
+long NNGetConvBufferSize(const NeuraNet* const that) {
+  return 6 * VecGetDim(that->_conv->_dimIn) + that->_conv->_thickConv;
+}
+
+// Helper function for NNEvalWithHidden and NNEvalBatchConv
+// Calculate the output values for the input values 'in' for the
+// NeuraNet 'that', evaluated as a convolution network according to
+// its NNConvGeometry, and memorize the result in 'out', using 'hid' 
+// to memorize the hidden values (null if there is no hidden value)
+// 'buffer' is a scratch memory of NNGetConvBufferSize(that) longs, if 
+// it is null it is allocated for the call
+// Each convolution is evaluated by sweeping its output feature map
+// once per position in the cell, the coefficients of the base function
+// at this position being loaded once per sweep. Each value
+// accumulates its links in the same order as NNEval, hence the
+// results are exactly the same
+void NNEvalConv(const NeuraNet* const that, long* const buffer,
+  float* const hid, const float* const in, float* const out) {
+  // Reset the hidden values and output
+  if (hid != NULL)
+    memset(hid, 0, sizeof(float) * NNGetNbMaxHidden(that));
+  memset(out, 0, sizeof(float) * NNGetNbOutput(that));
+  // Declare variables for optimization
+  const NNConvGeometry* conv = that->_conv;
+  const float* coeffs = that->_basesCoeff->_val;
+  long nbDim = VecGetDim(conv->_dimIn);
+  int thickConv = conv->_thickConv;
+  // Declare variables to memorize the dimension of the input layer,
+  // and output layers of the convolution and pooling at the current
+  // level, the stride of each dimension in the input layer, and the
+  // positions in the cell and output layer
+  long* curDimIn = (buffer != NULL ? buffer : 
+    PBErrMalloc(NeuraNetErr, sizeof(long) * NNGetConvBufferSize(that)));
+  long* dimConv = curDimIn + nbDim;
+  long* dimPool = dimConv + nbDim;
+  long* strideIn = dimPool + nbDim;
+  long* posCell = strideIn + nbDim;
+  long* posOut = posCell + nbDim;
+  // Declare a variable to memorize the index of the beginning of the
+  // input layer at the current level, for each convolution in parallel
+  long* iStartLayerIn = posOut + nbDim;
+  // Init the dimensions and sizes as in
+  // NeuraNetCreateConvolutionWithPooling
+  long nbLinkPerCell = 1;
+  for (long iDim = 0; iDim < nbDim; ++iDim) {
+    nbLinkPerCell *= VecGet(conv->_dimCell, iDim);
+    curDimIn[iDim] = VecGet(conv->_dimIn, iDim);
+  }
+  for (long iThick = 0; iThick < thickConv; ++iThick)
+    iStartLayerIn[iThick] = 0;
+  // Declare variables to memorize the index of the first value of the
+  // current level, the size of the input layer of the current level,
+  // and the index of the first base of the current pooling stage
+  long iStartLevel = NNGetNbInput(that);
+  long sizeLayerIn = NNGetNbInput(that);
+  long iStartBasePool = conv->_depthConv * thickConv * nbLinkPerCell;
+  // Loop on convolution levels
+  for (long iConv = 0; iConv < conv->_depthConv; ++iConv) {
+    // Get the dimensions and sizes of the layers at this level
+    long nbWin =
+      NNConvGeometryGetDimLevel(conv, iConv, curDimIn, dimConv, dimPool);
+    long stride = VecGet(conv->_stride, iConv);
+    long sizeConv = 1;
+    long sizePool = 1;
+    for (long iDim = 0; iDim < nbDim; ++iDim) {
+      sizeConv *= dimConv[iDim];
+      sizePool *= dimPool[iDim];
+    }
+    // Update the strides in the input layer
+    strideIn[0] = 1;
+    for (long iDim = 1; iDim < nbDim; ++iDim)
+      strideIn[iDim] = strideIn[iDim - 1] * curDimIn[iDim - 1];
+    // Get the nb of rows (positions along the first dimension) in the
+    // output layer
+    long nbRow = sizeConv / dimConv[0];
+    // Loop on convolution in parallel
+    for (long iThick = 0; iThick < thickConv; ++iThick) {
+      const float* layerIn =
+        NNConvValue(that, in, hid, iStartLayerIn[iThick]);
+      long iStartConv = iStartLevel + iThick * sizeConv;
+      float* layerOut = NNConvValue(that, in, hid, iStartConv);
+      long iStartBase = (iConv * thickConv + iThick) * nbLinkPerCell;
+      // Loop on the positions in the cell, in increasing order of the
+      // input index of their links
+      for (long iDim = nbDim; iDim--;)
+        posCell[iDim] = 0;
+      for (long iCell = 0; iCell < nbLinkPerCell; ++iCell) {
+        // Get the coefficients of the base function at this position
+        const float* coeff =
+          coeffs + (iStartBase + iCell) * NN_NBCOEFFBASE;
+        const float slope = coeff[0];
+        const float offset = coeff[1];
+        // Get the offset of this position in the input layer
+        long offsetCell = 0;
+        for (long iDim = nbDim; iDim--;)
+          offsetCell += posCell[iDim] * strideIn[iDim];
+        // Loop on the rows of the output layer
+        for (long iDim = nbDim; iDim--;)
+          posOut[iDim] = 0;
+        for (long iRow = 0; iRow < nbRow; ++iRow) {
+          // Get the offset of this row in the input layer
+          long offsetRow = offsetCell;
+          for (long iDim = nbDim; --iDim > 0;)
+            offsetRow += posOut[iDim] * stride * strideIn[iDim];
+          // Sweep the row, adding the link to each output value,
+          // clamped to [-1,1]
+          const float* x = layerIn + offsetRow;
+          float* y = layerOut + iRow * dimConv[0];
+          for (long iPos = 0; iPos < dimConv[0]; ++iPos) {
+            float prod = slope * x[iPos * stride] + offset;
+            float v = y[iPos] + prod;
+            y[iPos] = (v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v));
+          }
+          // Step to the next row
+          for (long iDim = 1; iDim < nbDim &&
+            ++(posOut[iDim]) == dimConv[iDim]; ++iDim)
+            posOut[iDim] = 0;
+        }
+        // Step to the next position in the cell
+        for (long iDim = 0; iDim < nbDim &&
+          ++(posCell[iDim]) == VecGet(conv->_dimCell, iDim); ++iDim)
+          posCell[iDim] = 0;
+      }
+      // Memorize the index of the input layer of the next level
+      iStartLayerIn[iThick] = iStartConv;
+    }
+    // Update the index of the first value of the next level
+    iStartLevel += thickConv * sizeConv;
+    sizeLayerIn = sizeConv;
+    // If there is a pooling stage
+    if (nbWin > 0) {
+      // Get the nb of intermediate values per window, and the index
+      // of the first one and of the output layer of the pooling
+      NNPoolKind poolKind = VecGet(conv->_poolKind, iConv);
+      long nbHidPool = NNConvGetNbHiddenPool(poolKind, nbWin);
+      long iStartHidPool = iStartLevel;
+      long iStartPool = iStartHidPool + thickConv * sizePool * nbHidPool;
+      // Loop on convolution in parallel
+      for (long iThick = 0; iThick < thickConv; ++iThick) {
+        NNEvalConvPool(poolKind, nbDim, VecGet(conv->_poolSize, iConv),
+          nbWin, dimConv, dimPool,
+          NNConvValue(that, in, hid, iStartLayerIn[iThick]),
+          NNConvValue(that, in, hid, iStartPool + iThick * sizePool),
+          NNConvValue(that, in, hid,
+            iStartHidPool + iThick * sizePool * nbHidPool),
+          coeffs + iStartBasePool * NN_NBCOEFFBASE, posCell, posOut);
+        // Memorize the index of the input layer of the next level
+        iStartLayerIn[iThick] = iStartPool + iThick * sizePool;
+      }
+      // Update the index of the first value of the next level and of
+      // the first base of the next pooling stage
+      iStartLevel = iStartPool + thickConv * sizePool;
+      sizeLayerIn = sizePool;
+      iStartBasePool +=
+        (poolKind == NNPoolAvg ? NN_NBBASEPOOLAVG : NN_NBBASEPOOLMAX);
+    }
+    // Step to the next level
+    for (long iDim = 0; iDim < nbDim; ++iDim)
+      curDimIn[iDim] = dimPool[iDim];
+  }
+  // Evaluate the fully connected layer between the last convolution
+  // and the output, the links of the 'iVal'-th value of the last
+  // layer toward the 'iOut'-th output use the
+  // (iStartBasePool + iVal * nbOutput + iOut)-th base function
+  long nbOutput = NNGetNbOutput(that);
+  const float* layerIn = NNConvValue(that, in, hid, iStartLayerIn[0]);
+  for (long iVal = 0; iVal < sizeLayerIn * thickConv; ++iVal) {
+    const float x = layerIn[iVal];
+    const float* coeff =
+      coeffs + (iStartBasePool + iVal * nbOutput) * NN_NBCOEFFBASE;
+    for (long iOut = 0; iOut < nbOutput; ++iOut) {
+      float prod = coeff[iOut * NN_NBCOEFFBASE] * x +
+        coeff[iOut * NN_NBCOEFFBASE + 1];
+      out[iOut] += prod;
+    }
+  }
+  // Free memory
+  if (buffer == NULL)
+    free(curDimIn);
+}
+
+// Helper function for NNEvalWithHidden
+// Calculate the output values for the input values 'input' for the
+// NeuraNet 'that', evaluated as dense layers, and memorize the result 
+// in 'output', using 'hidVal' to memorize the hidden values
+// The link from the 'iIn'-th value of a layer toward the 'iOut'-th
+// value of the next layer uses the base function following the ones 
+// of the previous layers at index iIn * nbOut + iOut, hence the 
+// slopes and offsets of a layer form a nbIn x nbOut matrix read row 
+// by row. Each value accumulates its links in the same order as 
+// NNEval, hence the results are exactly the same
+void NNEvalDense(const NeuraNet* const that, VecFloat* const hidVal,
+  const VecFloat* const input, VecFloat* const output) {
+  // Reset the hidden values and output
+  if (hidVal != NULL)
+    VecSetNull(hidVal);
+  VecSetNull(output);
+  // Declare variables for optimization
+  long nbLayer = VecGetDim(that->_layers);
+  const float* coeff = that->_basesCoeff->_val;
+  const float* in = input->_val;
+  float* hid = (hidVal != NULL ? hidVal->_val : NULL);
+  // Loop on the layers
+  for (long iLayer = 0; iLayer < nbLayer - 1; ++iLayer) {
+    long nbIn = VecGet(that->_layers, iLayer);
+    long nbOut = VecGet(that->_layers, iLayer + 1);
+    // If the next layer is the output layer
+    if (iLayer == nbLayer - 2) {
+      // Add the links toward the output values, not clamped
+      float* out = output->_val;
+      for (long iIn = 0; iIn < nbIn; ++iIn) {
+        const float x = in[iIn];
+        for (long iOut = 0; iOut < nbOut; ++iOut)
+          out[iOut] += coeff[iOut * NN_NBCOEFFBASE] * x +
+            coeff[iOut * NN_NBCOEFFBASE + 1];
+        coeff += nbOut * NN_NBCOEFFBASE;
+      }
+    // Else, the next layer is a hidden layer
+    } else {
+      // Add the links toward the hidden values, clamped to [-1,1]
+      for (long iIn = 0; iIn < nbIn; ++iIn) {
+        const float x = in[iIn];
+        for (long iOut = 0; iOut < nbOut; ++iOut)
+          hid[iOut] = MIN(1.0, MAX(-1.0, hid[iOut] + 
+            (coeff[iOut * NN_NBCOEFFBASE] * x +
+            coeff[iOut * NN_NBCOEFFBASE + 1])));
+        coeff += nbOut * NN_NBCOEFFBASE;
+      }
+      // The hidden layer is the input of the next layer
+      in = hid;
+      hid += nbOut;
+    }
+  }
+}
+
+// Helper function for NNEvalWithHidden
+// Evaluate the execution plan of the NeuraNet 'that', made of 16 bits 
+// integers, for the input values 'in', hidden values 'hid' and output
+// values 'out'
+void NNEvalPacked16(const NeuraNet* const that, const float* const in,
+  float* const hid, float* const out) {
+  // Declare variables for optimization
+  const uint16_t* plan = that->_packedPlan;
+  const uint16_t* bases = that->_packedBases;
+  const float* coeffs = that->_basesCoeff->_val;
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  // Loop on the groups of links in the execution plan
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < that->_nbPackedGroups; ++iGroup) {
+    const uint16_t* group = plan + 3 * iGroup;
+    // Get the input value of the group
+    float x = (group[0] < startHid ? in[group[0]] : 
+      hid[group[0] - startHid]);
+    // Multiply the evaluation of the links of the group, using the
+    // cached linear form of their base function
+    float prod = 1.0;
+    for (long iEnd = iLink + group[2]; iLink < iEnd; ++iLink) {
+      const float* coeff = coeffs + 
+        (bases != NULL ? bases[iLink] : iLink) * NN_NBCOEFFBASE;
+      prod *= coeff[0] * x + coeff[1];
+    }
+    // Add the result to the output value of the group, clamped to 
+    // [-1,1] if it's a hidden value
+    if (group[1] < startOut)
+      hid[group[1] - startHid] = 
+        MIN(1.0, MAX(-1.0, hid[group[1] - startHid] + prod));
+    else
+      out[group[1] - startOut] += prod;
+  }
+}
+
+// Helper function for NNEvalWithHidden
+// Same as NNEvalPacked16 for an execution plan made of 32 bits 
+// integers
+void NNEvalPacked32(const NeuraNet* const that, const float* const in,
+  float* const hid, float* const out) {
+  // Declare variables for optimization
+  const uint32_t* plan = that->_packedPlan;
+  const uint32_t* bases = that->_packedBases;
+  const float* coeffs = that->_basesCoeff->_val;
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  // Loop on the groups of links in the execution plan
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < that->_nbPackedGroups; ++iGroup) {
+    const uint32_t* group = plan + 3 * iGroup;
+    // Get the input value of the group
+    float x = (group[0] < startHid ? in[group[0]] : 
+      hid[group[0] - startHid]);
+    // Multiply the evaluation of the links of the group, using the
+    // cached linear form of their base function
+    float prod = 1.0;
+    for (long iEnd = iLink + group[2]; iLink < iEnd; ++iLink) {
+      const float* coeff = coeffs + 
+        (bases != NULL ? bases[iLink] : iLink) * NN_NBCOEFFBASE;
+      prod *= coeff[0] * x + coeff[1];
+    }
+    // Add the result to the output value of the group, clamped to 
+    // [-1,1] if it's a hidden value
+    if (group[1] < startOut)
+      hid[group[1] - startHid] = 
+        MIN(1.0, MAX(-1.0, hid[group[1] - startHid] + prod));
+    else
+      out[group[1] - startOut] += prod;
+  }
+}
+
+// Helper function for NNEvalWithHidden
+// Evaluate the execution plan per destination of the NeuraNet 'that' 
+// (see NNLinkOrder), made of 16 bits integers, for the input values 
+// 'in', hidden values 'hid' and output values 'out'
+// The groups of a destination are accumulated in a register and the 
+// destination is stored once
+// The groups of a destination are evaluated in the same order as in 
+// the execution plan, hence the results are exactly the same
+void NNEvalPackedPerDst16(const NeuraNet* const that, 
+  const float* const in, float* const hid, float* const out) {
+  // Declare variables for optimization
+  const uint16_t* plan = that->_dstPlan;
+  const uint16_t* bases = that->_dstBase;
+  const float* coeffs = that->_basesCoeff->_val;
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  // Loop on the destinations in the plan per destination
+  long iLink = 0;
+  long iGroup = 0;
+  while (iGroup < that->_nbPackedGroups) {
+    // Get the destination
+    long idOut = plan[3 * iGroup + 1];
+    bool isHid = (idOut < startOut);
+    // Accumulate the groups of the destination into a register, 
+    // starting from 0.0 as the values have been reset
+    float acc = 0.0;
+    do {
+      const uint16_t* group = plan + 3 * iGroup;
+      // Get the input value of the group, which is the accumulator if
+      // the group loops on its destination
+      float x = (group[0] == idOut ? acc : 
+        group[0] < startHid ? in[group[0]] : hid[group[0] - startHid]);
+      // Multiply the evaluation of the links of the group, using the
+      // cached linear form of their base function
+      float prod = 1.0;
+      for (long iEnd = iLink + group[2]; iLink < iEnd; ++iLink) {
+        const float* coeff = coeffs + bases[iLink] * NN_NBCOEFFBASE;
+        prod *= coeff[0] * x + coeff[1];
+      }
+      // Add the result to the accumulator, clamped to [-1,1] if it's 
+      // a hidden value
+      if (isHid)
+        acc = MIN(1.0f, MAX(-1.0f, acc + prod));
+      else
+        acc += prod;
+      ++iGroup;
+    } while (iGroup < that->_nbPackedGroups && 
+      plan[3 * iGroup + 1] == idOut);
+    // Store the destination
+    if (isHid)
+      hid[idOut - startHid] = acc;
+    else
+      out[idOut - startOut] = acc;
+  }
+}
+
+// Helper function for NNEvalWithHidden
+// Same as NNEvalPackedPerDst16 for a plan per destination made of 32
+// bits integers
+void NNEvalPackedPerDst32(const NeuraNet* const that, 
+  const float* const in, float* const hid, float* const out) {
+  // Declare variables for optimization
+  const uint32_t* plan = that->_dstPlan;
+  const uint32_t* bases = that->_dstBase;
+  const float* coeffs = that->_basesCoeff->_val;
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  // Loop on the destinations in the plan per destination
+  long iLink = 0;
+  long iGroup = 0;
+  while (iGroup < that->_nbPackedGroups) {
+    // Get the destination
+    long idOut = plan[3 * iGroup + 1];
+    bool isHid = (idOut < startOut);
+    // Accumulate the groups of the destination into a register, 
+    // starting from 0.0 as the values have been reset
+    float acc = 0.0;
+    do {
+      const uint32_t* group = plan + 3 * iGroup;
+      // Get the input value of the group, which is the accumulator if
+      // the group loops on its destination
+      float x = (group[0] == idOut ? acc : 
+        group[0] < startHid ? in[group[0]] : hid[group[0] - startHid]);
+      // Multiply the evaluation of the links of the group, using the
+      // cached linear form of their base function
+      float prod = 1.0;
+      for (long iEnd = iLink + group[2]; iLink < iEnd; ++iLink) {
+        const float* coeff = coeffs + bases[iLink] * NN_NBCOEFFBASE;
+        prod *= coeff[0] * x + coeff[1];
+      }
+      // Add the result to the accumulator, clamped to [-1,1] if it's 
+      // a hidden value
+      if (isHid)
+        acc = MIN(1.0f, MAX(-1.0f, acc + prod));
+      else
+        acc += prod;
+      ++iGroup;
+    } while (iGroup < that->_nbPackedGroups && 
+      plan[3 * iGroup + 1] == idOut);
+    // Store the destination
+    if (isHid)
+      hid[idOut - startHid] = acc;
+    else
+      out[idOut - startOut] = acc;
+  }
+}
+
+// Helper function for NNEval and NNEvalCtx
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output', using 'hidVal'
+// to memorize the hidden values
+void NNEvalWithHidden(const NeuraNet* const that, VecFloat* const hidVal,
+  const VecFloat* const input, VecFloat* const output) {
+  // If the NeuraNet is a convolution network
+  if (that->_conv != NULL) {
+    // Evaluate it with the convolution kernel
+    NNEvalConv(that, NULL, (hidVal != NULL ? hidVal->_val : NULL), 
+      input->_val, output->_val);
+    return;
+  }
+  // If the NeuraNet is made of dense layers
+  if (that->_layers != NULL) {
+    // Evaluate it with the dense kernel
+    NNEvalDense(that, hidVal, input, output);
+    return;
+  }
+  // Reset the hidden values and output
+  if (hidVal != NULL)
+    VecSetNull(hidVal);
+  VecSetNull(output);
+  // Evaluate the packed plan, per destination if it has been built 
+  // in output major order
+  float* hid = (hidVal != NULL ? hidVal->_val : NULL);
+  bool isPerDst = (that->_linkOrder == NNLinkOrderOutputMajor && 
+    NNHasPlanPerDst(that));
+  if (isPerDst && that->_packedWidth == sizeof(uint16_t))
+    NNEvalPackedPerDst16(that, input->_val, hid, output->_val);
+  else if (isPerDst)
+    NNEvalPackedPerDst32(that, input->_val, hid, output->_val);
+  else if (that->_packedWidth == sizeof(uint16_t))
+    NNEvalPacked16(that, input->_val, hid, output->_val);
+  else
+    NNEvalPacked32(that, input->_val, hid, output->_val);
+}
+
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output'
+// input values in [-1,1] and output values in [-1,1]
+// All values of 'output' are set to 0.0 before evaluating
+// Links which refer to values out of bounds of 'input' or 'output'
+// are ignored
+void NNEval(const NeuraNet* const that, const VecFloat* const input, VecFloat* const output) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (input == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'input' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (output == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'output' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(input) != that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'input' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(input), that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(output) != that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'output' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(output), that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Evaluate using the hidden values of the NeuraNet
+  NNEvalWithHidden(that, that->_hidVal, input, output);
+}
+
+// Helper function for NNEvalContextCreate and NNEvalBatch
+// Return the number of floats of the scratch memory used by 
+// NNEvalBatchWithTile for the NeuraNet 'that'
+long NNGetBatchTileSize(const NeuraNet* const that) {
+  // Tiles of input, hidden and output values, and product of links
+  long size = NN_BATCHTILE * (NNGetNbInput(that) + 
+    NNGetNbMaxHidden(that) + NNGetNbOutput(that) + 1);
+  // If the NeuraNet is a convolution network, add the scratch memory 
+  // of NNEvalConv used while its links are implicit
+  if (that->_conv != NULL)
+    size += NNGetConvBufferSize(that) * sizeof(long) / sizeof(float);
+  return size;
+}
+
+// Create a new NNEvalContext to evaluate the NeuraNet 'that' 
+// The context can be used with any NeuraNet having the same number 
+// of input, hidden and output values as 'that'
+NNEvalContext* NNEvalContextCreate(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare the new context
+  NNEvalContext* ctx = PBErrMalloc(NeuraNetErr, sizeof(NNEvalContext));
+  // Set properties
+  if (NNGetNbMaxHidden(that) > 0)
+    ctx->_hidVal = VecFloatCreate(NNGetNbMaxHidden(that));
+  else
+    ctx->_hidVal = NULL;
+  ctx->_tile = VecFloatCreate(NNGetBatchTileSize(that));
+  // Return the new context
+  return ctx;
+}
+
+// Free the memory used by the NNEvalContext 'that'
+void NNEvalContextFree(NNEvalContext** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  VecFree(&((*that)->_hidVal));
+  VecFree(&((*that)->_tile));
+  free(*that);
+  *that = NULL;
+}
+
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output', using the 
+// NNEvalContext 'ctx' to memorize the hidden values
+// Same as NNEval but the NeuraNet is never modified, hence it can be 
+// called concurrently on the same NeuraNet with one context per thread
+void NNEvalCtx(const NeuraNet* const that, NNEvalContext* const ctx,
+  const VecFloat* const input, VecFloat* const output) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (ctx == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'ctx' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if ((ctx->_hidVal == NULL ? 0 : VecGetDim(ctx->_hidVal)) != 
+    that->_nbMaxHidVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'ctx' doesn't match the nb of hidden values (%ld)", 
+      that->_nbMaxHidVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (input == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'input' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (output == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'output' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(input) != that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'input' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(input), that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(output) != that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'output' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(output), that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Evaluate using the hidden values of the context
+  NNEvalWithHidden(that, ctx->_hidVal, input, output);
+}
+
+// Helper function for NNEvalParallel
+// Evaluate the destinations _levelDst['iStart'...'iEnd'-1] of the 
+// NeuraNet 'that' with the values 'val' (input, hidden, output)
+void NNEvalLevelDst(const NeuraNet* const that, 
+  float* const* const val, const long iStart, const long iEnd) {
+  // Declare variables for optimization
+  long nbHid = NNGetNbMaxHidden(that);
+  long startHid = NNGetNbInput(that);
+  int width = that->_packedWidth;
+  const float* coeffs = that->_basesCoeff->_val;
+  const long* dstGroupStart = that->_dstGroupStart->_val;
+  const long* levelDst = that->_levelDst->_val;
+  // Loop on the destinations
+  for (long i = iStart; i < iEnd; ++i) {
+    long iDst = levelDst[i];
+    // Get the destination value and its bounds, hidden values are 
+    // clamped to [-1,1], output values are not
+    float* out = (iDst < nbHid ? val[NNValHidden] + iDst : 
+      val[NNValOutput] + iDst - nbHid);
+    float low = (iDst < nbHid ? -1.0 : -HUGE_VALF);
+    float high = (iDst < nbHid ? 1.0 : HUGE_VALF);
+    // Declare a variable to accumulate the destination value
+    float acc = *out;
+    // Loop on the groups of the destination, in increasing order of 
+    // their input as in the plan
+    for (long iGroup = dstGroupStart[iDst]; 
+      iGroup < dstGroupStart[iDst + 1]; ++iGroup) {
+      // Get the input value of the group, which may be the 
+      // destination itself
+      long idIn = NNPackedGet(that->_dstPlan, width, 3 * iGroup);
+      float x = (idIn == startHid + iDst ? acc : idIn < startHid ? 
+        val[NNValInput][idIn] : val[NNValHidden][idIn - startHid]);
+      // Multiply the evaluation of the links of the group
+      float prod = 1.0;
+      long iLink = NNPackedGet(that->_dstLinkStart, width, iGroup);
+      long iEnd = iLink + NNPackedGet(that->_dstPlan, width, 
+        3 * iGroup + 2);
+      for (; iLink < iEnd; ++iLink) {
+        const float* coeff = coeffs + 
+          NNPackedGet(that->_dstBase, width, iLink) * NN_NBCOEFFBASE;
+        prod *= coeff[0] * x + coeff[1];
+      }
+      // Add the result to the destination value
+      acc = MIN(high, MAX(low, acc + prod));
+    }
+    // Update the destination value
+    *out = acc;
+  }
+}
+
+// Helper function for NNEvalParallel
+// Evaluate the share of the 'iThread'-th thread of the NNThreadTeam 
+// 'team' for each dependency level of the NeuraNet currently 
+// evaluated by the team
+void NNThreadTeamEvalLevels(NNThreadTeam* const team, 
+  const int iThread) {
+  // Declare variables for optimization
+  const NeuraNet* nn = team->_nn;
+  const long* levelStart = nn->_levelStart->_val;
+  // Declare a variable to memorize the nb of threads sharing the 
+  // current level
+  long nbThread = 0;
+  // Loop on levels
+  for (long iLevel = 0; levelStart[iLevel + 1] != -1; ++iLevel) {
+    // Get the nb of destinations in the level
+    long nbDst = levelStart[iLevel + 1] - levelStart[iLevel];
+    // Get the nb of threads sharing the level, avoiding to give less 
+    // than NN_PARALLELMINDST destinations per thread
+    long nbThreadPrev = nbThread;
+    nbThread = MIN(team->_nbThread, 
+      (nbDst + NN_PARALLELMINDST - 1) / NN_PARALLELMINDST);
+    // Wait for the other threads before starting the level, unless 
+    // this level and the previous one are evaluated by the first 
+    // thread only
+    if (iLevel > 0 && (nbThread > 1 || nbThreadPrev > 1))
+      pthread_barrier_wait(&(team->_barrier));
+    // If this thread has a share of the level
+    if (iThread < nbThread) {
+      // Evaluate the share of this thread
+      long iStart = levelStart[iLevel] + nbDst * iThread / nbThread;
+      long iEnd = levelStart[iLevel] + nbDst * (iThread + 1) / nbThread;
+      NNEvalLevelDst(nn, team->_val, iStart, iEnd);
+    }
+  }
+  // Wait for the other threads to complete the evaluation
+  if (team->_nbThread > 1)
+    pthread_barrier_wait(&(team->_barrier));
+}
+
+// Main function of the worker threads of a NNThreadTeam
+void* NNThreadTeamWorkerMain(void* arg) {
+  // Get the worker
+  NNThreadTeamWorker* worker = arg;
+  // Loop until the team is freed
+  while (true) {
+    // Wait for an evaluation
+    pthread_barrier_wait(&(worker->_team->_barrier));
+    // If the team is freed, stop
+    if (worker->_team->_quit)
+      break;
+    // Evaluate the share of this worker
+    NNThreadTeamEvalLevels(worker->_team, worker->_iThread);
+  }
+  // Return nothing
+  return NULL;
+}
+
+// Create a new NNThreadTeam of 'nbThread' threads, including the 
+// calling thread
+NNThreadTeam* NNThreadTeamCreate(const int nbThread) {
+#if BUILDMODE == 0
+  if (nbThread <= 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbThread' is invalid (0<%d)", 
+      nbThread);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare the new team
+  NNThreadTeam* that = PBErrMalloc(NeuraNetErr, sizeof(NNThreadTeam));
+  // Set properties
+  that->_nbThread = nbThread;
+  that->_nn = NULL;
+  that->_quit = false;
+  pthread_barrier_init(&(that->_barrier), NULL, nbThread);
+  // Start the worker threads
+  that->_workers = PBErrMalloc(NeuraNetErr, 
+    sizeof(NNThreadTeamWorker) * (nbThread > 1 ? nbThread - 1 : 1));
+  for (int iThread = 1; iThread < nbThread; ++iThread) {
+    NNThreadTeamWorker* worker = that->_workers + iThread - 1;
+    worker->_team = that;
+    worker->_iThread = iThread;
+    if (pthread_create(&(worker->_thread), NULL, 
+      NNThreadTeamWorkerMain, worker) != 0) {
+      NeuraNetErr->_type = PBErrTypeOther;
+      sprintf(NeuraNetErr->_msg, "pthread_create failed");
+      PBErrCatch(NeuraNetErr);
+    }
+  }
+  // Return the new team
+  return that;
+}
+
+// Free the memory used by the NNThreadTeam 'that' and stop its threads
+void NNThreadTeamFree(NNThreadTeam** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Stop the worker threads
+  (*that)->_quit = true;
+  if ((*that)->_nbThread > 1)
+    pthread_barrier_wait(&((*that)->_barrier));
+  for (int iThread = 1; iThread < (*that)->_nbThread; ++iThread)
+    pthread_join((*that)->_workers[iThread - 1]._thread, NULL);
+  // Free memory
+  pthread_barrier_destroy(&((*that)->_barrier));
+  free((*that)->_workers);
+  free(*that);
+  *that = NULL;
+}
+
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output', using the 
+// NNEvalContext 'ctx' to memorize the hidden values
+// Same as NNEvalCtx but the dependency levels of the NeuraNet are 
+// evaluated one after the other, the destination values of each 
+// level being distributed among the threads of 'team'
+// A team can be used by only one evaluation at a time
+// If the levels are unavailable the evaluation is the one of NNEvalCtx
+void NNEvalParallel(const NeuraNet* const that, 
+  NNEvalContext* const ctx, NNThreadTeam* const team,
+  const VecFloat* const input, VecFloat* const output) {
+#if BUILDMODE == 0
+  if (team == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'team' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (that->_links != NULL && that->_dstArena == NULL) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'that' has no plan per destination (see NNSetPlanPerDst)");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the levels are unavailable, or the links are still implicit in
+  // a convolution NeuraNet
+  if (!NNHasPlanPerDst(that)) {
+    // Evaluate sequentially
+    NNEvalCtx(that, ctx, input, output);
+    return;
+  }
+#if BUILDMODE == 0
+  if (ctx == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'ctx' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if ((ctx->_hidVal == NULL ? 0 : VecGetDim(ctx->_hidVal)) != 
+    that->_nbMaxHidVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'ctx' doesn't match the nb of hidden values (%ld)", 
+      that->_nbMaxHidVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (input == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'input' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (output == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'output' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(input) != that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'input' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(input), that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(output) != that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'output' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(output), that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Reset the hidden values and output
+  if (ctx->_hidVal != NULL)
+    VecSetNull(ctx->_hidVal);
+  VecSetNull(output);
+  // Give the evaluation to the team
+  team->_nn = that;
+  team->_val[NNValInput] = (float*)(input->_val);
+  team->_val[NNValHidden] = 
+    (ctx->_hidVal != NULL ? ctx->_hidVal->_val : NULL);
+  team->_val[NNValOutput] = output->_val;
+  // Wake up the worker threads
+  if (team->_nbThread > 1)
+    pthread_barrier_wait(&(team->_barrier));
+  // Evaluate the share of the calling thread
+  NNThreadTeamEvalLevels(team, 0);
+}
+
+// Create a new NNEvalState for the NeuraNet 'that', initialised with 
+// the evaluation of 'that' for all input values equal to 0.0
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+NNEvalState* NNEvalStateCreate(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare the new state
+  NNEvalState* state = PBErrMalloc(NeuraNetErr, sizeof(NNEvalState));
+  // Set properties
+  state->_input = VecFloatCreate(NNGetNbInput(that));
+  state->_output = VecFloatCreate(NNGetNbOutput(that));
+  state->_refOutput = VecFloatCreate(NNGetNbOutput(that));
+  state->_prod = VecFloatCreate(NNGetNbMaxLinks(that));
+  state->_acc = VecFloatCreate(NNGetNbMaxLinks(that));
+  if (NNGetNbMaxHidden(that) > 0) {
+    state->_hidVal = VecFloatCreate(NNGetNbMaxHidden(that));
+    state->_dirtyFrom = VecLongCreate(NNGetNbMaxHidden(that));
+    state->_heap = VecLongCreate(NNGetNbMaxHidden(that));
+    state->_touched = VecLongCreate(NNGetNbMaxHidden(that));
+  } else {
+    state->_hidVal = NULL;
+    state->_dirtyFrom = NULL;
+    state->_heap = NULL;
+    state->_touched = NULL;
+  }
+  state->_nonZero = VecLongCreate(NNGetNbInput(that));
+  state->_nbOutputUpdate = VecLongCreate(NNGetNbOutput(that));
+  // Evaluate the NeuraNet for all input values equal to 0.0
+  NNEvalStateReset(state, that);
+  // Return the new state
+  return state;
+}
+
+// Free the memory used by the NNEvalState 'that'
+void NNEvalStateFree(NNEvalState** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  VecFree(&((*that)->_input));
+  VecFree(&((*that)->_hidVal));
+  VecFree(&((*that)->_output));
+  VecFree(&((*that)->_refOutput));
+  VecFree(&((*that)->_prod));
+  VecFree(&((*that)->_acc));
+  VecFree(&((*that)->_dirtyFrom));
+  VecFree(&((*that)->_heap));
+  VecFree(&((*that)->_touched));
+  VecFree(&((*that)->_nonZero));
+  VecFree(&((*that)->_nbOutputUpdate));
+  free(*that);
+  *that = NULL;
+}
+
+// Helper function for the NNEvalState
+// Re-evaluate the 'iDst'-th destination of the NeuraNet 'that' with
+// the NNEvalState 'state', from the group 'iStart' of the plan per 
+// destination, starting from the value of the reference evaluation 
+// before this group
+// If 'isRef' is true the reference evaluation is updated with the 
+// result
+void NNEvalStateUpdateDst(const NeuraNet* const that, 
+  NNEvalState* const state, const long iDst, const long iStart, 
+  const bool isRef) {
+  // Declare variables for optimization
+  long nbHid = NNGetNbMaxHidden(that);
+  long startHid = NNGetNbInput(that);
+  int width = that->_packedWidth;
+  const float* coeffs = that->_basesCoeff->_val;
+  float* prod = state->_prod->_val;
+  float* acc = state->_acc->_val;
+  float* val[NN_NBVALKIND] = {state->_input->_val, 
+    (state->_hidVal != NULL ? state->_hidVal->_val : NULL), 
+    state->_output->_val};
+  // Get the end of the range of groups to re-evaluate
+  long iEnd = VecGet(that->_dstGroupStart, iDst + 1);
+  // Get the destination value and its bounds, hidden values are 
+  // clamped to [-1,1], output values are not
+  float* out = (iDst < nbHid ? val[NNValHidden] + iDst : 
+    val[NNValOutput] + iDst - nbHid);
+  float low = (iDst < nbHid ? -1.0 : -HUGE_VALF);
+  float high = (iDst < nbHid ? 1.0 : HUGE_VALF);
+  // Declare a variable to accumulate the destination value, starting
+  // from its value before the first group to re-evaluate
+  float sum = (iStart == VecGet(that->_dstGroupStart, iDst) ? 0.0 : 
+    acc[iStart - 1]);
+  // Loop on the groups to re-evaluate
+  // The input values of the groups which are not affected are the 
+  // ones of the reference evaluation, hence their product is the same
+  for (long iGroup = iStart; iGroup < iEnd; ++iGroup) {
+    // Get the input value of the group, which may be the 
+    // destination itself
+    long idIn = NNPackedGet(that->_dstPlan, width, 3 * iGroup);
+    float x = (idIn == startHid + iDst ? sum : idIn < startHid ? 
+      val[NNValInput][idIn] : val[NNValHidden][idIn - startHid]);
+    // Multiply the evaluation of the links of the group
+    float p = 1.0;
+    long iLink = NNPackedGet(that->_dstLinkStart, width, iGroup);
+    long iEndLink = iLink + NNPackedGet(that->_dstPlan, width, 
+      3 * iGroup + 2);
+    for (; iLink < iEndLink; ++iLink) {
+      const float* coeff = coeffs + 
+        NNPackedGet(that->_dstBase, width, iLink) * NN_NBCOEFFBASE;
+      p *= coeff[0] * x + coeff[1];
+    }
+    // Add the product to the destination value
+    sum = MIN(high, MAX(low, sum + p));
+    // Update the reference evaluation if necessary
+    if (isRef) {
+      prod[iGroup] = p;
+      acc[iGroup] = sum;
+    }
+  }
+  // Update the destination value
+  *out = sum;
+}
+
+// Helper function for the NNEvalState
+// Update the NNEvalState 'state' after the modification of the 
+// 'iVal'-th value (input values followed by hidden values) of the 
+// NeuraNet 'that'
+// Output values are not clamped, hence the difference of product of 
+// the affected groups is directly added to their output
+// Hidden values are clamped after adding each group, hence they are 
+// added to the heap of hidden values to re-evaluate, and their first 
+// group to re-evaluate is updated
+// If 'isRef' is true the reference evaluation is updated with the 
+// result
+void NNEvalStateTouch(const NeuraNet* const that, 
+  NNEvalState* const state, const long iVal, const bool isRef) {
+  // Declare variables for optimization
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  int width = that->_packedWidth;
+  const long* srcGroupStart = that->_srcGroupStart->_val;
+  const float* coeffs = that->_basesCoeff->_val;
+  float* prod = state->_prod->_val;
+  float* output = state->_output->_val;
+  // Get the modified value
+  float x = (iVal < NNGetNbInput(that) ? 
+    VecGet(state->_input, iVal) : 
+    VecGet(state->_hidVal, iVal - NNGetNbInput(that)));
+  // Loop on the groups having the value for input
+  for (long iGroup = srcGroupStart[iVal]; 
+    iGroup < srcGroupStart[iVal + 1]; ++iGroup) {
+    // Get the output of the group and its position in the plan per 
+    // destination
+    long idOut = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+    long pos = NNPackedGet(that->_dstPos, width, iGroup);
+    // If the output of the group is an output value
+    if (idOut >= startOut) {
+      // Multiply the evaluation of the links of the group
+      float p = 1.0;
+      long iLink = NNPackedGet(that->_dstLinkStart, width, pos);
+      long iEnd = iLink + NNPackedGet(that->_dstPlan, width, 
+        3 * pos + 2);
+      for (; iLink < iEnd; ++iLink) {
+        const float* coeff = coeffs + 
+          NNPackedGet(that->_dstBase, width, iLink) * NN_NBCOEFFBASE;
+        p *= coeff[0] * x + coeff[1];
+      }
+      // Add the difference with the reference product to the output
+      output[idOut - startOut] += p - prod[pos];
+      // Update the reference evaluation if necessary
+      if (isRef) {
+        prod[pos] = p;
+        VecSetAdd(state->_nbOutputUpdate, idOut - startOut, 1);
+      }
+    // Else, the output of the group is a hidden value, skip the group 
+    // if its input is its output as it's always re-evaluated with its 
+    // output
+    } else if (idOut != iVal) {
+      long iDst = idOut - startHid;
+      long* dirtyFrom = state->_dirtyFrom->_val;
+      long* heap = state->_heap->_val;
+      // If the hidden value is not yet in the heap
+      if (dirtyFrom[iDst] == -1) {
+        dirtyFrom[iDst] = pos;
+        // Add the hidden value to the heap
+        long iNode = (state->_nbHeap)++;
+        while (iNode > 0 && heap[(iNode - 1) / 2] > iDst) {
+          heap[iNode] = heap[(iNode - 1) / 2];
+          iNode = (iNode - 1) / 2;
+        }
+        heap[iNode] = iDst;
+      } else if (pos < dirtyFrom[iDst]) {
+        dirtyFrom[iDst] = pos;
+      }
+    }
+  }
+}
+
+// Helper function for the NNEvalState
+// Remove and return the lowest hidden value from the heap of the 
+// NNEvalState 'state'
+long NNEvalStatePop(NNEvalState* const state) {
+  // Declare variables for optimization
+  long* heap = state->_heap->_val;
+  // Get the lowest hidden value
+  long iDst = heap[0];
+  // Move the last hidden value from the top of the heap down to its 
+  // position
+  long last = heap[--(state->_nbHeap)];
+  long iNode = 0;
+  while (2 * iNode + 1 < state->_nbHeap) {
+    long iChild = 2 * iNode + 1;
+    if (iChild + 1 < state->_nbHeap && heap[iChild + 1] < heap[iChild])
+      ++iChild;
+    if (heap[iChild] >= last)
+      break;
+    heap[iNode] = heap[iChild];
+    iNode = iChild;
+  }
+  heap[iNode] = last;
+  // Return the lowest hidden value
+  return iDst;
+}
+
+// Helper function for the NNEvalState
+// Re-evaluate the hidden values of the NeuraNet 'that' in the heap of 
+// the NNEvalState 'state' in increasing order, and memorize them in
+// the touched hidden values
+// The hidden values added to the heap by a hidden value are always 
+// higher than it
+// If 'isRef' is true the reference evaluation is updated with the 
+// result
+void NNEvalStatePropagate(const NeuraNet* const that, 
+  NNEvalState* const state, const bool isRef) {
+  // Loop on the hidden values to re-evaluate in increasing order
+  while (state->_nbHeap > 0) {
+    long iDst = NNEvalStatePop(state);
+    // Memorize the hidden value
+    VecSet(state->_touched, (state->_nbTouched)++, iDst);
+    // Re-evaluate the hidden value from its first affected group
+    float prev = VecGet(state->_hidVal, iDst);
+    NNEvalStateUpdateDst(that, state, iDst, 
+      VecGet(state->_dirtyFrom, iDst), isRef);
+    VecSet(state->_dirtyFrom, iDst, -1);
+    // If it has changed (bitwise, to be exactly the same as NNEval), 
+    // update the groups having it for input
+    float cur = VecGet(state->_hidVal, iDst);
+    if (memcmp(&cur, &prev, sizeof(float)) != 0)
+      NNEvalStateTouch(that, state, NNGetNbInput(that) + iDst, isRef);
+  }
+}
+
+// Reset the NNEvalState 'that' to the evaluation of the NeuraNet 'nn'
+// for all input values equal to 0.0
+// Must be called each time the bases or links of the NeuraNet have 
+// been modified
+void NNEvalStateReset(NNEvalState* const that, const NeuraNet* const nn) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nn == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'nn' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(that->_input) != nn->_nbInputVal ||
+    VecGetDim(that->_output) != nn->_nbOutputVal ||
+    VecGetDim(that->_acc) != nn->_nbMaxLinks ||
+    (that->_hidVal == NULL ? 0 : VecGetDim(that->_hidVal)) != 
+    nn->_nbMaxHidVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'that' doesn't match the dimensions of the NeuraNet");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nn->_links != NULL && nn->_dstArena == NULL) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'nn' has no plan per destination (see NNSetPlanPerDst)");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Reset the values
+  VecSetNull(that->_input);
+  if (that->_hidVal != NULL) {
+    VecSetNull(that->_hidVal);
+    for (long iDst = NNGetNbMaxHidden(nn); iDst--;)
+      VecSet(that->_dirtyFrom, iDst, -1);
+  }
+  VecSetNull(that->_output);
+  that->_nbHeap = 0;
+  that->_nbTouched = 0;
+  that->_nbNonZero = 0;
+  VecSetNull(that->_nbOutputUpdate);
+  // If the levels are unavailable, or the links are still implicit in
+  // a convolution NeuraNet
+  if (!NNHasPlanPerDst(nn)) {
+    // Evaluate all the links
+    NNEvalWithHidden(nn, that->_hidVal, that->_input, that->_output);
+  } else {
+    // Evaluate all the destinations in increasing order, from their 
+    // first group, and memorize the result as the reference evaluation
+    for (long iDst = 0; 
+      iDst < NNGetNbMaxHidden(nn) + NNGetNbOutput(nn); ++iDst)
+      NNEvalStateUpdateDst(nn, that, iDst, 
+        VecGet(nn->_dstGroupStart, iDst), true);
+  }
+  VecCopy(that->_refOutput, that->_output);
+}
+
+// Helper function for the NNEvalState
+// Restore the hidden values and output values of the reference 
+// evaluation of the NeuraNet 'that' in the NNEvalState 'state'
+void NNEvalStateRestore(const NeuraNet* const that, 
+  NNEvalState* const state) {
+  // Restore the hidden values re-evaluated by the last evaluation
+  for (long i = 0; i < state->_nbTouched; ++i) {
+    long iDst = VecGet(state->_touched, i);
+    long iEnd = VecGet(that->_dstGroupStart, iDst + 1);
+    VecSet(state->_hidVal, iDst, 
+      (VecGet(that->_dstGroupStart, iDst) == iEnd ? 0.0 : 
+      VecGet(state->_acc, iEnd - 1)));
+  }
+  state->_nbTouched = 0;
+  // Restore the output values
+  VecCopy(state->_output, state->_refOutput);
+}
+
+#if BUILDMODE == 0
+// Helper function for the NNEvalState
+// Check the arguments of the evaluation functions using a NNEvalState
+void NNEvalStateCheckArg(const NeuraNet* const that, 
+  const NNEvalState* const state, const VecLong* const iInputs, 
+  const VecFloat* const values, const VecFloat* const output) {
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (state == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'state' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (iInputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'iInputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (values == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'values' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (output == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'output' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(state->_input) != that->_nbInputVal ||
+    VecGetDim(state->_output) != that->_nbOutputVal ||
+    VecGetDim(state->_acc) != that->_nbMaxLinks ||
+    (state->_hidVal == NULL ? 0 : VecGetDim(state->_hidVal)) != 
+    that->_nbMaxHidVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'state' doesn't match the dimensions of the NeuraNet");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(iInputs) != VecGetDim(values) || 
+    VecGetDim(iInputs) > that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'iInputs' 's dimension is invalid (%ld!=%ld or %ld>%d)", 
+      VecGetDim(iInputs), VecGetDim(values), VecGetDim(iInputs),
+      that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long i = VecGetDim(iInputs); i--;)
+    if (VecGet(iInputs, i) < 0 || 
+      VecGet(iInputs, i) >= that->_nbInputVal) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg, 
+        "'iInputs' is invalid (0<=%ld<%d)", 
+        VecGet(iInputs, i), that->_nbInputVal);
+      PBErrCatch(NeuraNetErr);
+    }
+  if (VecGetDim(output) != that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'output' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(output), that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+}
+#endif
+
+// Calculate the output values for the input values of index 'iInputs'
+// equal to 'values' and all other input values equal to 0.0 for the 
+// NeuraNet 'that', and memorize the result in 'output'
+// 'iInputs' and 'values' have same dimension, 'iInputs' has no 
+// duplicate
+// The evaluation starts from the evaluation for all input values 
+// equal to 0.0 memorized in 'state', and only the groups of links 
+// affected by the non null inputs are re-evaluated
+// Hidden values are re-evaluated from their first affected group, 
+// hence are exactly the same as NNEval, output values are updated 
+// with the difference of product of their affected groups, hence are 
+// the same as NNEval up to the rounding errors on float
+// If the links of the NeuraNet are not sorted as done by NNSetLinks 
+// all the links are re-evaluated
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+void NNEvalSparse(const NeuraNet* const that, NNEvalState* const state,
+  const VecLong* const iInputs, const VecFloat* const values,
+  VecFloat* const output) {
+#if BUILDMODE == 0
+  NNEvalStateCheckArg(that, state, iInputs, values, output);
+  if (that->_links != NULL && that->_dstArena == NULL) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'that' has no plan per destination (see NNSetPlanPerDst)");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare variables for optimization
+  long* nonZero = state->_nonZero->_val;
+  // If the reference evaluation is not the one for all input values 
+  // equal to 0.0 due to NNEvalDelta
+  if (state->_nbNonZero == -1) {
+    // Reset the reference evaluation
+    NNEvalStateReset(state, that);
+  // Else, the reference evaluation is the one for all input values 
+  // equal to 0.0
+  } else {
+    // Restore it by resetting the inputs, hidden values and output 
+    // values modified by the previous call
+    for (long i = 0; i < state->_nbNonZero; ++i)
+      VecSet(state->_input, nonZero[i], 0.0);
+    NNEvalStateRestore(that, state);
+  }
+  // Set the inputs of this call and memorize them
+  state->_nbNonZero = 0;
+  for (long i = 0; i < VecGetDim(iInputs); ++i) {
+    float val = VecGet(values, i);
+    // If the value is exactly the one of the reference evaluation 
+    // (bitwise, to be exactly the same as NNEval), skip it
+    float zero = 0.0;
+    if (memcmp(&val, &zero, sizeof(float)) == 0)
+      continue;
+    long iInput = VecGet(iInputs, i);
+    VecSet(state->_input, iInput, val);
+    nonZero[(state->_nbNonZero)++] = iInput;
+  }
+  // If the levels are unavailable, or the links are still implicit in
+  // a convolution NeuraNet
+  if (!NNHasPlanPerDst(that)) {
+    // Re-evaluate all the links
+    NNEvalWithHidden(that, state->_hidVal, state->_input, 
+      state->_output);
+  } else {
+    // Update the values affected by the inputs
+    for (long i = 0; i < state->_nbNonZero; ++i)
+      NNEvalStateTouch(that, state, nonZero[i], false);
+    NNEvalStatePropagate(that, state, false);
+  }
+  // Copy the output values
+  VecCopy(output, state->_output);
+}
+
+// Set the input values of index 'iInputs' of the last evaluation 
+// memorized in the NNEvalState 'state' to 'values' and calculate the 
+// output values of the NeuraNet 'that', memorized in 'output'
+// 'iInputs' and 'values' have same dimension
+// The last evaluation becomes the reference evaluation and only the 
+// groups of links affected by the modified inputs are re-evaluated
+// Hidden values are re-evaluated from their first affected group, 
+// hence are exactly the same as NNEval, output values are updated 
+// with the difference of product of their affected groups, hence are 
+// the same as NNEval up to the rounding errors on float. To avoid the 
+// accumulation of these errors, an output value is re-evaluated from 
+// all its groups once it has been updated NN_DELTAREFRESH times
+// If the links of the NeuraNet are not sorted as done by NNSetLinks 
+// all the links are re-evaluated
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+void NNEvalDelta(const NeuraNet* const that, NNEvalState* const state,
+  const VecLong* const iInputs, const VecFloat* const values,
+  VecFloat* const output) {
+#if BUILDMODE == 0
+  NNEvalStateCheckArg(that, state, iInputs, values, output);
+  if (that->_links != NULL && that->_dstArena == NULL) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'that' has no plan per destination (see NNSetPlanPerDst)");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare a flag to memorize if the levels are available and the 
+  // links explicit
+  bool hasLevel = NNHasPlanPerDst(that);
+  // If the last evaluation was done by NNEvalSparse, its inputs 
+  // differ from the reference evaluation
+  if (state->_nbNonZero > 0 && hasLevel) {
+    // Restore the hidden values and output values of the reference 
+    // evaluation, and update it with the inputs of NNEvalSparse
+    NNEvalStateRestore(that, state);
+    for (long i = 0; i < state->_nbNonZero; ++i)
+      NNEvalStateTouch(that, state, VecGet(state->_nonZero, i), true);
+  }
+  // The reference evaluation is now the last evaluation
+  state->_nbNonZero = -1;
+  state->_nbTouched = 0;
+  // Set the modified inputs
+  for (long i = 0; i < VecGetDim(iInputs); ++i) {
+    long iInput = VecGet(iInputs, i);
+    float val = VecGet(values, i);
+    // If the value is unchanged (bitwise, to be exactly the same as 
+    // NNEval), skip it
+    float cur = VecGet(state->_input, iInput);
+    if (memcmp(&cur, &val, sizeof(float)) == 0)
+      continue;
+    VecSet(state->_input, iInput, val);
+    // Update the values affected by the input
+    if (hasLevel)
+      NNEvalStateTouch(that, state, iInput, true);
+  }
+  // If the levels are unavailable
+  if (!hasLevel) {
+    // Re-evaluate all the links
+    NNEvalWithHidden(that, state->_hidVal, state->_input, 
+      state->_output);
+  } else {
+    // Update the hidden values affected by the inputs
+    NNEvalStatePropagate(that, state, true);
+    // Re-evaluate from all their groups the output values updated too
+    // many times
+    long nbHid = NNGetNbMaxHidden(that);
+    for (long iOut = 0; iOut < NNGetNbOutput(that); ++iOut) {
+      if (VecGet(state->_nbOutputUpdate, iOut) >= NN_DELTAREFRESH) {
+        NNEvalStateUpdateDst(that, state, nbHid + iOut,
+          VecGet(that->_dstGroupStart, nbHid + iOut), true);
+        VecSet(state->_nbOutputUpdate, iOut, 0);
+      }
+    }
+  }
+  VecCopy(state->_refOutput, state->_output);
+  // Copy the output values
+  VecCopy(output, state->_output);
+}
+
+// ----- NeuraNet evaluation kernels
+
+// Each kernel provides the loops on the 'nb' samples of a tile in 
+// NNEvalBatch:
+// LinkInit: prod[i] = slope * x[i] + offset
+// LinkMul: prod[i] *= slope * x[i] + offset
+// AddHidden: out[i] = min(1, max(-1, out[i] + prod[i]))
+// AddOutput: out[i] += prod[i]
+// LinkAddHidden: out[i] = min(1, max(-1, out[i] + slope * x[i] + offset))
+// LinkAddOutput: out[i] += slope * x[i] + offset
+// LinkAddHidden and LinkAddOutput evaluate groups made of one link, 
+// as in the dense layers, and give the same results as LinkInit 
+// followed by AddHidden or AddOutput
+// LaneLinkInit and LaneLinkMul provide the loops on the 'nb' samples 
+// of a tile and the NN_POPTILE candidates of a tile in 
+// NNPopulationEval, each candidate 'l' having its own base function, 
+// x[i][l] being x[i] for all the candidates if 'isLaneX' is false:
+// LaneLinkInit: prod[i][l] = slope[l] * x[i][l] + offset[l]
+// LaneLinkMul: prod[i][l] *= slope[l] * x[i][l] + offset[l]
+// The scalar and SSE kernels give the same results as NNEval, the 
+// AVX2 and AVX-512 kernels use fused multiply-add and may differ on 
+// the last bit of each link evaluation
+
+typedef struct NNKernels {
+  void (*_linkInit)(float* const prod, const float* const x, 
+    const float slope, const float offset, const long nb);
+  void (*_linkMul)(float* const prod, const float* const x, 
+    const float slope, const float offset, const long nb);
+  void (*_addHidden)(float* const out, const float* const prod, 
+    const long nb);
+  void (*_addOutput)(float* const out, const float* const prod, 
+    const long nb);
+  void (*_linkAddHidden)(float* const out, const float* const x, 
+    const float slope, const float offset, const long nb);
+  void (*_linkAddOutput)(float* const out, const float* const x, 
+    const float slope, const float offset, const long nb);
+  void (*_laneLinkInit)(float* const prod, const float* const x, 
+    const bool isLaneX, const float* const slope, 
+    const float* const offset, const long nb);
+  void (*_laneLinkMul)(float* const prod, const float* const x, 
+    const bool isLaneX, const float* const slope, 
+    const float* const offset, const long nb);
+} NNKernels;
+
+void NNKernelScalarLinkInit(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    prod[i] = slope * x[i] + offset;
+}
+
+void NNKernelScalarLinkMul(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    prod[i] *= slope * x[i] + offset;
+}
+
+void NNKernelScalarAddHidden(float* const out, const float* const prod, 
+  const long nb) {
+  for (long i = 0; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + prod[i]));
+}
+
+void NNKernelScalarAddOutput(float* const out, const float* const prod, 
+  const long nb) {
+  for (long i = 0; i < nb; ++i)
+    out[i] += prod[i];
+}
+
+void NNKernelScalarLinkAddHidden(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + (slope * x[i] + offset)));
+}
+
+void NNKernelScalarLinkAddOutput(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    out[i] += slope * x[i] + offset;
+}
+
+void NNKernelScalarLaneLinkInit(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    for (long l = 0; l < NN_POPTILE; ++l)
+      prod[i * NN_POPTILE + l] = slope[l] * 
+        (isLaneX ? x[i * NN_POPTILE + l] : x[i]) + offset[l];
+}
+void NNKernelScalarLaneLinkMul(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i)
+    for (long l = 0; l < NN_POPTILE; ++l)
+      prod[i * NN_POPTILE + l] *= slope[l] * 
+        (isLaneX ? x[i * NN_POPTILE + l] : x[i]) + offset[l];
+}
+#ifdef NN_X86
+
+__attribute__((target("sse")))
+void NNKernelSSELinkInit(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m128 s = _mm_set1_ps(slope);
+  __m128 o = _mm_set1_ps(offset);
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(prod + i, 
+      _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(x + i)), o));
+  for (; i < nb; ++i)
+    prod[i] = slope * x[i] + offset;
+}
+
+__attribute__((target("sse")))
+void NNKernelSSELinkMul(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m128 s = _mm_set1_ps(slope);
+  __m128 o = _mm_set1_ps(offset);
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(prod + i, _mm_mul_ps(_mm_loadu_ps(prod + i),
+      _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(x + i)), o)));
+  for (; i < nb; ++i)
+    prod[i] *= slope * x[i] + offset;
+}
+
+__attribute__((target("sse")))
+void NNKernelSSEAddHidden(float* const out, const float* const prod, 
+  const long nb) {
+  __m128 one = _mm_set1_ps(1.0);
+  __m128 minusOne = _mm_set1_ps(-1.0);
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(out + i, _mm_min_ps(one, _mm_max_ps(minusOne, 
+      _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(prod + i)))));
+  for (; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + prod[i]));
+}
+
+__attribute__((target("sse")))
+void NNKernelSSEAddOutput(float* const out, const float* const prod, 
+  const long nb) {
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(out + i, 
+      _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(prod + i)));
+  for (; i < nb; ++i)
+    out[i] += prod[i];
+}
+
+__attribute__((target("sse")))
+void NNKernelSSELinkAddHidden(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m128 s = _mm_set1_ps(slope);
+  __m128 o = _mm_set1_ps(offset);
+  __m128 one = _mm_set1_ps(1.0);
+  __m128 minusOne = _mm_set1_ps(-1.0);
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(out + i, _mm_min_ps(one, _mm_max_ps(minusOne, 
+      _mm_add_ps(_mm_loadu_ps(out + i), 
+      _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(x + i)), o)))));
+  for (; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + (slope * x[i] + offset)));
+}
+
+__attribute__((target("sse")))
+void NNKernelSSELinkAddOutput(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m128 s = _mm_set1_ps(slope);
+  __m128 o = _mm_set1_ps(offset);
+  long i = 0;
+  for (; i + 4 <= nb; i += 4)
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), 
+      _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(x + i)), o)));
+  for (; i < nb; ++i)
+    out[i] += slope * x[i] + offset;
+}
+
+__attribute__((target("sse")))
+void NNKernelSSELaneLinkInit(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m128 xx = _mm_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 4) {
+      if (isLaneX)
+        xx = _mm_loadu_ps(x + i * NN_POPTILE + l);
+      _mm_storeu_ps(prod + i * NN_POPTILE + l, _mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(slope + l), xx), 
+        _mm_loadu_ps(offset + l)));
+    }
+  }
+}
+__attribute__((target("sse")))
+void NNKernelSSELaneLinkMul(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m128 xx = _mm_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 4) {
+      if (isLaneX)
+        xx = _mm_loadu_ps(x + i * NN_POPTILE + l);
+      _mm_storeu_ps(prod + i * NN_POPTILE + l, _mm_mul_ps(
+        _mm_loadu_ps(prod + i * NN_POPTILE + l), _mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(slope + l), xx), 
+        _mm_loadu_ps(offset + l))));
+    }
+  }
+}
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LinkInit(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m256 s = _mm256_set1_ps(slope);
+  __m256 o = _mm256_set1_ps(offset);
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(prod + i, 
+      _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), o));
+  for (; i < nb; ++i)
+    prod[i] = fmaf(slope, x[i], offset);
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LinkMul(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m256 s = _mm256_set1_ps(slope);
+  __m256 o = _mm256_set1_ps(offset);
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(prod + i, _mm256_mul_ps(_mm256_loadu_ps(prod + i),
+      _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), o)));
+  for (; i < nb; ++i)
+    prod[i] *= fmaf(slope, x[i], offset);
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2AddHidden(float* const out, const float* const prod, 
+  const long nb) {
+  __m256 one = _mm256_set1_ps(1.0);
+  __m256 minusOne = _mm256_set1_ps(-1.0);
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_min_ps(one, _mm256_max_ps(minusOne, 
+      _mm256_add_ps(_mm256_loadu_ps(out + i), 
+      _mm256_loadu_ps(prod + i)))));
+  for (; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + prod[i]));
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2AddOutput(float* const out, const float* const prod, 
+  const long nb) {
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(out + i, 
+      _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(prod + i)));
+  for (; i < nb; ++i)
+    out[i] += prod[i];
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LinkAddHidden(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m256 s = _mm256_set1_ps(slope);
+  __m256 o = _mm256_set1_ps(offset);
+  __m256 one = _mm256_set1_ps(1.0);
+  __m256 minusOne = _mm256_set1_ps(-1.0);
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_min_ps(one, _mm256_max_ps(minusOne, 
+      _mm256_add_ps(_mm256_loadu_ps(out + i), 
+      _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), o)))));
+  for (; i < nb; ++i)
+    out[i] = MIN(1.0, MAX(-1.0, out[i] + fmaf(slope, x[i], offset)));
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LinkAddOutput(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m256 s = _mm256_set1_ps(slope);
+  __m256 o = _mm256_set1_ps(offset);
+  long i = 0;
+  for (; i + 8 <= nb; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), 
+      _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), o)));
+  for (; i < nb; ++i)
+    out[i] += fmaf(slope, x[i], offset);
+}
+
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LaneLinkInit(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m256 xx = _mm256_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 8) {
+      if (isLaneX)
+        xx = _mm256_loadu_ps(x + i * NN_POPTILE + l);
+      _mm256_storeu_ps(prod + i * NN_POPTILE + l, _mm256_fmadd_ps(
+        _mm256_loadu_ps(slope + l), xx, _mm256_loadu_ps(offset + l)));
+    }
+  }
+}
+__attribute__((target("avx2,fma")))
+void NNKernelAVX2LaneLinkMul(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m256 xx = _mm256_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 8) {
+      if (isLaneX)
+        xx = _mm256_loadu_ps(x + i * NN_POPTILE + l);
+      _mm256_storeu_ps(prod + i * NN_POPTILE + l, _mm256_mul_ps(
+        _mm256_loadu_ps(prod + i * NN_POPTILE + l), _mm256_fmadd_ps(
+        _mm256_loadu_ps(slope + l), xx, _mm256_loadu_ps(offset + l))));
+    }
+  }
+}
+// The AVX-512 kernels process the remaining samples with masked 
+// loads and stores
+__attribute__((target("avx512f")))
+void NNKernelAVX512LinkInit(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m512 s = _mm512_set1_ps(slope);
+  __m512 o = _mm512_set1_ps(offset);
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(prod + i, m, 
+      _mm512_fmadd_ps(s, _mm512_maskz_loadu_ps(m, x + i), o));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512LinkMul(float* const prod, const float* const x, 
+  const float slope, const float offset, const long nb) {
+  __m512 s = _mm512_set1_ps(slope);
+  __m512 o = _mm512_set1_ps(offset);
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(prod + i, m, 
+      _mm512_mul_ps(_mm512_maskz_loadu_ps(m, prod + i),
+      _mm512_fmadd_ps(s, _mm512_maskz_loadu_ps(m, x + i), o)));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512AddHidden(float* const out, const float* const prod, 
+  const long nb) {
+  __m512 one = _mm512_set1_ps(1.0);
+  __m512 minusOne = _mm512_set1_ps(-1.0);
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, m, _mm512_min_ps(one, 
+      _mm512_max_ps(minusOne, _mm512_add_ps(
+      _mm512_maskz_loadu_ps(m, out + i), 
+      _mm512_maskz_loadu_ps(m, prod + i)))));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512AddOutput(float* const out, const float* const prod, 
+  const long nb) {
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, m, _mm512_add_ps(
+      _mm512_maskz_loadu_ps(m, out + i), 
+      _mm512_maskz_loadu_ps(m, prod + i)));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512LinkAddHidden(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m512 s = _mm512_set1_ps(slope);
+  __m512 o = _mm512_set1_ps(offset);
+  __m512 one = _mm512_set1_ps(1.0);
+  __m512 minusOne = _mm512_set1_ps(-1.0);
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, m, _mm512_min_ps(one, 
+      _mm512_max_ps(minusOne, _mm512_add_ps(
+      _mm512_maskz_loadu_ps(m, out + i), 
+      _mm512_fmadd_ps(s, _mm512_maskz_loadu_ps(m, x + i), o)))));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512LinkAddOutput(float* const out, const float* const x,
+  const float slope, const float offset, const long nb) {
+  __m512 s = _mm512_set1_ps(slope);
+  __m512 o = _mm512_set1_ps(offset);
+  for (long i = 0; i < nb; i += 16) {
+    __mmask16 m = (nb - i >= 16 ? 0xFFFF : (1 << (nb - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, m, _mm512_add_ps(
+      _mm512_maskz_loadu_ps(m, out + i), 
+      _mm512_fmadd_ps(s, _mm512_maskz_loadu_ps(m, x + i), o)));
+  }
+}
+
+__attribute__((target("avx512f")))
+void NNKernelAVX512LaneLinkInit(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m512 xx = _mm512_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 16) {
+      if (isLaneX)
+        xx = _mm512_loadu_ps(x + i * NN_POPTILE + l);
+      _mm512_storeu_ps(prod + i * NN_POPTILE + l, _mm512_fmadd_ps(
+        _mm512_loadu_ps(slope + l), xx, _mm512_loadu_ps(offset + l)));
+    }
+  }
+}
+__attribute__((target("avx512f")))
+void NNKernelAVX512LaneLinkMul(float* const prod, 
+  const float* const x, const bool isLaneX, const float* const slope, 
+  const float* const offset, const long nb) {
+  for (long i = 0; i < nb; ++i) {
+    __m512 xx = _mm512_set1_ps(x[i]);
+    for (long l = 0; l < NN_POPTILE; l += 16) {
+      if (isLaneX)
+        xx = _mm512_loadu_ps(x + i * NN_POPTILE + l);
+      _mm512_storeu_ps(prod + i * NN_POPTILE + l, _mm512_mul_ps(
+        _mm512_loadu_ps(prod + i * NN_POPTILE + l), _mm512_fmadd_ps(
+        _mm512_loadu_ps(slope + l), xx, _mm512_loadu_ps(offset + l))));
+    }
+  }
+}
+#endif
+
+// Table of the kernels, indexed by NNEvalKernel
+const NNKernels NNKernelsTable[NN_NBEVALKERNEL] = {
+  {NNKernelScalarLinkInit, NNKernelScalarLinkMul, 
+    NNKernelScalarAddHidden, NNKernelScalarAddOutput,
+    NNKernelScalarLinkAddHidden, NNKernelScalarLinkAddOutput,
+    NNKernelScalarLaneLinkInit, NNKernelScalarLaneLinkMul},
+#ifdef NN_X86
+  {NNKernelSSELinkInit, NNKernelSSELinkMul, 
+    NNKernelSSEAddHidden, NNKernelSSEAddOutput,
+    NNKernelSSELinkAddHidden, NNKernelSSELinkAddOutput,
+    NNKernelSSELaneLinkInit, NNKernelSSELaneLinkMul},
+  {NNKernelAVX2LinkInit, NNKernelAVX2LinkMul, 
+    NNKernelAVX2AddHidden, NNKernelAVX2AddOutput,
+    NNKernelAVX2LinkAddHidden, NNKernelAVX2LinkAddOutput,
+    NNKernelAVX2LaneLinkInit, NNKernelAVX2LaneLinkMul},
+  {NNKernelAVX512LinkInit, NNKernelAVX512LinkMul, 
+    NNKernelAVX512AddHidden, NNKernelAVX512AddOutput,
+    NNKernelAVX512LinkAddHidden, NNKernelAVX512LinkAddOutput,
+    NNKernelAVX512LaneLinkInit, NNKernelAVX512LaneLinkMul}
+#endif
+};
+
+// Currently selected kernel, initialised once by NNInitEvalKernel
+int NNCurEvalKernel = NNEvalKernelScalar;
+pthread_once_t NNEvalKernelOnce = PTHREAD_ONCE_INIT;
+
+// Return true if the kernel 'kernel' is supported by the CPU, false else
+bool NNIsEvalKernelSupported(const NNEvalKernel kernel) {
+  switch (kernel) {
+    case NNEvalKernelScalar:
+      return true;
+#ifdef NN_X86
+    case NNEvalKernelSSE:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse");
+    case NNEvalKernelAVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") && 
+        __builtin_cpu_supports("fma");
+    case NNEvalKernelAVX512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+// Helper function for NNGetEvalKernel and NNSetEvalKernel
+// Select the fastest kernel supported by the CPU
+void NNInitEvalKernel(void) {
+  int kernel = NN_NBEVALKERNEL - 1;
+  while (!NNIsEvalKernelSupported(kernel))
+    --kernel;
+  NNCurEvalKernel = kernel;
+}
+
+// Select the kernel 'kernel' for the evaluation of the loops on 
+// samples in NNEvalBatch
+// By default the fastest kernel supported by the CPU is used
+// Return true if the kernel is supported by the CPU and has been 
+// selected, false else
+bool NNSetEvalKernel(const NNEvalKernel kernel) {
+  // Initialise the default kernel first, so that it doesn't replace 
+  // later the selected kernel
+  pthread_once(&NNEvalKernelOnce, NNInitEvalKernel);
+  // If the kernel is not supported
+  if (!NNIsEvalKernelSupported(kernel))
+    // Leave the current kernel unchanged
+    return false;
+  // Select the kernel
+  NNCurEvalKernel = kernel;
+  // Return the success code
+  return true;
+}
+
+// Get the kernel currently used for the evaluation of the loops on 
+// samples in NNEvalBatch
+NNEvalKernel NNGetEvalKernel(void) {
+  // Select the default kernel at the first call, only once even if 
+  // called concurrently
+  pthread_once(&NNEvalKernelOnce, NNInitEvalKernel);
+  // Return the current kernel
+  return NNCurEvalKernel;
+}
+
+// Helper function for NNEvalBatchWithTile
+// Evaluate the tile of 'nb' samples of the NeuraNet 'that' made of 
+// dense layers, with the kernels 'kernels'
+// 'in' are the input values of the tile, organised per value with a
+// stride 'strideIn', 'tileHid' and 'tileOut' are the hidden and output
+// values of the tile organised per value with a stride NN_BATCHTILE
+// The destination values of a layer are evaluated by blocks of 
+// NN_DENSEBLOCK values, so that the block stays in cache while the 
+// links from all the values of the previous layer are added to it, 
+// the same way a matrix multiplication is blocked
+void NNEvalBatchDenseTile(const NeuraNet* const that, 
+  const NNKernels* const kernels, const float* const in, 
+  const long strideIn, float* const tileHid, float* const tileOut, 
+  const long nb) {
+  // Declare variables for optimization
+  long nbLayer = VecGetDim(that->_layers);
+  const float* coeffs = that->_basesCoeff->_val;
+  const float* x = in;
+  long strideX = strideIn;
+  float* hid = tileHid;
+  // Loop on the layers
+  for (long iLayer = 0; iLayer < nbLayer - 1; ++iLayer) {
+    long nbIn = VecGet(that->_layers, iLayer);
+    long nbOut = VecGet(that->_layers, iLayer + 1);
+    bool isOutput = (iLayer == nbLayer - 2);
+    float* y = (isOutput ? tileOut : hid);
+    // Loop on the blocks of destination values
+    for (long iStart = 0; iStart < nbOut; iStart += NN_DENSEBLOCK) {
+      long iEnd = MIN(nbOut, iStart + NN_DENSEBLOCK);
+      // Loop on the values of the previous layer, in the same order 
+      // as NNEval
+      for (long iIn = 0; iIn < nbIn; ++iIn) {
+        const float* xIn = x + iIn * strideX;
+        const float* coeff = coeffs + (iIn * nbOut) * NN_NBCOEFFBASE;
+        // Loop on the destination values of the block
+        for (long iOut = iStart; iOut < iEnd; ++iOut) {
+          if (isOutput)
+            kernels->_linkAddOutput(y + iOut * NN_BATCHTILE, xIn, 
+              coeff[iOut * NN_NBCOEFFBASE], 
+              coeff[iOut * NN_NBCOEFFBASE + 1], nb);
+          else
+            kernels->_linkAddHidden(y + iOut * NN_BATCHTILE, xIn, 
+              coeff[iOut * NN_NBCOEFFBASE], 
+              coeff[iOut * NN_NBCOEFFBASE + 1], nb);
+        }
+      }
+    }
+    // Step to the next layer
+    coeffs += nbIn * nbOut * NN_NBCOEFFBASE;
+    x = y;
+    strideX = NN_BATCHTILE;
+    hid += nbOut * NN_BATCHTILE;
+  }
+}
+
+// Helper function for NNEvalBatchWithTile
+// Evaluate the 'nbSample' samples of 'inputs' for the convolution 
+// NeuraNet 'that' whose links are implicit, one sample after the 
+// other with the convolution kernel as NNEval does, and memorize the 
+// result in 'outputs'
+// 'tile' is the scratch memory of NNEvalBatchWithTile, it holds the 
+// scratch memory of NNEvalConv followed by the input, hidden and 
+// output values of one sample
+// The links are not expanded, hence the NeuraNet is not modified
+void NNEvalBatchConv(const NeuraNet* const that, float* const tile, 
+  const long nbSample, const VecFloat* const inputs, 
+  const NNBatchLayout layout, VecFloat* const outputs) {
+  // Declare variables for optimization
+  long nbIn = NNGetNbInput(that);
+  long nbOut = NNGetNbOutput(that);
+  // The scratch memory of NNEvalConv is at the beginning of the tile 
+  // to keep its longs aligned
+  long* buffer = (long*)tile;
+  float* val = tile + 
+    NNGetConvBufferSize(that) * sizeof(long) / sizeof(float);
+  float* hid = (NNGetNbMaxHidden(that) > 0 ? val + nbIn : NULL);
+  float* out = val + nbIn + NNGetNbMaxHidden(that);
+  // Loop on the samples
+  for (long iSample = 0; iSample < nbSample; ++iSample) {
+    // Get the input values of the sample, directly in the inputs if 
+    // the samples are organised per row, else gathered in the tile
+    const float* in = inputs->_val + iSample * nbIn;
+    if (layout == NNBatchColMajor) {
+      for (long iIn = 0; iIn < nbIn; ++iIn)
+        val[iIn] = inputs->_val[iIn * nbSample + iSample];
+      in = val;
+    }
+    // Evaluate the sample
+    NNEvalConv(that, buffer, hid, in, out);
+    // Copy the output values of the sample into the result
+    for (long iOut = 0; iOut < nbOut; ++iOut)
+      if (layout == NNBatchRowMajor)
+        outputs->_val[iSample * nbOut + iOut] = out[iOut];
+      else
+        outputs->_val[iOut * nbSample + iSample] = out[iOut];
+  }
+}
+
+// Helper function for NNEvalBatch and NNEvalBatchCtx
+// 'tileIn' is a scratch memory of NNGetBatchTileSize(that) floats
+void NNEvalBatchWithTile(const NeuraNet* const that, 
+  float* const tileIn, const long nbSample,
+  const VecFloat* const inputs, const NNBatchLayout layout, 
+  VecFloat* const outputs) {
+  // If the NeuraNet is a convolution network whose links are implicit
+  if (that->_links == NULL) {
+    // Evaluate the samples with the convolution kernel
+    NNEvalBatchConv(that, tileIn, nbSample, inputs, layout, outputs);
+    return;
+  }
+  // Declare variables for optimization
+  long nbIn = NNGetNbInput(that);
+  long nbHid = NNGetNbMaxHidden(that);
+  long nbOut = NNGetNbOutput(that);
+  long startOut = nbIn + nbHid;
+  int width = that->_packedWidth;
+  const float* coeffs = that->_basesCoeff->_val;
+  const NNKernels* kernels = NNKernelsTable + NNGetEvalKernel();
+  // Split the scratch memory into the values of a tile of samples, 
+  // organised per value (NN_BATCHTILE consecutive floats per value) 
+  // and the product of the links of a group
+  float* tileHid = tileIn + NN_BATCHTILE * nbIn;
+  float* tileOut = tileHid + NN_BATCHTILE * nbHid;
+  float* prod = tileOut + NN_BATCHTILE * nbOut;
+  // Loop on tiles of samples
+  for (long iStart = 0; iStart < nbSample; iStart += NN_BATCHTILE) {
+    // Get the nb of samples in this tile
+    long nb = MIN(NN_BATCHTILE, nbSample - iStart);
+    // Declare a variable to memorize the input values of the tile, 
+    // organised per value, and their stride
+    const float* in = tileIn;
+    long strideIn = NN_BATCHTILE;
+    // If the samples are organised per row, transpose the input values 
+    // of the tile, else use them directly
+    if (layout == NNBatchRowMajor) {
+      for (long iSample = 0; iSample < nb; ++iSample) {
+        const float* sample = inputs->_val + (iStart + iSample) * nbIn;
+        for (long iIn = 0; iIn < nbIn; ++iIn)
+          tileIn[iIn * NN_BATCHTILE + iSample] = sample[iIn];
+      }
+    } else {
+      in = inputs->_val + iStart;
+      strideIn = nbSample;
+    }
+    // Reset the hidden values and outputs of the tile
+    memset(tileHid, 0, sizeof(float) * NN_BATCHTILE * (nbHid + nbOut));
+    // If the NeuraNet is made of dense layers
+    if (that->_layers != NULL) {
+      // Evaluate the tile with the dense kernel
+      NNEvalBatchDenseTile(that, kernels, in, strideIn, tileHid, 
+        tileOut, nb);
+    // Else, evaluate the tile with the execution plan
+    } else {
+      // Loop on the groups of links in the execution plan
+      long iLink = 0;
+      for (long iGroup = 0; iGroup < that->_nbPackedGroups; ++iGroup) {
+        long idIn = NNPackedGet(that->_packedPlan, width, 3 * iGroup);
+        long idOut = 
+          NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+        long iEnd = 
+          iLink + NNPackedGet(that->_packedPlan, width, 3 * iGroup + 2);
+        // Get the input values of the group
+        const float* x = (idIn < nbIn ? in + idIn * strideIn : 
+          tileHid + (idIn - nbIn) * NN_BATCHTILE);
+        // Multiply the evaluation of the links of the group, the first
+        // link initialises the product
+        for (bool isFirst = true; iLink < iEnd; ++iLink) {
+          const float* coeff = 
+            coeffs + NNGetPackedBase(that, iLink) * NN_NBCOEFFBASE;
+          if (isFirst)
+            kernels->_linkInit(prod, x, coeff[0], coeff[1], nb);
+          else
+            kernels->_linkMul(prod, x, coeff[0], coeff[1], nb);
+          isFirst = false;
+        }
+        // Add the result to the output values of the group, clamped to 
+        // [-1,1] if they are hidden values
+        if (idOut < startOut)
+          kernels->_addHidden(tileHid + (idOut - nbIn) * NN_BATCHTILE, 
+            prod, nb);
+        else
+          kernels->_addOutput(
+            tileOut + (idOut - startOut) * NN_BATCHTILE, prod, nb);
+      }
+    }
+    // Copy the output values of the tile into the result
+    for (long iOut = 0; iOut < nbOut; ++iOut) {
+      const float* out = tileOut + iOut * NN_BATCHTILE;
+      for (long iSample = 0; iSample < nb; ++iSample)
+        if (layout == NNBatchRowMajor)
+          outputs->_val[(iStart + iSample) * nbOut + iOut] = out[iSample];
+        else
+          outputs->_val[iOut * nbSample + iStart + iSample] = out[iSample];
+    }
+  }
+}
+
+// Calculate the output values for the 'nbSample' samples of input 
+// values 'inputs' for the NeuraNet 'that' and memorize the result in 
+// 'outputs'
+// 'inputs' is of dimension nbSample * nbInput, 'outputs' of dimension
+// nbSample * nbOutput, both organised according to 'layout'
+// The results are the same as calling NNEval on each sample, but 
+// links are evaluated in the outer loop and samples in the inner loop,
+// by tiles of NN_BATCHTILE samples
+// The hidden values of the NeuraNet are not modified
+void NNEvalBatch(const NeuraNet* const that, const long nbSample,
+  const VecFloat* const inputs, const NNBatchLayout layout, 
+  VecFloat* const outputs) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (inputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'inputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (outputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'outputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nbSample < 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbSample' is invalid (0<=%ld)", 
+      nbSample);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(inputs) != nbSample * that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'inputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(inputs), nbSample * that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(outputs) != nbSample * that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'outputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(outputs), nbSample * that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Allocate the scratch memory
+  float* tile = PBErrMalloc(NeuraNetErr, 
+    sizeof(float) * NNGetBatchTileSize(that));
+  // Evaluate the samples
+  NNEvalBatchWithTile(that, tile, nbSample, inputs, layout, outputs);
+  // Free memory
+  free(tile);
+}
+
+// Same as NNEvalBatch but use the NNEvalContext 'ctx' as scratch 
+// memory instead of allocating it at each call
+void NNEvalBatchCtx(const NeuraNet* const that, 
+  NNEvalContext* const ctx, const long nbSample,
+  const VecFloat* const inputs, const NNBatchLayout layout, 
+  VecFloat* const outputs) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (ctx == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'ctx' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(ctx->_tile) != NN_BATCHTILE * (that->_nbInputVal + 
+    that->_nbMaxHidVal + that->_nbOutputVal + 1)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'ctx' doesn't match the dimensions of the NeuraNet");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (inputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'inputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (outputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'outputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nbSample < 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbSample' is invalid (0<=%ld)", 
+      nbSample);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(inputs) != nbSample * that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'inputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(inputs), nbSample * that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(outputs) != nbSample * that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'outputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(outputs), nbSample * that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Evaluate the samples using the scratch memory of the context
+  NNEvalBatchWithTile(that, ctx->_tile->_val, nbSample, inputs, layout, 
+    outputs);
+}
+
+// Create a new NNPopulation of 'nbCandidate' candidates sharing the 
+// links of the NeuraNet 'that', all initialised with the base 
+// functions of 'that'
+NNPopulation* NNPopulationCreate(const NeuraNet* const that, 
+  const long nbCandidate) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nbCandidate <= 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbCandidate' is invalid (0<%ld)", 
+      nbCandidate);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare the new NNPopulation
+  NNPopulation* pop = PBErrMalloc(NeuraNetErr, sizeof(NNPopulation));
+  // Set properties, the links of the clone are expanded if they are 
+  // implicit
+  pop->_nn = NNClone(that);
+  NNExpandLinks(pop->_nn);
+  *(long*)&(pop->_nbCandidate) = nbCandidate;
+  long nbTile = (nbCandidate + NN_POPTILE - 1) / NN_POPTILE;
+  pop->_basesCoeff = VecFloatCreate(nbTile * NNGetNbMaxBases(that) * 
+    NN_NBCOEFFBASE * NN_POPTILE);
+  for (long iCandidate = nbCandidate; iCandidate--;)
+    NNPopulationSetBases(pop, iCandidate, NNBases(that));
+  // Return the new NNPopulation
+  return pop;
+}
+
+// Free the memory used by the NNPopulation 'that'
+void NNPopulationFree(NNPopulation** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  NeuraNetFree(&((*that)->_nn));
+  VecFree(&((*that)->_basesCoeff));
+  free(*that);
+  *that = NULL;
+}
+
+// Set the parameters of the base functions of the 'iCandidate'-th 
+// candidate of the NNPopulation 'that' to 'bases'
+void NNPopulationSetBases(NNPopulation* const that, 
+  const long iCandidate, const VecFloat* const bases) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (bases == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'bases' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (iCandidate < 0 || iCandidate >= that->_nbCandidate) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'iCandidate' is invalid (0<=%ld<%ld)", 
+      iCandidate, that->_nbCandidate);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(bases) != 
+    NNGetNbMaxBases(that->_nn) * NN_NBPARAMBASE) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'bases' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(bases), NNGetNbMaxBases(that->_nn) * NN_NBPARAMBASE);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare variables for optimization
+  long nbBases = NNGetNbMaxBases(that->_nn);
+  float* coeffs = that->_basesCoeff->_val + 
+    iCandidate / NN_POPTILE * nbBases * NN_NBCOEFFBASE * NN_POPTILE + 
+    iCandidate % NN_POPTILE;
+  // Loop on the base functions
+  for (long iBase = nbBases; iBase--;) {
+    // Calculate the slope and offset as NNUpdateBaseCoeff
+    NNBaseFunCoeff(bases->_val + iBase * NN_NBPARAMBASE, 
+      coeffs + iBase * NN_NBCOEFFBASE * NN_POPTILE,
+      coeffs + (iBase * NN_NBCOEFFBASE + 1) * NN_POPTILE);
+  }
+}
+
+// Calculate the output values of each candidate of the NNPopulation 
+// 'that' for the 'nbSample' samples of input values 'inputs' and 
+// memorize the result in 'outputs'
+void NNPopulationEval(const NNPopulation* const that, 
+  const long nbSample, const VecFloat* const inputs, 
+  const NNBatchLayout layout, VecFloat* const outputs) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (inputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'inputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (outputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'outputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nbSample < 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbSample' is invalid (0<=%ld)", 
+      nbSample);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(inputs) != nbSample * NNGetNbInput(that->_nn)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'inputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(inputs), nbSample * NNGetNbInput(that->_nn));
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(outputs) != 
+    that->_nbCandidate * nbSample * NNGetNbOutput(that->_nn)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'outputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(outputs), 
+      that->_nbCandidate * nbSample * NNGetNbOutput(that->_nn));
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare variables for optimization
+  const NeuraNet* nn = that->_nn;
+  long nbIn = NNGetNbInput(nn);
+  long nbHid = NNGetNbMaxHidden(nn);
+  long nbOut = NNGetNbOutput(nn);
+  long nbCoeff = NNGetNbMaxBases(nn) * NN_NBCOEFFBASE * NN_POPTILE;
+  long startOut = nbIn + nbHid;
+  int width = nn->_packedWidth;
+  const NNKernels* kernels = NNKernelsTable + NNGetEvalKernel();
+  // Allocate the scratch memory, the input values of a tile of 
+  // samples organised per value (NN_BATCHTILE consecutive floats per 
+  // value), the hidden and output values of a tile of samples for a 
+  // tile of candidates organised per value, then per sample 
+  // (NN_POPTILE consecutive floats per sample), and the product of 
+  // the links of a group
+  long sizeTile = NN_BATCHTILE * NN_POPTILE;
+  float* tileIn = PBErrMalloc(NeuraNetErr, sizeof(float) * 
+    (NN_BATCHTILE * nbIn + sizeTile * (nbHid + nbOut + 1)));
+  float* tileHid = tileIn + NN_BATCHTILE * nbIn;
+  float* tileOut = tileHid + sizeTile * nbHid;
+  float* prod = tileOut + sizeTile * nbOut;
+  // Get the stride between the input values of a sample and between 
+  // samples
+  long strideIn = (layout == NNBatchRowMajor ? 1 : nbSample);
+  long strideSample = (layout == NNBatchRowMajor ? nbIn : 1);
+  // Loop on tiles of samples
+  for (long iStart = 0; iStart < nbSample; iStart += NN_BATCHTILE) {
+    long nb = MIN(NN_BATCHTILE, nbSample - iStart);
+    // Copy the input values of the tile, shared by all the candidates
+    for (long iIn = 0; iIn < nbIn; ++iIn)
+      for (long i = 0; i < nb; ++i)
+        tileIn[iIn * NN_BATCHTILE + i] = 
+          inputs->_val[(iStart + i) * strideSample + iIn * strideIn];
+    // Loop on tiles of candidates
+    for (long iTile = 0; iTile * NN_POPTILE < that->_nbCandidate; 
+      ++iTile) {
+      const float* coeffs = that->_basesCoeff->_val + iTile * nbCoeff;
+      long nbCandidate = 
+        MIN(NN_POPTILE, that->_nbCandidate - iTile * NN_POPTILE);
+      // Reset the hidden values and outputs of the tile
+      memset(tileHid, 0, sizeof(float) * sizeTile * (nbHid + nbOut));
+      // Loop on the groups of links in the execution plan
+      long iLink = 0;
+      for (long iGroup = 0; iGroup < nn->_nbPackedGroups; ++iGroup) {
+        long idIn = NNPackedGet(nn->_packedPlan, width, 3 * iGroup);
+        long idOut = 
+          NNPackedGet(nn->_packedPlan, width, 3 * iGroup + 1);
+        long iEnd = 
+          iLink + NNPackedGet(nn->_packedPlan, width, 3 * iGroup + 2);
+        // Get the input values of the group, the same for all the 
+        // candidates if it's an input value
+        bool isLaneX = (idIn >= nbIn);
+        const float* x = (isLaneX ? 
+          tileHid + (idIn - nbIn) * sizeTile : 
+          tileIn + idIn * NN_BATCHTILE);
+        // Multiply the evaluation of the links of the group, the 
+        // first link initialises the product, the parameters of its 
+        // base function being loaded once for the whole tile
+        for (bool isFirst = true; iLink < iEnd; ++iLink) {
+          const float* coeff = coeffs + 
+            NNGetPackedBase(nn, iLink) * NN_NBCOEFFBASE * NN_POPTILE;
+          if (isFirst)
+            kernels->_laneLinkInit(prod, x, isLaneX, coeff, 
+              coeff + NN_POPTILE, nb);
+          else
+            kernels->_laneLinkMul(prod, x, isLaneX, coeff, 
+              coeff + NN_POPTILE, nb);
+          isFirst = false;
+        }
+        // Add the result to the output values of the group, clamped 
+        // to [-1,1] if they are hidden values
+        if (idOut < startOut)
+          kernels->_addHidden(tileHid + (idOut - nbIn) * sizeTile, 
+            prod, nb * NN_POPTILE);
+        else
+          kernels->_addOutput(tileOut + (idOut - startOut) * sizeTile, 
+            prod, nb * NN_POPTILE);
+      }
+      // Copy the output values of the tile into the result
+      for (long iCandidate = 0; iCandidate < nbCandidate; 
+        ++iCandidate) {
+        float* out = outputs->_val + 
+          (iTile * NN_POPTILE + iCandidate) * nbSample * nbOut;
+        for (long iOut = 0; iOut < nbOut; ++iOut)
+          for (long i = 0; i < nb; ++i) {
+            float val = 
+              tileOut[iOut * sizeTile + i * NN_POPTILE + iCandidate];
+            if (layout == NNBatchRowMajor)
+              out[(iStart + i) * nbOut + iOut] = val;
+            else
+              out[iOut * nbSample + iStart + i] = val;
+          }
+      }
+    }
+  }
+  // Free memory
+  free(tileIn);
+}
+
+// Helper function for NNQuantize, NNSaveAsC, NNPrintln, 
+// NNGetMutabilityBases and NNGetMutabilityLinks
+// Return a clone of the NeuraNet 'that' with its links expanded if 
+// they are implicit, null else
+// These functions work on the clone to leave 'that' unmodified
+NeuraNet* NNCloneWithExpandedLinks(const NeuraNet* const that) {
+  // If the links are already expanded there is no need for a clone
+  if (that->_links != NULL)
+    return NULL;
+  // Clone the NeuraNet and expand the links of the clone
+  NeuraNet* clone = NNClone(that);
+  NNExpandLinks(clone);
+  // Return the clone
+  return clone;
+}
+
+// Helper function for NNQuantize
+// Return the coefficient 'coeff' of a base function quantized to int16
+// with the shift 'shift'
+short NNQuantizeCoeff(const double coeff, const int shift) {
+  // Scale the coefficient, round it and saturate it to the int16 range
+  double q = round(ldexp(coeff, shift));
+  return (short)MIN(32767.0, MAX(-32767.0, q));
+}
+
+// Create a new NNQuantized, fixed-point copy of the current bases and
+// links of the NeuraNet 'that'
+// The NNQuantized must be created again to take into account later 
+// modifications of the NeuraNet
+NNQuantized* NNQuantize(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are implicit, quantize a clone with expanded links
+  NeuraNet* expanded = NNCloneWithExpandedLinks(that);
+  if (expanded != NULL) {
+    NNQuantized* q = NNQuantize(expanded);
+    NeuraNetFree(&expanded);
+    return q;
+  }
+  // Declare the new NNQuantized
+  NNQuantized* q = PBErrMalloc(NeuraNetErr, sizeof(NNQuantized));
+  // Set properties
+  q->_nbInputVal = NNGetNbInput(that);
+  q->_nbOutputVal = NNGetNbOutput(that);
+  q->_nbMaxHidVal = NNGetNbMaxHidden(that);
+  q->_basesCoeff = 
+    VecShortCreate(NNGetNbMaxBases(that) * NN_NBCOEFFBASE);
+  q->_basesShift = VecShortCreate(NNGetNbMaxBases(that));
+  // Copy the packed plan, and the base function indices of its links 
+  // if they are explicit
+  q->_nbPackedGroups = that->_nbPackedGroups;
+  q->_packedWidth = that->_packedWidth;
+  size_t size = that->_packedWidth * 3 * that->_nbPackedGroups;
+  q->_packedPlan = PBErrMalloc(NeuraNetErr, size + 1);
+  memcpy(q->_packedPlan, that->_packedPlan, size);
+  q->_packedBases = NULL;
+  if (that->_packedBases != NULL) {
+    size = that->_packedWidth * that->_nbPackedLinks;
+    q->_packedBases = PBErrMalloc(NeuraNetErr, size + 1);
+    memcpy(q->_packedBases, that->_packedBases, size);
+  }
+  // Loop on the base functions
+  for (long iBase = NNGetNbMaxBases(that); iBase--;) {
+    double slope = VecGet(that->_basesCoeff, iBase * NN_NBCOEFFBASE);
+    double offset = 
+      VecGet(that->_basesCoeff, iBase * NN_NBCOEFFBASE + 1);
+    // Get the largest shift such as both coefficients fit in int16
+    double maxAbs = MAX(fabs(slope), fabs(offset));
+    int shift = NN_QMAXSHIFTBASE;
+    if (maxAbs > 0.0)
+      shift = MIN(NN_QMAXSHIFTBASE, MAX(NN_QMINSHIFTBASE, 
+        (int)floor(log2(32767.0 / maxAbs))));
+    // Quantize the coefficients
+    VecSet(q->_basesShift, iBase, shift);
+    VecSet(q->_basesCoeff, iBase * NN_NBCOEFFBASE, 
+      NNQuantizeCoeff(slope, shift));
+    VecSet(q->_basesCoeff, iBase * NN_NBCOEFFBASE + 1, 
+      NNQuantizeCoeff(offset, shift));
+  }
+  // Return the new NNQuantized
+  return q;
+}
+
+// Free the memory used by the NNQuantized 'that'
+void NNQuantizedFree(NNQuantized** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  VecFree(&((*that)->_basesCoeff));
+  VecFree(&((*that)->_basesShift));
+  free((*that)->_packedPlan);
+  free((*that)->_packedBases);
+  free(*that);
+  *that = NULL;
+}
+
+// Helper function for NNQuantizedEval
+// Return the value 'v' saturated to the int32 range
+long NNQuantizedSaturate(const long v) {
+  return MIN(NN_QMAXACC, MAX(-NN_QMAXACC, v));
+}
+
+// Helper function for NNQuantizedEval
+// Return the value of the 'iBase'-th base function with quantized 
+// coefficients 'coeffs' and shifts 'shifts' for the input value 'x'
+// 'x' and the result have NN_QSHIFT fractional bits
+long NNQuantizedEvalLink(const short* const coeffs, 
+  const short* const shifts, const long iBase, const long x) {
+  // Evaluate the base function, the result has NN_QSHIFT + shift
+  // fractional bits
+  const short* coeff = coeffs + iBase * NN_NBCOEFFBASE;
+  int shift = shifts[iBase];
+  long y = coeff[0] * x + coeff[1] * NN_QONE;
+  // Bring the result back to NN_QSHIFT fractional bits, rounded to 
+  // nearest
+  return NNQuantizedSaturate(shift > 0 ? 
+    (y + (1L << (shift - 1))) >> shift : y * (1L << -shift));
+}
+
+// Create a new NNQuantizedContext to evaluate the NNQuantized 'that'
+// The context can be used with any NNQuantized having the same number 
+// of input, hidden and output values as 'that'
+NNQuantizedContext* NNQuantizedContextCreate(
+  const NNQuantized* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare the new context
+  NNQuantizedContext* ctx = 
+    PBErrMalloc(NeuraNetErr, sizeof(NNQuantizedContext));
+  // Set properties
+  ctx->_val = VecLongCreate(that->_nbInputVal + that->_nbMaxHidVal + 
+    that->_nbOutputVal);
+  // Return the new context
+  return ctx;
+}
+
+// Free the memory used by the NNQuantizedContext 'that'
+void NNQuantizedContextFree(NNQuantizedContext** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  VecFree(&((*that)->_val));
+  free(*that);
+  *that = NULL;
+}
+
+// Helper function for NNQuantizedEval
+// Evaluate the packed plan of the NNQuantized 'that', made of 16 bits 
+// integers, for the values 'val' (input, hidden and output values)
+void NNQuantizedEvalPacked16(const NNQuantized* const that, 
+  long* const val) {
+  // Declare variables for optimization
+  const uint16_t* plan = that->_packedPlan;
+  const uint16_t* bases = that->_packedBases;
+  const short* coeffs = that->_basesCoeff->_val;
+  const short* shifts = that->_basesShift->_val;
+  long startOut = that->_nbInputVal + that->_nbMaxHidVal;
+  // Loop on the groups of links in the packed plan
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < that->_nbPackedGroups; ++iGroup) {
+    const uint16_t* group = plan + 3 * iGroup;
+    // Get the input value of the group
+    long x = val[group[0]];
+    // Multiply the evaluation of the links of the group
+    long iEnd = iLink + group[2];
+    long prod = NNQuantizedEvalLink(coeffs, shifts, 
+      (bases != NULL ? bases[iLink] : iLink), x);
+    for (++iLink; iLink < iEnd; ++iLink) {
+      long y = NNQuantizedEvalLink(coeffs, shifts, 
+        (bases != NULL ? bases[iLink] : iLink), x);
+      prod = NNQuantizedSaturate(
+        (prod * y + (1L << (NN_QSHIFT - 1))) >> NN_QSHIFT);
+    }
+    // Add the result to the output value of the group, hidden values
+    // are clamped to [-1,1], output values are saturated
+    if (group[1] < startOut)
+      val[group[1]] = MIN(NN_QONE, MAX(-NN_QONE, val[group[1]] + prod));
+    else
+      val[group[1]] = NNQuantizedSaturate(val[group[1]] + prod);
+  }
+}
+
+// Helper function for NNQuantizedEval
+// Same as NNQuantizedEvalPacked16 for a packed plan made of 32 bits 
+// integers
+void NNQuantizedEvalPacked32(const NNQuantized* const that, 
+  long* const val) {
+  // Declare variables for optimization
+  const uint32_t* plan = that->_packedPlan;
+  const uint32_t* bases = that->_packedBases;
+  const short* coeffs = that->_basesCoeff->_val;
+  const short* shifts = that->_basesShift->_val;
+  long startOut = that->_nbInputVal + that->_nbMaxHidVal;
+  // Loop on the groups of links in the packed plan
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < that->_nbPackedGroups; ++iGroup) {
+    const uint32_t* group = plan + 3 * iGroup;
+    // Get the input value of the group
+    long x = val[group[0]];
+    // Multiply the evaluation of the links of the group
+    long iEnd = iLink + group[2];
+    long prod = NNQuantizedEvalLink(coeffs, shifts, 
+      (bases != NULL ? bases[iLink] : iLink), x);
+    for (++iLink; iLink < iEnd; ++iLink) {
+      long y = NNQuantizedEvalLink(coeffs, shifts, 
+        (bases != NULL ? bases[iLink] : iLink), x);
+      prod = NNQuantizedSaturate(
+        (prod * y + (1L << (NN_QSHIFT - 1))) >> NN_QSHIFT);
+    }
+    // Add the result to the output value of the group, hidden values
+    // are clamped to [-1,1], output values are saturated
+    if (group[1] < startOut)
+      val[group[1]] = MIN(NN_QONE, MAX(-NN_QONE, val[group[1]] + prod));
+    else
+      val[group[1]] = NNQuantizedSaturate(val[group[1]] + prod);
+  }
+}
+
+// Calculate the output values for the input values 'input' for the 
+// NNQuantized 'that' and memorize the result in 'output', using the 
+// NNQuantizedContext 'ctx' to memorize the values
+// Input values are rounded to the nearest fixed-point value and 
+// clamped to [-1,1]
+// The result approximates NNEval on the quantized NeuraNet, 
+// NNQuantizedGetMaxDeviation gives the error on a dataset
+// The NNQuantized is never modified, hence it can be evaluated 
+// concurrently with one context per thread
+void NNQuantizedEval(const NNQuantized* const that, 
+  NNQuantizedContext* const ctx, const VecFloat* const input, 
+  VecFloat* const output) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (ctx == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'ctx' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (input == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'input' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (output == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'output' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(ctx->_val) != that->_nbInputVal + that->_nbMaxHidVal + 
+    that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'ctx' doesn't match the nb of values (%ld)", 
+      that->_nbInputVal + that->_nbMaxHidVal + that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(input) != that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'input' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(input), that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(output) != that->_nbOutputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'output' 's dimension is invalid (%ld!=%d)", 
+      VecGetDim(output), that->_nbOutputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Reset the hidden values and output values, and quantize the input
+  // values
+  long* val = ctx->_val->_val;
+  VecSetNull(ctx->_val);
+  for (long iInput = that->_nbInputVal; iInput--;) {
+    float x = MIN(1.0, MAX(-1.0, VecGet(input, iInput)));
+    val[iInput] = lrintf(x * NN_QONE);
+  }
+  // Evaluate the packed plan
+  if (that->_packedWidth == sizeof(uint16_t))
+    NNQuantizedEvalPacked16(that, val);
+  else
+    NNQuantizedEvalPacked32(that, val);
+  // Convert the output values to float
+  long startOut = that->_nbInputVal + that->_nbMaxHidVal;
+  for (long iOutput = that->_nbOutputVal; iOutput--;)
+    VecSet(output, iOutput, 
+      (float)val[startOut + iOutput] / (float)NN_QONE);
+}
+
+// Get the maximum absolute difference between the output values 
+// calculated by the NNQuantized 'that' and the NeuraNet 'nn' it has
+// been created from, for the 'nbSample' samples of input values 
+// 'inputs' (organised as NNBatchRowMajor for NNEvalBatch)
+float NNQuantizedGetMaxDeviation(const NNQuantized* const that, 
+  const NeuraNet* const nn, const long nbSample, 
+  const VecFloat* const inputs) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nn == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'nn' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (inputs == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'inputs' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (that->_nbInputVal != NNGetNbInput(nn) || 
+    that->_nbOutputVal != NNGetNbOutput(nn)) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'nn' doesn't match 'that' (%d==%d, %d==%d)", 
+      that->_nbInputVal, NNGetNbInput(nn), 
+      that->_nbOutputVal, NNGetNbOutput(nn));
+    PBErrCatch(NeuraNetErr);
+  }
+  if (nbSample < 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbSample' is invalid (0<=%ld)", 
+      nbSample);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(inputs) != nbSample * that->_nbInputVal) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'inputs' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(inputs), nbSample * that->_nbInputVal);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare a variable to memorize the deviation
+  float maxDev = 0.0;
+  // If there is no sample
+  if (nbSample == 0)
+    // Nothing to do
+    return maxDev;
+  // Evaluate the samples with the NeuraNet
+  VecFloat* outputs = VecFloatCreate(nbSample * that->_nbOutputVal);
+  NNEvalBatch(nn, nbSample, inputs, NNBatchRowMajor, outputs);
+  // Loop on the samples
+  NNQuantizedContext* ctx = NNQuantizedContextCreate(that);
+  VecFloat* input = VecFloatCreate(that->_nbInputVal);
+  VecFloat* output = VecFloatCreate(that->_nbOutputVal);
+  for (long iSample = 0; iSample < nbSample; ++iSample) {
+    // Evaluate the sample with the NNQuantized
+    memcpy(input->_val, inputs->_val + iSample * that->_nbInputVal,
+      sizeof(float) * that->_nbInputVal);
+    NNQuantizedEval(that, ctx, input, output);
+    // Update the deviation
+    for (long iOutput = that->_nbOutputVal; iOutput--;) {
+      float dev = fabs(VecGet(output, iOutput) - 
+        VecGet(outputs, iSample * that->_nbOutputVal + iOutput));
+      if (dev > maxDev)
+        maxDev = dev;
+    }
+  }
+  // Free memory
+  NNQuantizedContextFree(&ctx);
+  VecFree(&outputs);
+  VecFree(&input);
+  VecFree(&output);
+  // Return the deviation
+  return maxDev;
+}
+
+// Function which return the JSON encoding of 'that' 
+JSONNode* NNEncodeAsJSON(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBMathErr->_type = PBErrTypeNullPointer;
+    sprintf(PBMathErr->_msg, "'that' is null");
+    PBErrCatch(PBMathErr);
+  }
+#endif
+  // Create the JSON structure
+  JSONNode* json = JSONCreate();
+  // Declare a buffer to convert value into string
+  char val[100];
+  // Encode the nbInputVal
+  sprintf(val, "%d", that->_nbInputVal);
+  JSONAddProp(json, "_nbInputVal", val);
+  // Encode the nbOutputVal
+  sprintf(val, "%d", that->_nbOutputVal);
+  JSONAddProp(json, "_nbOutputVal", val);
+  // Encode the nbMaxHidVal
+  sprintf(val, "%ld", that->_nbMaxHidVal);
+  JSONAddProp(json, "_nbMaxHidVal", val);
+  // Encode the nbMaxBases
+  sprintf(val, "%ld", that->_nbMaxBases);
+  JSONAddProp(json, "_nbMaxBases", val);
+  // Encode the nbMaxLinks
+  sprintf(val, "%ld", that->_nbMaxLinks);
+  JSONAddProp(json, "_nbMaxLinks", val);
+  // Encode the bases
+  JSONAddProp(json, "_bases", VecEncodeAsJSON(that->_bases));
+  // Encode the links, unless they are described by the geometry of 
+  // the convolution layers
+  if (that->_conv == NULL)
+    JSONAddProp(json, "_links", VecEncodeAsJSON(that->_links));
+  // Encode the geometry of the convolution layers
+  if (that->_conv != NULL) {
+    JSONNode* conv = JSONCreate();
+    JSONAddProp(conv, "_dimIn", VecEncodeAsJSON(that->_conv->_dimIn));
+    JSONAddProp(conv, "_dimCell", 
+      VecEncodeAsJSON(that->_conv->_dimCell));
+    sprintf(val, "%d", that->_conv->_depthConv);
+    JSONAddProp(conv, "_depthConv", val);
+    sprintf(val, "%d", that->_conv->_thickConv);
+    JSONAddProp(conv, "_thickConv", val);
+    if (that->_conv->_stride != NULL) {
+      JSONAddProp(conv, "_stride", 
+        VecEncodeAsJSON(that->_conv->_stride));
+      JSONAddProp(conv, "_poolKind", 
+        VecEncodeAsJSON(that->_conv->_poolKind));
+      JSONAddProp(conv, "_poolSize", 
+        VecEncodeAsJSON(that->_conv->_poolSize));
+    }
+    JSONAddProp(json, "_conv", conv);
+  }
+  // Encode the dense layers
+  if (that->_layers != NULL)
+    JSONAddProp(json, "_layers", VecEncodeAsJSON(that->_layers));
+  // Return the created JSON 
+  return json;
+}
+
+// Function which decode from JSON encoding 'json' to 'that'
+bool NNDecodeAsJSON(NeuraNet** that, const JSONNode* const json) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBMathErr->_type = PBErrTypeNullPointer;
+    sprintf(PBMathErr->_msg, "'that' is null");
+    PBErrCatch(PBMathErr);
+  }
+  if (json == NULL) {
+    PBMathErr->_type = PBErrTypeNullPointer;
+    sprintf(PBMathErr->_msg, "'json' is null");
+    PBErrCatch(PBMathErr);
+  }
+#endif
+  // If 'that' is already allocated
+  if (*that != NULL)
+    // Free memory
+    NeuraNetFree(that);
+  // Decode the nbInputVal
+  JSONNode* prop = JSONProperty(json, "_nbInputVal");
+  if (prop == NULL) {
+    return false;
+  }
+  int nbInputVal = atoi(JSONLblVal(prop));
+  // Decode the nbOutputVal
+  prop = JSONProperty(json, "_nbOutputVal");
+  if (prop == NULL) {
+    return false;
+  }
+  int nbOutputVal = atoi(JSONLblVal(prop));
+  // Decode the nbMaxHidVal
+  prop = JSONProperty(json, "_nbMaxHidVal");
+  if (prop == NULL) {
+    return false;
+  }
+  long nbMaxHidVal = atol(JSONLblVal(prop));
+  // Decode the nbMaxBases
+  prop = JSONProperty(json, "_nbMaxBases");
+  if (prop == NULL) {
+    return false;
+  }
+  long nbMaxBases = atol(JSONLblVal(prop));
+  // Decode the nbMaxLinks
+  prop = JSONProperty(json, "_nbMaxLinks");
+  if (prop == NULL) {
+    return false;
+  }
+  long nbMaxLinks = atol(JSONLblVal(prop));
+  // Get the links and the geometry of the convolution layers, the 
+  // links are implicit if only the geometry is given
+  JSONNode* propLinks = JSONProperty(json, "_links");
+  JSONNode* propConv = JSONProperty(json, "_conv");
+  if (propLinks == NULL && propConv == NULL) {
+    return false;
+  }
+  // Allocate memory
+  if (propLinks != NULL)
+    *that = NeuraNetCreate(nbInputVal, nbOutputVal, nbMaxHidVal, 
+      nbMaxBases, nbMaxLinks);
+  else
+    *that = NeuraNetCreateInArena(nbInputVal, nbOutputVal, 
+      nbMaxHidVal, nbMaxBases, nbMaxLinks, false);
+  // Decode the bases
+  prop = JSONProperty(json, "_bases");
+  if (prop == NULL) {
+    return false;
+  }
+  // The bases are decoded apart and copied, they are in the memory 
+  // of the NeuraNet
+  VecFloat* bases = NULL;
+  if (!VecDecodeAsJSON(&bases, prop) || 
+    VecGetDim(bases) != VecGetDim((*that)->_bases)) {
+    VecFree(&bases);
+    return false;
+  }
+  VecCopy((*that)->_bases, bases);
+  VecFree(&bases);
+  // Update the cached linear form of the base functions
+  for (long iBase = nbMaxBases; iBase--;)
+    NNUpdateBaseCoeff(*that, iBase);
+  // Decode the links, if any
+  if (propLinks != NULL) {
+    // The links are decoded apart and copied, they are in the memory
+    // of the NeuraNet
+    VecLong* links = NULL;
+    if (!VecDecodeAsJSON(&links, propLinks) || 
+      VecGetDim(links) != VecGetDim((*that)->_links)) {
+      VecFree(&links);
+      return false;
+    }
+    VecCopy((*that)->_links, links);
+    VecFree(&links);
+    // Reset the origin of the links and update the execution plan
+    NNResetLinksOrigin(*that);
+    NNUpdatePlan(*that);
+    // Decode the dense layers, if any, and discard them if they don't
+    // match the links
+    prop = JSONProperty(json, "_layers");
+    if (prop != NULL) {
+      if (!VecDecodeAsJSON(&((*that)->_layers), prop)) {
+        return false;
+      }
+      if (!NNLinksMatchLayers(*that))
+        VecFree(&((*that)->_layers));
+    }
+  }
+  // Decode the geometry of the convolution layers, if any
+  prop = propConv;
+  if (prop != NULL) {
+    VecShort* dimIn = NULL;
+    VecShort* dimCell = NULL;
+    VecShort* stride = NULL;
+    VecShort* poolKind = NULL;
+    VecShort* poolSize = NULL;
+    JSONNode* propDepth = JSONProperty(prop, "_depthConv");
+    JSONNode* propThick = JSONProperty(prop, "_thickConv");
+    // The stride and pooling are optional, the default being stride 1
+    // and no pooling
+    JSONNode* propStride = JSONProperty(prop, "_stride");
+    JSONNode* propPoolKind = JSONProperty(prop, "_poolKind");
+    JSONNode* propPoolSize = JSONProperty(prop, "_poolSize");
+    if (propDepth == NULL || propThick == NULL ||
+      JSONProperty(prop, "_dimIn") == NULL ||
+      JSONProperty(prop, "_dimCell") == NULL ||
+      !VecDecodeAsJSON(&dimIn, JSONProperty(prop, "_dimIn")) ||
+      !VecDecodeAsJSON(&dimCell, JSONProperty(prop, "_dimCell")) ||
+      (propStride != NULL && !VecDecodeAsJSON(&stride, propStride)) ||
+      (propPoolKind != NULL && 
+        !VecDecodeAsJSON(&poolKind, propPoolKind)) ||
+      (propPoolSize != NULL && 
+        !VecDecodeAsJSON(&poolSize, propPoolSize))) {
+      VecFree(&dimIn);
+      VecFree(&dimCell);
+      VecFree(&stride);
+      VecFree(&poolKind);
+      VecFree(&poolSize);
+      return false;
+    }
+    (*that)->_conv = NNConvGeometryCreate(dimIn, dimCell, 
+      atoi(JSONLblVal(propDepth)), atoi(JSONLblVal(propThick)),
+      stride, poolKind, poolSize);
+    // Restore the nb of bases used for convolution
+    long nbBasesCellConv = 1;
+    for (long iDim = VecGetDim(dimCell); iDim--;)
+      nbBasesCellConv *= VecGet(dimCell, iDim);
+    *(long*)&((*that)->_nbBasesCellConv) = nbBasesCellConv;
+    *(long*)&((*that)->_nbBasesConv) = nbBasesCellConv * 
+      (*that)->_conv->_depthConv * (*that)->_conv->_thickConv;
+    VecFree(&dimIn);
+    VecFree(&dimCell);
+    VecFree(&stride);
+    VecFree(&poolKind);
+    VecFree(&poolSize);
+  }
+  // Return the success code
+  return true;
+}
+
+// Save the NeuraNet 'that' to the stream 'stream'
+// If 'compact' equals true it saves in compact form, else it saves in 
+// readable form
+// Return true if the NeuraNet could be saved, false else
+bool NNSave(const NeuraNet* const that, FILE* const stream, const bool compact) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (stream == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'stream' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Get the JSON encoding
+  JSONNode* json = NNEncodeAsJSON(that);
+  // Save the JSON
+  if (!JSONSave(json, stream, compact)) {
+    return false;
+  }
+  // Free memory
+  JSONFree(&json);
+  // Return success code
+  return true;
+}
+
+// Load the NeuraNet 'that' from the stream 'stream'
+// If 'that' is not null the memory is first freed 
+// Return true if the NeuraNet could be loaded, false else
+bool NNLoad(NeuraNet** that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (stream == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'stream' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // Declare a json to load the encoded data
+  JSONNode* json = JSONCreate();
+  // Load the whole encoded data
+  if (!JSONLoad(json, stream)) {
+    return false;
+  }
+  // Decode the data from the JSON
+  if (!NNDecodeAsJSON(that, json)) {
+    return false;
+  }
+  // Free the memory used by the JSON
+  JSONFree(&json);
+  // Return the success code
+  return true;
+}
+
+// Helper function for NNSaveAsC
+// Print in 'str' the C literal exactly equal to the float 'v'
+void NNSaveAsCFloat(char* const str, const float v) {
+  if (isnan(v))
+    sprintf(str, "NAN");
+  else if (isinf(v))
+    sprintf(str, "%sHUGE_VALF", (v < 0.0 ? "-" : ""));
+  else
+    sprintf(str, "%af", v);
+}
+
+// Save the NeuraNet 'that' to the stream 'stream' as C code defining
+// the function nn_eval(const float* input, float* output) which 
+// calculates the output values for the input values as NNEval, and the
+// constants nn_nb_input and nn_nb_output equal to the nb of input and 
+// output values
+// The code is straight-line: the base functions' coefficients are 
+// inlined and the hidden values are local variables
+// Return true if the NeuraNet could be saved, false else
+bool NNSaveAsC(const NeuraNet* const that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (stream == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'stream' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are implicit, save a clone with expanded links
+  NeuraNet* expanded = NNCloneWithExpandedLinks(that);
+  if (expanded != NULL) {
+    bool ret = NNSaveAsC(expanded, stream);
+    NeuraNetFree(&expanded);
+    return ret;
+  }
+  // Declare variables to print the lines of code and the constants
+  char line[256];
+  char slope[64];
+  char offset[64];
+  // Declare variables for optimization
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  int width = that->_packedWidth;
+  const float* coeffs = that->_basesCoeff->_val;
+  // Get the nb of groups in the plan
+  long nbGroup = that->_nbPackedGroups;
+  // Save the header
+  const char* header[] = {
+    "// Code generated by NNSaveAsC from a NeuraNet\n",
+    "#include <math.h>\n",
+    "#define NN_MIN(a, b) ((a) < (b) ? (a) : (b))\n",
+    "#define NN_MAX(a, b) ((a) > (b) ? (a) : (b))\n"};
+  for (int iLine = 0; iLine < 4; ++iLine)
+    if (!PBErrPrintf(NeuraNetErr, stream, "%s", header[iLine]))
+      return false;
+  sprintf(line, "const int nn_nb_input = %d;\n", NNGetNbInput(that));
+  if (!PBErrPrintf(NeuraNetErr, stream, "%s", line))
+    return false;
+  sprintf(line, "const int nn_nb_output = %d;\n", NNGetNbOutput(that));
+  if (!PBErrPrintf(NeuraNetErr, stream, "%s", line))
+    return false;
+  if (!PBErrPrintf(NeuraNetErr, stream, "%s", 
+    "void nn_eval(const float* input, float* output) {\n"))
+    return false;
+  // Flag the hidden values used by the plan
+  bool* isUsed = PBErrMalloc(NeuraNetErr, 
+    sizeof(bool) * (NNGetNbMaxHidden(that) + 1));
+  memset(isUsed, 0, sizeof(bool) * (NNGetNbMaxHidden(that) + 1));
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    long in = NNPackedGet(that->_packedPlan, width, 3 * iGroup);
+    long out = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+    if (in >= startHid)
+      isUsed[in - startHid] = true;
+    if (out < startOut)
+      isUsed[out - startHid] = true;
+  }
+  // Declare the used hidden values, initialized to 0.0
+  bool ret = true;
+  for (long iHid = 0; ret && iHid < NNGetNbMaxHidden(that); ++iHid) {
+    if (isUsed[iHid]) {
+      sprintf(line, "  float h%ld = 0.0f;\n", iHid);
+      ret = PBErrPrintf(NeuraNetErr, stream, "%s", line);
+    }
+  }
+  free(isUsed);
+  if (!ret)
+    return false;
+  // Reset the output values
+  for (long iOut = 0; iOut < NNGetNbOutput(that); ++iOut) {
+    sprintf(line, "  output[%ld] = 0.0f;\n", iOut);
+    if (!PBErrPrintf(NeuraNetErr, stream, "%s", line))
+      return false;
+  }
+  if (nbGroup > 0 && 
+    !PBErrPrintf(NeuraNetErr, stream, "%s", "  float p;\n"))
+    return false;
+  // Loop on the groups of links in the execution plan
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    long in = NNPackedGet(that->_packedPlan, width, 3 * iGroup);
+    long out = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+    long first = iLink;
+    long iEnd = 
+      iLink + NNPackedGet(that->_packedPlan, width, 3 * iGroup + 2);
+    // Get the name of the input value of the group
+    char x[32];
+    if (in < startHid)
+      sprintf(x, "input[%ld]", in);
+    else
+      sprintf(x, "h%ld", in - startHid);
+    // Multiply the evaluation of the links of the group, in the same
+    // order and with the same operations as NNEval
+    for (; iLink < iEnd; ++iLink) {
+      const float* coeff = 
+        coeffs + NNGetPackedBase(that, iLink) * NN_NBCOEFFBASE;
+      NNSaveAsCFloat(slope, coeff[0]);
+      NNSaveAsCFloat(offset, coeff[1]);
+      sprintf(line, "  p %s %s * %s + %s;\n", 
+        (iLink == first ? "=" : "*="), slope, x, offset);
+      if (!PBErrPrintf(NeuraNetErr, stream, "%s", line))
+        return false;
+    }
+    // Add the result to the output value of the group, hidden values
+    // are clamped to [-1,1]
+    if (out < startOut)
+      sprintf(line, "  h%ld = NN_MIN(1.0f, NN_MAX(-1.0f, h%ld + p));\n",
+        out - startHid, out - startHid);
+    else
+      sprintf(line, "  output[%ld] += p;\n", out - startOut);
+    if (!PBErrPrintf(NeuraNetErr, stream, "%s", line))
+      return false;
+  }
+  if (!PBErrPrintf(NeuraNetErr, stream, "%s", "}\n"))
+    return false;
+  // Return success code
+  return true;
+}
+
+// Print the NeuraNet 'that' to the stream 'stream'
+void NNPrintln(const NeuraNet* const that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (stream == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'stream' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are implicit, print a clone with expanded links
+  NeuraNet* expanded = NNCloneWithExpandedLinks(that);
+  if (expanded != NULL) {
+    NNPrintln(expanded, stream);
+    NeuraNetFree(&expanded);
+    return;
+  }
+  fprintf(stream, "nbInput: %d\n", that->_nbInputVal);
+  fprintf(stream, "nbOutput: %d\n", that->_nbOutputVal);
+  fprintf(stream, "nbHidden: %ld\n", that->_nbMaxHidVal);
+  fprintf(stream, "nbMaxBases: %ld\n", that->_nbMaxBases);
+  fprintf(stream, "nbMaxLinks: %ld\n", that->_nbMaxLinks);
+  fprintf(stream, "bases: ");
+  VecPrint(that->_bases, stream);
+  fprintf(stream, "\n");
+  fprintf(stream, "links: ");
+  VecPrint(that->_links, stream);
+  fprintf(stream, "\n");
+  fprintf(stream, "hidden values: ");
+  VecPrint(that->_hidVal, stream);
+  fprintf(stream, "\n");
+}
+
+// Helper function for NNSortLinks
+// Get the index of the bucket of the id 'id' in the counting sort of
+// the links of a NeuraNet having 'nbVal' values
+// Ids out of bounds are gathered in the first and last buckets, they 
+// are left out of the execution plan anyway
+long NNSortLinksBucket(const long id, const long nbVal) {
+  return (id < 0 ? 0 : (id >= nbVal ? nbVal + 1 : id + 1));
+}
+
+// Helper function for NNSortLinks
+// Sort the 'nbLink' indices of links of 'links' in 'from' into 'to'
+// according to their output if 'onInput' is false, or their input 
+// if 'onInput' is true, where the input is the lowest of the two ids
+// of the link and the output the highest one, using 'count' as 
+// the histogram of the buckets of the NeuraNet 'that'
+// The sort is stable
+void NNSortLinksPass(const NeuraNet* const that, 
+  const VecLong* const links, const long nbLink, const long* const from, 
+  long* const to, long* const count, const bool onInput) {
+  // Declare variables for optimization
+  long nbVal = NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
+    NNGetNbOutput(that);
+  const long* link = links->_val;
+  // Reset the histogram
+  memset(count, 0, sizeof(long) * (nbVal + 3));
+  // Count the links per bucket
+  for (long i = 0; i < nbLink; ++i) {
+    const long* l = link + from[i] * NN_NBPARAMLINK;
+    long id = (onInput ? MIN(l[1], l[2]) : MAX(l[1], l[2]));
+    ++(count[NNSortLinksBucket(id, nbVal) + 1]);
+  }
+  // Convert the counts into the index of the first link of each bucket
+  for (long iBucket = 0; iBucket < nbVal + 2; ++iBucket)
+    count[iBucket + 1] += count[iBucket];
+  // Move the links to their bucket in their current order
+  for (long i = 0; i < nbLink; ++i) {
+    const long* l = link + from[i] * NN_NBPARAMLINK;
+    long id = (onInput ? MIN(l[1], l[2]) : MAX(l[1], l[2]));
+    to[(count[NNSortLinksBucket(id, nbVal)])++] = from[i];
+  }
+}
+
+// Helper function for NNSetLinks
+// Copy the active links of 'links' sorted on their input and output 
+// into the allocated links of the NeuraNet 'that' and update its 
+// execution plan
+// The links are sorted with a counting sort on their output then on 
+// their input, links sharing the same input and output keep their 
+// relative order
+void NNSortLinks(const NeuraNet* const that, const VecLong* const links) {
+  // Declare variables for optimization
+  long nbMaxLinks = NNGetNbMaxLinks(that);
+  // Get the scratch memory of the sort, two indices of link per
+  // link (sorted links and intermediate result) followed by the 
+  // histogram of the counting sort (one bucket per value, one per side
+  // of out of bounds ids, plus one)
+  long* sorted = NNGetScratch(that);
+  long* tmp = sorted + nbMaxLinks;
+  long* count = tmp + nbMaxLinks;
+  // Get the indices of the active links
+  long nbLink = 0;
+  for (long iLink = 0; iLink < nbMaxLinks; ++iLink)
+    if (VecGet(links, iLink * NN_NBPARAMLINK) != -1)
+      sorted[nbLink++] = iLink;
+  // Sort the links on their output, then on their input
+  NNSortLinksPass(that, links, nbLink, sorted, tmp, count, false);
+  NNSortLinksPass(that, links, nbLink, tmp, sorted, count, true);
+  // Copy the sorted links, swapping the input and output if the 
+  // input is greater than the output
+  for (long iLink = 0; iLink < nbLink; ++iLink) {
+    const long* link = links->_val + sorted[iLink] * NN_NBPARAMLINK;
+    VecSet(that->_links, iLink * NN_NBPARAMLINK, link[0]);
+    VecSet(that->_links, iLink * NN_NBPARAMLINK + 1, 
+      MIN(link[1], link[2]));
+    VecSet(that->_links, iLink * NN_NBPARAMLINK + 2, 
+      MAX(link[1], link[2]));
+  }
+  // Reset the inactive links
+  for (long iLink = nbLink; iLink < nbMaxLinks; ++iLink)
+    VecSet(that->_links, iLink * NN_NBPARAMLINK, -1);
+  // Memorize the origin of the sorted links and their position
+  for (long iLink = nbMaxLinks; iLink--;)
+    VecSet(that->_linksPos, iLink, -1);
+  for (long iLink = 0; iLink < nbLink; ++iLink) {
+    VecSet(that->_linksOrigin, iLink, sorted[iLink]);
+    VecSet(that->_linksPos, sorted[iLink], iLink);
+  }
+  // Update the execution plan, the scratch memory is free again
+  NNUpdatePlan(that);
+}
+
+// Helper function for NNSetLinks and NNSetLinksCached
+// Give back to the NeuraNet 'that' the memory of its links if they 
+// are bound, without copying the bound links as they are about to be 
+// entirely replaced
+void NNReleaseLinks(const NeuraNet* const that) {
+  // If the links are not bound
+  if (that->_ownLinks == NULL)
+    // Nothing to do
+    return;
+  // Restore the links of the NeuraNet
+  *(VecLong**)&(that->_links) = that->_ownLinks;
+  *(VecLong**)&(that->_ownLinks) = NULL;
+}
+
+// Set the links description of the NeuraNet 'that' to a copy of 'links'
+// Links with a base function equals to -1 are ignored
+// If the input id is higher than the output id they are swap
+// The links description in the NeuraNet are ordered in increasing 
+// value of input id and output id, but 'links' doesn't have to be 
+// sorted
+// Links with the same input id and output id keep their relative 
+// order
+// Each link is defined by (base index, input index, output index)
+// If base index equals -1 it means the link is inactive
+void NNSetLinks(NeuraNet* const that, VecLong* const links) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (links == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'links' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(links) != that->_nbMaxLinks * NN_NBPARAMLINK) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'links' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(links), that->_nbMaxLinks);
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // The links may not match anymore the geometry of the convolution 
+  // layers, discard it
+  NNConvGeometryFree(&(that->_conv));
+  // Release the links if they are bound
+  NNReleaseLinks(that);
+  // Allocate the links if they were implicit
+  NNAllocateLinks(that);
+  // Sort and copy the links, and update the execution plan
+  NNSortLinks(that, links);
+  // If the links don't match anymore the layers, discard them
+  if (that->_layers != NULL && !NNLinksMatchLayers(that))
+    VecFree(&(that->_layers));
+}
+
+// Expand the links implicitly described by the geometry of the 
+// convolution layers of the NeuraNet 'that' into its links 
+// description and execution plan
+// Do nothing if the links are already expanded
+// The expansion modifies the NeuraNet, it must not happen concurrently 
+// with another use of the NeuraNet
+void NNExpandLinks(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are already expanded
+  if (that->_links != NULL)
+    // Nothing to do
+    return;
+  // Allocate the links
+  NNAllocateLinks(that);
+  // Generate the links from the geometry of the convolution layers, 
+  // they are generated already sorted so they are written directly 
+  // into the links of the NeuraNet
+  NNConvGeometryGetLinks(that->_conv, NNGetNbOutput(that), 
+    NNGetNbMaxHidden(that), that->_links);
+  // Reset the origin of the links and update the execution plan
+  NNResetLinksOrigin(that);
+  NNUpdatePlan(that);
+}
+
+// Update the execution plan of the NeuraNet 'that' according to its
+// current links, and its dependency levels
+// Groups of links referring to values out of bounds of the input,
+// hidden or output values are left out of the plan
+void NNUpdatePlan(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are implicit
+  if (that->_links == NULL)
+    // There is no execution plan to update
+    return;
+  // Declare variables to memorize the starting index of hidden 
+  // values and output values, and the index following the last output
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  long endOut = startOut + NNGetNbOutput(that);
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  const long* links = that->_links->_val;
+  void* bases = NNArenaPackedBases(that);
+  // Declare a variable to memorize if the base function index of each
+  // link equals its index in the plan
+  bool isImplicit = true;
+  // Declare variables to memorize the nb of groups and links in the 
+  // plan
+  long iGroup = 0;
+  long iPacked = 0;
+  // Loop on active links
+  long iLink = 0;
+  while (iLink < NNGetNbMaxLinks(that) && 
+    links[NN_NBPARAMLINK * iLink] != -1) {
+    // Get the input and output of the group starting at this link
+    long in = links[NN_NBPARAMLINK * iLink + 1];
+    long out = links[NN_NBPARAMLINK * iLink + 2];
+    // Search the first link following the group
+    long jLink = iLink + 1;
+    while (jLink < NNGetNbMaxLinks(that) && 
+      links[NN_NBPARAMLINK * jLink] != -1 &&
+      links[NN_NBPARAMLINK * jLink + 1] == in &&
+      links[NN_NBPARAMLINK * jLink + 2] == out)
+      ++jLink;
+    // If the input and output of the group are in bounds
+    if (in >= 0 && in < startOut && out >= startHid && out < endOut) {
+      // Add the group to the plan
+      NNPackedSet(that->_packedPlan, width, 3 * iGroup, in);
+      NNPackedSet(that->_packedPlan, width, 3 * iGroup + 1, out);
+      NNPackedSet(that->_packedPlan, width, 3 * iGroup + 2, 
+        jLink - iLink);
+      ++iGroup;
+      // Add the base function index of its links, and check if they 
+      // are implicit
+      for (long kLink = iLink; kLink < jLink; ++kLink, ++iPacked) {
+        long base = links[NN_NBPARAMLINK * kLink];
+        NNPackedSet(bases, width, iPacked, base);
+        if (base != iPacked)
+          isImplicit = false;
+      }
+    }
+    // Move to the next group
+    iLink = jLink;
+  }
+  *(long*)&(that->_nbPackedGroups) = iGroup;
+  *(long*)&(that->_nbPackedLinks) = iPacked;
+  *(long*)&(that->_nbActiveLinks) = iLink;
+  // The base function indices are used only if they are not implicit
+  *(void**)&(that->_packedBases) = (isImplicit ? NULL : bases);
+  // Update the dependency levels
+  NNUpdateLevels(that);
+}
+
+// Helper function for NNUpdateLevels and NNSetPlanPerDst
+// Update the execution plan per destination of the NeuraNet 'that' 
+// according to its current execution plan and index of the groups per
+// destination
+void NNUpdatePlanPerDst(const NeuraNet* const that) {
+  // Declare variables for optimization
+  long nbDst = NNGetNbMaxHidden(that) + NNGetNbOutput(that);
+  long startHid = NNGetNbInput(that);
+  int width = that->_packedWidth;
+  const long* dstGroupStart = that->_dstGroupStart->_val;
+  // Get the nb of groups in the plan
+  long nbGroup = dstGroupStart[nbDst];
+  // Copy the groups per destination in the order of the plan, using 
+  // a copy of the start of the destinations as cursors in the scratch
+  // memory
+  long* cursor = NNGetScratch(that);
+  memcpy(cursor, dstGroupStart, sizeof(long) * (nbDst + 1));
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    long out = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+    long pos = (cursor[out - startHid])++;
+    NNPackedSet(that->_dstPos, width, iGroup, pos);
+    for (int iParam = 3; iParam--;)
+      NNPackedSet(that->_dstPlan, width, 3 * pos + iParam, 
+        NNPackedGet(that->_packedPlan, width, 3 * iGroup + iParam));
+  }
+  // Calculate the index of the first link of each group per 
+  // destination
+  long iBase = 0;
+  for (long pos = 0; pos < nbGroup; ++pos) {
+    NNPackedSet(that->_dstLinkStart, width, pos, iBase);
+    iBase += NNPackedGet(that->_dstPlan, width, 3 * pos + 2);
+  }
+  // Copy the base functions of the links in the order of the groups 
+  // per destination
+  long iLink = 0;
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    long pos = NNPackedGet(that->_dstPos, width, iGroup);
+    long first = NNPackedGet(that->_dstLinkStart, width, pos);
+    long nbLink = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 2);
+    for (long kLink = 0; kLink < nbLink; ++kLink, ++iLink)
+      NNPackedSet(that->_dstBase, width, first + kLink, 
+        NNGetPackedBase(that, iLink));
+  }
+}
+
+// Update the index of the groups per value, the dependency levels 
+// and, if it has been requested, the execution plan per destination of
+// the NeuraNet 'that' according to its current execution plan
+// The levels are unavailable if the links are not sorted as done by 
+// NNSetLinks
+void NNUpdateLevels(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+#endif
+  // If the links are implicit
+  if (that->_links == NULL)
+    // There is no execution plan to update
+    return;
+  // Declare variables for optimization
+  long nbHid = NNGetNbMaxHidden(that);
+  long nbDst = nbHid + NNGetNbOutput(that);
+  long startHid = NNGetNbInput(that);
+  int width = that->_packedWidth;
+  long nbGroup = that->_nbPackedGroups;
+  long* dstGroupStart = that->_dstGroupStart->_val;
+  long* srcGroupStart = that->_srcGroupStart->_val;
+  long* levelStart = that->_levelStart->_val;
+  long* levelDst = that->_levelDst->_val;
+  // Count the groups per destination, and check the groups are sorted
+  // on input then output with an input not greater than the output, 
+  // as done by NNSetLinks
+  bool isSorted = true;
+  long prevIn = -1;
+  long prevOut = -1;
+  memset(dstGroupStart, 0, sizeof(long) * (nbDst + 1));
+  memset(srcGroupStart, 0, sizeof(long) * (startHid + nbHid + 1));
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    // Get the index of the input and output over all kinds of values
+    long in = NNPackedGet(that->_packedPlan, width, 3 * iGroup);
+    long out = NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1);
+    if (in > out || in < prevIn || (in == prevIn && out <= prevOut))
+      isSorted = false;
+    prevIn = in;
+    prevOut = out;
+    ++(dstGroupStart[out - startHid + 1]);
+    ++(srcGroupStart[in + 1]);
+  }
+  // Convert the counts into the index of the first group of each 
+  // destination and each input
+  for (long iDst = 0; iDst < nbDst; ++iDst)
+    dstGroupStart[iDst + 1] += dstGroupStart[iDst];
+  for (long iVal = 0; iVal < startHid + nbHid; ++iVal)
+    srcGroupStart[iVal + 1] += srcGroupStart[iVal];
+  // Update the plan per destination if it has been requested
+  if (that->_dstArena != NULL)
+    NNUpdatePlanPerDst(that);
+  // If the groups are not sorted, the evaluation per destination 
+  // wouldn't give the same result as the evaluation in the order of 
+  // the plan
+  if (!isSorted) {
+    // Flag the levels as unavailable
+    levelStart[0] = -1;
+    return;
+  }
+  // Calculate the level of each destination
+  // Input values and destinations without groups are at level 0, 
+  // other destinations are one level above the highest level of 
+  // their inputs (ignoring themselves)
+  // As the groups are sorted on their input, and inputs are lower 
+  // than outputs, the level of the input of a group is known when 
+  // reaching the group
+  long* level = that->_dstLevel->_val;
+  memset(level, 0, sizeof(long) * nbDst);
+  long nbLevel = 0;
+  for (long iGroup = 0; iGroup < nbGroup; ++iGroup) {
+    long in = NNPackedGet(that->_packedPlan, width, 3 * iGroup);
+    long iDst = 
+      NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1) - startHid;
+    long lvl = 1;
+    if (in >= startHid && in - startHid != iDst)
+      lvl = level[in - startHid] + 1;
+    if (lvl > level[iDst])
+      level[iDst] = lvl;
+    if (level[iDst] > nbLevel)
+      nbLevel = level[iDst];
+  }
+  // Count the destinations per level (level 0 has nothing to 
+  // evaluate and is left out, hence levels are shifted by one)
+  memset(levelStart, 0, sizeof(long) * (nbLevel + 1));
+  for (long iDst = 0; iDst < nbDst; ++iDst)
+    if (level[iDst] > 0)
+      ++(levelStart[level[iDst]]);
+  // Convert the counts into the index of the first destination of 
+  // each level
+  for (long iLevel = 0; iLevel < nbLevel; ++iLevel)
+    levelStart[iLevel + 1] += levelStart[iLevel];
+  // Add the destinations to their level in increasing order, using 
+  // the start of the following level as a cursor
+  for (long iDst = 0; iDst < nbDst; ++iDst)
+    if (level[iDst] > 0)
+      levelDst[(levelStart[level[iDst] - 1])++] = iDst;
+  // Restore the start of the levels shifted by the cursors
+  for (long iLevel = nbLevel; iLevel > 0; --iLevel)
+    levelStart[iLevel] = levelStart[iLevel - 1];
+  levelStart[0] = 0;
+  // Mark the end of the levels
+  levelStart[nbLevel + 1] = -1;
+}
+
+// Helper function for NNUpdateLinkBase and NNMoveLinksInPlace
+// Make the base function indices of the execution plan of the 
+// NeuraNet 'that' explicit if they are implicit
+void NNSetPackedBasesExplicit(const NeuraNet* const that) {
+  // If the base function indices are already explicit
+  if (that->_packedBases != NULL)
+    // Nothing to do
+    return;
+  // Set the base function index of each link of the plan to its index
+  *(void**)&(that->_packedBases) = NNArenaPackedBases(that);
+  for (long iLink = that->_nbPackedLinks; iLink--;)
+    NNPackedSet(that->_packedBases, that->_packedWidth, iLink, iLink);
+}
+
+// Helper function for NNUpdateLinks
+// Set the base function of the 'iLink'-th link of the NeuraNet 'that'
+// to 'base' and patch its execution plan accordingly
+// The link must be active and stay active
+void NNUpdateLinkBase(const NeuraNet* const that, const long iLink, 
+  const long base) {
+  // Set the base function of the link
+  VecSet(that->_links, iLink * NN_NBPARAMLINK, base);
+  // If the links don't match anymore the dense layers, discard them
+  if (that->_layers != NULL && base != iLink)
+    VecFree((VecLong**)&(that->_layers));
+  // If some groups have been left out of the plan, the index of the 
+  // link in the plan is unknown
+  if (that->_nbPackedLinks != that->_nbActiveLinks) {
+    // Update the whole plan
+    NNUpdatePlan(that);
+    return;
+  }
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  // If the base function indices of the plan are implicit
+  if (that->_packedBases == NULL) {
+    // Nothing to patch if the base function index stays implicit
+    if (base == iLink)
+      return;
+    // Make the base function indices of the plan explicit
+    NNSetPackedBasesExplicit(that);
+  }
+  // Patch the base function index of the link in the plan
+  NNPackedSet(that->_packedBases, width, iLink, base);
+  // If the plan per destination hasn't been requested
+  if (that->_dstArena == NULL)
+    // Nothing else to patch
+    return;
+  // If the levels are unavailable, the groups of the input of the link
+  // are unknown
+  const long* links = that->_links->_val;
+  long in = links[iLink * NN_NBPARAMLINK + 1];
+  long out = links[iLink * NN_NBPARAMLINK + 2];
+  if (VecGet(that->_levelStart, 0) == -1) {
+    // Update the whole plan per destination
+    NNUpdatePlanPerDst(that);
+    return;
+  }
+  // Search the group of the link among the groups of its input, the 
+  // links being sorted there is only one group per input and output
+  long iGroup = VecGet(that->_srcGroupStart, in);
+  while (NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1) != out)
+    ++iGroup;
+  // Get the index of the link in its group
+  long offset = 0;
+  while (offset < iLink && 
+    links[(iLink - offset - 1) * NN_NBPARAMLINK + 1] == in &&
+    links[(iLink - offset - 1) * NN_NBPARAMLINK + 2] == out)
+    ++offset;
+  // Patch the base function in the plan per destination
+  long pos = NNPackedGet(that->_dstPos, width, iGroup);
+  NNPackedSet(that->_dstBase, width, 
+    NNPackedGet(that->_dstLinkStart, width, pos) + offset, base);
+}
+
+// Helper function for NNMoveLinksInPlace
+// Return the index of the first of the 'nbLink' first links of the 
+// NeuraNet 'that' which is not before a link of input 'in', output 
+// 'out' and origin 'iOrigin' in the order given by NNSetLinks
+// The links must all be in bounds
+long NNSearchLink(const NeuraNet* const that, const long nbLink, 
+  const long in, const long out, const long iOrigin) {
+  // Declare variables for optimization
+  const long* links = that->_links->_val;
+  const long* origin = that->_linksOrigin->_val;
+  // Search the link by dichotomy
+  long iStart = 0;
+  long iEnd = nbLink;
+  while (iStart < iEnd) {
+    long iLink = (iStart + iEnd) / 2;
+    const long* link = links + iLink * NN_NBPARAMLINK;
+    if (link[1] < in || (link[1] == in && (link[2] < out || 
+      (link[2] == out && origin[iLink] < iOrigin))))
+      iStart = iLink + 1;
+    else
+      iEnd = iLink;
+  }
+  // Return the result
+  return iStart;
+}
+
+// Helper function for NNMoveLinksInPlace
+// Return the index of the first group of the execution plan of the 
+// NeuraNet 'that' having for input 'in' and an output not lower than 
+// 'out'
+long NNSearchGroup(const NeuraNet* const that, const long in, 
+  const long out) {
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  // Search the group by dichotomy among the groups of the input
+  long iStart = VecGet(that->_srcGroupStart, in);
+  long iEnd = VecGet(that->_srcGroupStart, in + 1);
+  while (iStart < iEnd) {
+    long iGroup = (iStart + iEnd) / 2;
+    if (NNPackedGet(that->_packedPlan, width, 3 * iGroup + 1) < out)
+      iStart = iGroup + 1;
+    else
+      iEnd = iGroup;
+  }
+  // Return the result
+  return iStart;
+}
+
+// Helper function for NNMoveLinksInPlace
+// Move the 'from'-th link of the NeuraNet 'that' to the 'to'-th 
+// position, shifting the links between, with their origin and base 
+// function index in the plan
+void NNShiftLink(const NeuraNet* const that, const long from, 
+  const long to) {
+  // Declare variables for optimization
+  long* links = that->_links->_val;
+  long* origin = that->_linksOrigin->_val;
+  long* pos = that->_linksPos->_val;
+  int width = that->_packedWidth;
+  char* bases = that->_packedBases;
+  // Memorize the moved link
+  long link[NN_NBPARAMLINK];
+  memcpy(link, links + from * NN_NBPARAMLINK, 
+    sizeof(long) * NN_NBPARAMLINK);
+  long iOrigin = origin[from];
+  long base = NNPackedGet(bases, width, from);
+  // Shift the links between the two positions by one toward 'from'
+  long first = MIN(from, to);
+  long nb = MAX(from, to) - first;
+  long step = (from < to ? 1 : 0);
+  memmove(links + (first + 1 - step) * NN_NBPARAMLINK, 
+    links + (first + step) * NN_NBPARAMLINK, 
+    sizeof(long) * NN_NBPARAMLINK * nb);
+  memmove(origin + first + 1 - step, origin + first + step, 
+    sizeof(long) * nb);
+  memmove(bases + width * (first + 1 - step), 
+    bases + width * (first + step), width * nb);
+  for (long iLink = first + 1 - step; iLink < first + 1 - step + nb; 
+    ++iLink)
+    pos[origin[iLink]] = iLink;
+  // Put the moved link at its new position
+  memcpy(links + to * NN_NBPARAMLINK, link, 
+    sizeof(long) * NN_NBPARAMLINK);
+  origin[to] = iOrigin;
+  pos[iOrigin] = to;
+  NNPackedSet(bases, width, to, base);
+}
+
+// Helper function for NNRemoveLinkInPlace
+// Remove the 'offset'-th link of the 'iGroup'-th group of the 
+// execution plan of the NeuraNet 'that' from its plan per 
+// destination, and the group too if it's its only link
+// Must be called before removing the link from the execution plan
+void NNRemoveLinkPerDst(const NeuraNet* const that, const long iGroup,
+  const long offset) {
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  char* dstPlan = that->_dstPlan;
+  char* dstBase = that->_dstBase;
+  char* dstLinkStart = that->_dstLinkStart;
+  char* dstPos = that->_dstPos;
+  long nbGroup = that->_nbPackedGroups;
+  long nbLink = that->_nbPackedLinks;
+  // Get the group per destination, its destination and the index of 
+  // the link
+  long pos = NNPackedGet(dstPos, width, iGroup);
+  long iDst = NNPackedGet(dstPlan, width, 3 * pos + 1) - 
+    NNGetNbInput(that);
+  long iBase = NNPackedGet(dstLinkStart, width, pos) + offset;
+  // Remove the base function of the link, and shift the first link of
+  // the following groups
+  memmove(dstBase + width * iBase, dstBase + width * (iBase + 1), 
+    width * (nbLink - iBase - 1));
+  for (long p = pos + 1; p < nbGroup; ++p)
+    NNPackedSet(dstLinkStart, width, p, 
+      NNPackedGet(dstLinkStart, width, p) - 1);
+  // If the group has other links
+  long nb = NNPackedGet(dstPlan, width, 3 * pos + 2);
+  if (nb > 1) {
+    // Update its nb of links
+    NNPackedSet(dstPlan, width, 3 * pos + 2, nb - 1);
+    return;
+  }
+  // Remove the group, and shift the position of the following groups
+  memmove(dstPlan + width * 3 * pos, dstPlan + width * 3 * (pos + 1),
+    width * 3 * (nbGroup - pos - 1));
+  memmove(dstLinkStart + width * pos, dstLinkStart + width * (pos + 1),
+    width * (nbGroup - pos - 1));
+  memmove(dstPos + width * iGroup, dstPos + width * (iGroup + 1),
+    width * (nbGroup - iGroup - 1));
+  for (long jGroup = 0; jGroup < nbGroup - 1; ++jGroup) {
+    long p = NNPackedGet(dstPos, width, jGroup);
+    if (p > pos)
+      NNPackedSet(dstPos, width, jGroup, p - 1);
+  }
+  // Update the index of the first group of the following destinations
+  long nbDst = NNGetNbMaxHidden(that) + NNGetNbOutput(that);
+  long* dstGroupStart = that->_dstGroupStart->_val;
+  for (long jDst = iDst + 1; jDst <= nbDst; ++jDst)
+    --(dstGroupStart[jDst]);
+}
+
+// Helper function for NNInsertLinkInPlace
+// Add to the plan per destination of the NeuraNet 'that' the 
+// 'offset'-th link of the 'iGroup'-th group of its execution plan, 
+// having for input 'in', output 'out' and base function 'base', and 
+// the group too if 'isNew' is true
+// Must be called before adding the link to the execution plan
+void NNInsertLinkPerDst(const NeuraNet* const that, const long iGroup,
+  const long offset, const bool isNew, const long in, const long out, 
+  const long base) {
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  char* dstPlan = that->_dstPlan;
+  char* dstBase = that->_dstBase;
+  char* dstLinkStart = that->_dstLinkStart;
+  char* dstPos = that->_dstPos;
+  long nbGroup = that->_nbPackedGroups;
+  long nbLink = that->_nbPackedLinks;
+  long pos = 0;
+  // If the group already exists
+  if (!isNew) {
+    // Get the group per destination and update its nb of links
+    pos = NNPackedGet(dstPos, width, iGroup);
+    NNPackedSet(dstPlan, width, 3 * pos + 2, 
+      NNPackedGet(dstPlan, width, 3 * pos + 2) + 1);
+  } else {
+    // Search by dichotomy the position of the group among the groups 
+    // of its destination
+    long nbDst = NNGetNbMaxHidden(that) + NNGetNbOutput(that);
+    long* dstGroupStart = that->_dstGroupStart->_val;
+    long iDst = out - NNGetNbInput(that);
+    pos = dstGroupStart[iDst];
+    long end = dstGroupStart[iDst + 1];
+    while (pos < end) {
+      long p = (pos + end) / 2;
+      if (NNPackedGet(dstPlan, width, 3 * p) < in)
+        pos = p + 1;
+      else
+        end = p;
+    }
+    // Insert the group, starting at the first link of the group it 
+    // replaces, and shift the position of the following groups
+    long iBase = (pos < nbGroup ? 
+      NNPackedGet(dstLinkStart, width, pos) : nbLink);
+    memmove(dstPlan + width * 3 * (pos + 1), dstPlan + width * 3 * pos,
+      width * 3 * (nbGroup - pos));
+    memmove(dstLinkStart + width * (pos + 1), dstLinkStart + width * pos,
+      width * (nbGroup - pos));
+    NNPackedSet(dstPlan, width, 3 * pos, in);
+    NNPackedSet(dstPlan, width, 3 * pos + 1, out);
+    NNPackedSet(dstPlan, width, 3 * pos + 2, 1);
+    NNPackedSet(dstLinkStart, width, pos, iBase);
+    for (long jGroup = 0; jGroup < nbGroup; ++jGroup) {
+      long p = NNPackedGet(dstPos, width, jGroup);
+      if (p >= pos)
+        NNPackedSet(dstPos, width, jGroup, p + 1);
+    }
+    memmove(dstPos + width * (iGroup + 1), dstPos + width * iGroup,
+      width * (nbGroup - iGroup));
+    NNPackedSet(dstPos, width, iGroup, pos);
+    ++nbGroup;
+    // Update the index of the first group of the following 
+    // destinations
+    for (long jDst = iDst + 1; jDst <= nbDst; ++jDst)
+      ++(dstGroupStart[jDst]);
+  }
+  // Insert the base function of the link, and shift the first link of
+  // the following groups
+  long iBase = NNPackedGet(dstLinkStart, width, pos) + offset;
+  memmove(dstBase + width * (iBase + 1), dstBase + width * iBase, 
+    width * (nbLink - iBase));
+  NNPackedSet(dstBase, width, iBase, base);
+  for (long p = pos + 1; p < nbGroup; ++p)
+    NNPackedSet(dstLinkStart, width, p, 
+      NNPackedGet(dstLinkStart, width, p) + 1);
+}
+
+// Helper function for NNMoveLinksInPlace
+// Remove the active link of origin 'iOrigin' of the NeuraNet 'that' 
+// from its links and execution plan, and flag in 'isTouched' its 
+// destination if its group is removed
+void NNRemoveLinkInPlace(const NeuraNet* const that, const long iOrigin,
+  long* const isTouched) {
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  char* plan = that->_packedPlan;
+  long nbGroup = that->_nbPackedGroups;
+  long nbLink = that->_nbActiveLinks;
+  long iLink = VecGet(that->_linksPos, iOrigin);
+  long in = VecGet(that->_links, iLink * NN_NBPARAMLINK + 1);
+  long out = VecGet(that->_links, iLink * NN_NBPARAMLINK + 2);
+  // Get the group of the link and the index of the link in the group
+  long iGroup = NNSearchGroup(that, in, out);
+  long offset = iLink - NNSearchLink(that, nbLink, in, out, -1);
+  // Remove the link from the plan per destination if it has been 
+  // requested
+  if (that->_dstArena != NULL)
+    NNRemoveLinkPerDst(that, iGroup, offset);
+  // Move the link after the other active links and deactivate it
+  NNShiftLink(that, iLink, nbLink - 1);
+  VecSet(that->_links, (nbLink - 1) * NN_NBPARAMLINK, -1);
+  VecSet(that->_linksPos, iOrigin, -1);
+  *(long*)&(that->_nbActiveLinks) = nbLink - 1;
+  *(long*)&(that->_nbPackedLinks) = nbLink - 1;
+  // If the group has other links
+  long nb = NNPackedGet(plan, width, 3 * iGroup + 2);
+  if (nb > 1) {
+    // Update its nb of links
+    NNPackedSet(plan, width, 3 * iGroup + 2, nb - 1);
+    return;
+  }
+  // Remove the group
+  memmove(plan + width * 3 * iGroup, plan + width * 3 * (iGroup + 1),
+    width * 3 * (nbGroup - iGroup - 1));
+  *(long*)&(that->_nbPackedGroups) = nbGroup - 1;
+  // Update the index of the first group of the following inputs
+  long* srcGroupStart = that->_srcGroupStart->_val;
+  long nbSrc = NNGetNbInput(that) + NNGetNbMaxHidden(that);
+  for (long iVal = in + 1; iVal <= nbSrc; ++iVal)
+    --(srcGroupStart[iVal]);
+  // The level of the destination may change
+  isTouched[out - NNGetNbInput(that)] = 1;
+}
+
+// Helper function for NNMoveLinksInPlace
+// Insert the link 'link' of origin 'iOrigin', active and in bounds, 
+// in the links and execution plan of the NeuraNet 'that', and flag in
+// 'isTouched' its destination if a group is created for it
+void NNInsertLinkInPlace(const NeuraNet* const that, const long iOrigin,
+  const long* const link, long* const isTouched) {
+  // Declare variables for optimization
+  int width = that->_packedWidth;
+  char* plan = that->_packedPlan;
+  long nbGroup = that->_nbPackedGroups;
+  long nbLink = that->_nbActiveLinks;
+  long in = MIN(link[1], link[2]);
+  long out = MAX(link[1], link[2]);
+  // Add the link after the active links and move it to its position
+  long iLink = NNSearchLink(that, nbLink, in, out, iOrigin);
+  VecSet(that->_links, nbLink * NN_NBPARAMLINK, link[0]);
+  VecSet(that->_links, nbLink * NN_NBPARAMLINK + 1, in);
+  VecSet(that->_links, nbLink * NN_NBPARAMLINK + 2, out);
+  VecSet(that->_linksOrigin, nbLink, iOrigin);
+  NNPackedSet(that->_packedBases, width, nbLink, link[0]);
+  NNShiftLink(that, nbLink, iLink);
+  // Get the group of the link, and the index of the link in the group
+  long iGroup = NNSearchGroup(that, in, out);
+  bool isNew = (iGroup == VecGet(that->_srcGroupStart, in + 1) ||
+    NNPackedGet(plan, width, 3 * iGroup + 1) != out);
+  long offset = iLink - NNSearchLink(that, nbLink + 1, in, out, -1);
+  // Add the link to the plan per destination if it has been requested
+  if (that->_dstArena != NULL)
+    NNInsertLinkPerDst(that, iGroup, offset, isNew, in, out, link[0]);
+  *(long*)&(that->_nbActiveLinks) = nbLink + 1;
+  *(long*)&(that->_nbPackedLinks) = nbLink + 1;
+  // If the group already exists
+  if (!isNew) {
+    // Update its nb of links
+    NNPackedSet(plan, width, 3 * iGroup + 2, 
+      NNPackedGet(plan, width, 3 * iGroup + 2) + 1);
+    return;
+  }
+  // Insert the group
+  memmove(plan + width * 3 * (iGroup + 1), plan + width * 3 * iGroup,
+    width * 3 * (nbGroup - iGroup));
+  NNPackedSet(plan, width, 3 * iGroup, in);
+  NNPackedSet(plan, width, 3 * iGroup + 1, out);
+  NNPackedSet(plan, width, 3 * iGroup + 2, 1);
+  *(long*)&(that->_nbPackedGroups) = nbGroup + 1;
+  // Update the index of the first group of the following inputs
+  long* srcGroupStart = that->_srcGroupStart->_val;
+  long nbSrc = NNGetNbInput(that) + NNGetNbMaxHidden(that);
+  for (long iVal = in + 1; iVal <= nbSrc; ++iVal)
+    ++(srcGroupStart[iVal]);
+  // The level of the destination may change
+  isTouched[out - NNGetNbInput(that)] = 1;
+}
+
+// Helper function for NNUpdateLevelsInPlace
+// Move the 'iDst'-th destination of the NeuraNet 'that' from the 
+// level 'from' to the level 'to' (0 meaning it's in no level), 
+// '*nbLevel' being the current nb of levels, updated if levels are 
+// added
+// The destinations of a level stay in increasing order
+void NNMoveLevelDst(const NeuraNet* const that, const long iDst, 
+  const long from, const long to, long* const nbLevel) {
+  // Declare variables for optimization
+  long* levelStart = that->_levelStart->_val;
+  long* levelDst = that->_levelDst->_val;
+  // If the destination was in a level
+  if (from > 0) {
+    // Search the destination by dichotomy in its level
+    long iStart = levelStart[from - 1];
+    long iEnd = levelStart[from];
+    while (iStart < iEnd) {
+      long i = (iStart + iEnd) / 2;
+      if (levelDst[i] < iDst)
+        iStart = i + 1;
+      else
+        iEnd = i;
+    }
+    // Remove it and shift the start of the following levels
+    memmove(levelDst + iStart, levelDst + iStart + 1, 
+      sizeof(long) * (levelStart[*nbLevel] - iStart - 1));
+    for (long iLevel = from; iLevel <= *nbLevel; ++iLevel)
+      --(levelStart[iLevel]);
+  }
+  // If the destination goes in a level
+  if (to > 0) {
+    // Add the missing levels, empty
+    while (*nbLevel < to) {
+      levelStart[*nbLevel + 1] = levelStart[*nbLevel];
+      ++(*nbLevel);
+    }
+    // Search by dichotomy the position of the destination in its level
+    long iStart = levelStart[to - 1];
+    long iEnd = levelStart[to];
+    while (iStart < iEnd) {
+      long i = (iStart + iEnd) / 2;
+      if (levelDst[i] < iDst)
+        iStart = i + 1;
+      else
+        iEnd = i;
+    }
+    // Insert it and shift the start of the following levels
+    memmove(levelDst + iStart + 1, levelDst + iStart, 
+      sizeof(long) * (levelStart[*nbLevel] - iStart));
+    levelDst[iStart] = iDst;
+    for (long iLevel = to; iLevel <= *nbLevel; ++iLevel)
+      ++(levelStart[iLevel]);
+  }
+}
+
+// Helper function for NNMoveLinksInPlace
+// Update the levels of the destinations of the NeuraNet 'that' flagged
+// in 'isTouched', and of the destinations depending on them, from 
+// their groups in the plan per destination
+void NNUpdateLevelsInPlace(const NeuraNet* const that, 
+  long* const isTouched) {
+  // Declare variables for optimization
+  long nbHid = NNGetNbMaxHidden(that);
+  long nbDst = nbHid + NNGetNbOutput(that);
+  long startHid = NNGetNbInput(that);
+  int width = that->_packedWidth;
+  const long* dstGroupStart = that->_dstGroupStart->_val;
+  const long* srcGroupStart = that->_srcGroupStart->_val;
+  long* levelStart = that->_levelStart->_val;
+  long* level = that->_dstLevel->_val;
+  // Get the current nb of levels
+  long nbLevel = 0;
+  while (levelStart[nbLevel + 1] != -1)
+    ++nbLevel;
+  // Loop on the destinations in increasing order, a destination 
+  // depending only on lower ones (ignoring itself) its level is 
+  // updated after those of its inputs
+  for (long iDst = 0; iDst < nbDst; ++iDst) {
+    if (!isTouched[iDst])
+      continue;
+    // Calculate the level of the destination as in NNUpdateLevels
+    long lvl = 0;
+    for (long pos = dstGroupStart[iDst]; pos < dstGroupStart[iDst + 1];
+      ++pos) {
+      long in = NNPackedGet(that->_dstPlan, width, 3 * pos);
+      long l = 1;
+      if (in >= startHid && in - startHid != iDst)
+        l = level[in - startHid] + 1;
+      if (l > lvl)
+        lvl = l;
+    }
+    // If the level is unchanged, nothing to propagate
+    if (lvl == level[iDst])
+      continue;
+    // Move the destination to its new level
+    NNMoveLevelDst(that, iDst, level[iDst], lvl, &nbLevel);
+    level[iDst] = lvl;
+    // If it's a hidden value, flag the destinations depending on it
+    if (iDst < nbHid)
+      for (long iGroup = srcGroupStart[startHid + iDst]; 
+        iGroup < srcGroupStart[startHid + iDst + 1]; ++iGroup)
+        isTouched[NNPackedGet(that->_packedPlan, width, 
+          3 * iGroup + 1) - startHid] = 1;
+  }
+  // Remove the levels left empty at the top and mark the end of the 
+  // levels
+  while (nbLevel > 0 && levelStart[nbLevel] == levelStart[nbLevel - 1])
+    --nbLevel;
+  levelStart[nbLevel + 1] = -1;
+}
+
+// Helper function for NNUpdateLinks
+// Return true if the 'indices'-th links given to NNSetLinks of the 
+// NeuraNet 'that', some being moved, can be replaced with the links 
+// 'links' by NNMoveLinksInPlace
+// It requires the levels to be available (the links being sorted), 
+// all the active links to be in the plan, at most NN_MAXMOVEDLINKS 
+// modified links and these links to be in bounds
+bool NNCanMoveLinksInPlace(const NeuraNet* const that, 
+  const VecLong* const indices, const VecLong* const links) {
+  // If the levels are unavailable, or some links are out of the plan,
+  // or there are too many modified links
+  if (VecGet(that->_levelStart, 0) == -1 || 
+    that->_nbPackedLinks != that->_nbActiveLinks ||
+    VecGetDim(indices) > NN_MAXMOVEDLINKS)
+    return false;
+  // Declare variables to memorize the starting index of hidden 
+  // values and output values, and the index following the last output
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  long endOut = startOut + NNGetNbOutput(that);
+  // Loop on the modified links
+  for (long iChange = VecGetDim(indices); iChange--;) {
+    const long* link = links->_val + iChange * NN_NBPARAMLINK;
+    long in = MIN(link[1], link[2]);
+    long out = MAX(link[1], link[2]);
+    // If the link is active and out of bounds
+    if (link[0] != -1 && 
+      (in < 0 || in >= startOut || out < startHid || out >= endOut))
+      return false;
+  }
+  // Return the result
+  return true;
+}
+
+// Helper function for NNUpdateLinks
+// Replace the 'indices'-th links given to NNSetLinks of the NeuraNet 
+// 'that' with the links 'links', as NNMoveLinks and NNUpdatePlan, but
+// moving the links one by one and patching the execution plan, the 
+// plan per destination and the dependency levels in place
+// Without plan per destination the levels are flagged as outdated if
+// a group is created or removed
+void NNMoveLinksInPlace(const NeuraNet* const that, 
+  const VecLong* const indices, const VecLong* const links) {
+  // Declare variables for optimization
+  long nbDst = NNGetNbMaxHidden(that) + NNGetNbOutput(that);
+  // Get the flags of the destinations whose groups are created or 
+  // removed in the scratch memory
+  long* isTouched = NNGetScratch(that);
+  memset(isTouched, 0, sizeof(long) * nbDst);
+  // The base function indices of the moved links won't be implicit 
+  // anymore
+  NNSetPackedBasesExplicit(that);
+  // Loop on the modified links
+  for (long iChange = 0; iChange < VecGetDim(indices); ++iChange) {
+    const long* link = links->_val + iChange * NN_NBPARAMLINK;
+    long iOrigin = VecGet(indices, iChange);
+    long iLink = VecGet(that->_linksPos, iOrigin);
+    // If the link is active and stays active with the same input and
+    // output
+    if (iLink != -1 && link[0] != -1 && 
+      MIN(link[1], link[2]) == 
+        VecGet(that->_links, iLink * NN_NBPARAMLINK + 1) &&
+      MAX(link[1], link[2]) == 
+        VecGet(that->_links, iLink * NN_NBPARAMLINK + 2)) {
+      // Patch its base function
+      NNUpdateLinkBase(that, iLink, link[0]);
+    } else {
+      // Remove the link if it's active, and insert the new one if 
+      // it's active
+      if (iLink != -1)
+        NNRemoveLinkInPlace(that, iOrigin, isTouched);
+      if (link[0] != -1)
+        NNInsertLinkInPlace(that, iOrigin, link, isTouched);
+    }
+  }
+  // If the plan per destination has been requested
+  if (that->_dstArena != NULL) {
+    // Update the levels
+    NNUpdateLevelsInPlace(that, isTouched);
+  // Else, if some groups have been created or removed
+  } else {
+    for (long iDst = 0; iDst < nbDst; ++iDst)
+      if (isTouched[iDst]) {
+        // Flag the levels as outdated, they will be rebuilt when needed
+        VecSet(that->_levelStart, 0, -2);
+        break;
+      }
+  }
+}
+
+// Helper function for NNMoveLinks
+// Compare the sort keys 'a' and 'b' of two links, made of the bucket 
+// of their input, the bucket of their output and their origin
+// Return a negative value if 'a' is before 'b', a positive value if 
+// 'a' is after 'b', 0 if they are equal
+int NNCompareLinkKey(const void* const a, const void* const b) {
+  const long* keyA = a;
+  const long* keyB = b;
+  for (int iKey = 0; iKey < 3; ++iKey)
+    if (keyA[iKey] != keyB[iKey])
+      return (keyA[iKey] < keyB[iKey] ? -1 : 1);
+  return 0;
+}
+
+// Helper function for NNUpdateLinks
+// Replace the 'indices'-th links given to NNSetLinks among the 
+// 'nbLink' first links, all active, of the NeuraNet 'that' with the 
+// links 'links', at the position NNSetLinks would give them
+// The modified links are removed in one pass, then the active ones 
+// are sorted and merged with the other links in one pass
+void NNMoveLinks(const NeuraNet* const that, const VecLong* const indices,
+  const VecLong* const links, const long nbLink) {
+  // Declare variables for optimization
+  long nbVal = NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
+    NNGetNbOutput(that);
+  long* lnk = that->_links->_val;
+  long* origin = that->_linksOrigin->_val;
+  long* pos = that->_linksPos->_val;
+  long nbChange = VecGetDim(indices);
+  // Declare a variable to memorize the modified links which are active
+  // after the modification, with 6 values per link: its sort key 
+  // (bucket of input, bucket of output, origin), its base function, 
+  // its input and its output
+  long* inserted = PBErrMalloc(NeuraNetErr, 
+    sizeof(long) * 6 * (nbChange + 1));
+  long nbInserted = 0;
+  // Loop on the modified links
+  for (long iChange = 0; iChange < nbChange; ++iChange) {
+    const long* link = links->_val + iChange * NN_NBPARAMLINK;
+    long iOrigin = VecGet(indices, iChange);
+    // Flag the link to be removed if it's active
+    if (pos[iOrigin] != -1) {
+      lnk[pos[iOrigin] * NN_NBPARAMLINK] = -1;
+      pos[iOrigin] = -1;
+    }
+    // Memorize the link to be inserted if it's active
+    if (link[0] != -1) {
+      long* entry = inserted + 6 * (nbInserted++);
+      entry[4] = MIN(link[1], link[2]);
+      entry[5] = MAX(link[1], link[2]);
+      entry[0] = NNSortLinksBucket(entry[4], nbVal);
+      entry[1] = NNSortLinksBucket(entry[5], nbVal);
+      entry[2] = iOrigin;
+      entry[3] = link[0];
+    }
+  }
+  // Remove the flagged links, keeping the order of the other ones
+  long nbKept = 0;
+  for (long iLink = 0; iLink < nbLink; ++iLink) {
+    if (lnk[iLink * NN_NBPARAMLINK] != -1) {
+      if (iLink != nbKept) {
+        memcpy(lnk + nbKept * NN_NBPARAMLINK, 
+          lnk + iLink * NN_NBPARAMLINK, sizeof(long) * NN_NBPARAMLINK);
+        origin[nbKept] = origin[iLink];
+        pos[origin[nbKept]] = nbKept;
+      }
+      ++nbKept;
+    }
+  }
+  // Sort the links to insert on their key
+  qsort(inserted, nbInserted, sizeof(long) * 6, NNCompareLinkKey);
+  // Merge the links to insert with the kept ones, from the end, until
+  // all the links to insert are in place
+  long iKept = nbKept - 1;
+  long iInsert = nbInserted - 1;
+  for (long iLink = nbKept + nbInserted - 1; iInsert >= 0; --iLink) {
+    const long* entry = inserted + 6 * iInsert;
+    // The link to insert goes here unless the last kept link is after
+    // it
+    bool isInsert = true;
+    if (iKept >= 0) {
+      const long* link = lnk + iKept * NN_NBPARAMLINK;
+      long key[3] = {NNSortLinksBucket(link[1], nbVal), 
+        NNSortLinksBucket(link[2], nbVal), origin[iKept]};
+      isInsert = (NNCompareLinkKey(key, entry) < 0);
+    }
+    if (isInsert) {
+      lnk[iLink * NN_NBPARAMLINK] = entry[3];
+      lnk[iLink * NN_NBPARAMLINK + 1] = entry[4];
+      lnk[iLink * NN_NBPARAMLINK + 2] = entry[5];
+      origin[iLink] = entry[2];
+      --iInsert;
+    } else {
+      memcpy(lnk + iLink * NN_NBPARAMLINK, lnk + iKept * NN_NBPARAMLINK,
+        sizeof(long) * NN_NBPARAMLINK);
+      origin[iLink] = origin[iKept];
+      --iKept;
+    }
+    pos[origin[iLink]] = iLink;
+  }
+  // Reset the links left inactive
+  for (long iLink = nbKept + nbInserted; iLink < nbLink; ++iLink)
+    lnk[iLink * NN_NBPARAMLINK] = -1;
+  free(inserted);
+}
+
+// Update the links of the NeuraNet 'that' as if the links last given
+// to NNSetLinks had been modified by replacing their 'indices'-th 
+// links with the links in 'links' and given again to NNSetLinks
+// 'links' contains NN_NBPARAMLINK values per index in 'indices', 
+// the indices must be different
+// If the links of 'that' have not been set with NNSetLinks, their 
+// indices are those in NNLinks(that)
+// If only the base function of the modified links is modified, they 
+// are patched in place in the execution plan in time proportional to
+// the nb of links sharing their input, unless the base function 
+// indices of the plan can't stay implicit or some links out of bounds
+// are left out of the plan, which costs O(L) for L active links
+// Else, if at most NN_MAXMOVEDLINKS links are moved, all in bounds, 
+// they are moved one by one: the links between their old and new 
+// position are shifted, the groups of the plan and of the plan per 
+// destination are patched in place, which shifts the groups and
+// indices following the modified ones, and only the levels of the 
+// destinations whose groups are created or removed, and of the 
+// destinations depending on them, are updated
+// Without plan per destination, the levels are only flagged as 
+// outdated and rebuilt when needed (see NNGetNbLevel)
+// Else, the k modified links are moved to their new position in 
+// O(L+k.log(k)) and the execution plan and dependency levels are 
+// rebuilt in O(L), only the sort of all the links by NNSetLinks is 
+// saved
+void NNUpdateLinks(NeuraNet* const that, const VecLong* const indices,
+  const VecLong* const links) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (indices == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'indices' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (links == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'links' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(links) != VecGetDim(indices) * NN_NBPARAMLINK) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'links' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(links), VecGetDim(indices) * NN_NBPARAMLINK);
+    PBErrCatch(NeuraNetErr);
+  }
+  for (long iChange = VecGetDim(indices); iChange--;)
+    if (VecGet(indices, iChange) < 0 || 
+      VecGet(indices, iChange) >= that->_nbMaxLinks) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg, 
+        "'indices' is invalid (0<=%ld<%ld)", 
+        VecGet(indices, iChange), that->_nbMaxLinks);
+      PBErrCatch(NeuraNetErr);
+    }
+#endif
+  // Expand the links if they are implicit, or unbind them if they are
+  // bound
+  NNExpandLinks(that);
+  NNUnbindLinks(that);
+  // The links may not match anymore the geometry of the convolution 
+  // layers, discard it
+  NNConvGeometryFree(&(that->_conv));
+  // Declare a variable to memorize if some links are moved, and loop
+  // on the modified links to check it
+  bool isMoved = false;
+  for (long iChange = VecGetDim(indices); iChange-- && !isMoved;) {
+    const long* link = links->_val + iChange * NN_NBPARAMLINK;
+    long iLink = VecGet(that->_linksPos, VecGet(indices, iChange));
+    // The link is moved unless it is active and stays active with 
+    // the same input and output
+    if (iLink == -1 || link[0] == -1 || 
+      MIN(link[1], link[2]) != 
+        VecGet(that->_links, iLink * NN_NBPARAMLINK + 1) ||
+      MAX(link[1], link[2]) != 
+        VecGet(that->_links, iLink * NN_NBPARAMLINK + 2))
+      isMoved = true;
+  }
+  // If no link is moved
+  if (!isMoved) {
+    // Patch the base function of the modified links
+    for (long iChange = VecGetDim(indices); iChange--;)
+      NNUpdateLinkBase(that, 
+        VecGet(that->_linksPos, VecGet(indices, iChange)), 
+        VecGet(links, iChange * NN_NBPARAMLINK));
+    return;
+  }
+  // If the links can be moved one by one
+  if (NNCanMoveLinksInPlace(that, indices, links)) {
+    // Move them and patch the execution plan
+    NNMoveLinksInPlace(that, indices, links);
+  } else {
+    // Get the nb of active links
+    long nbLink = 0;
+    while (nbLink < NNGetNbMaxLinks(that) && 
+      VecGet(that->_links, nbLink * NN_NBPARAMLINK) != -1)
+      ++nbLink;
+    // Move the modified links to their new position
+    NNMoveLinks(that, indices, links, nbLink);
+    // Update the execution plan
+    NNUpdatePlan(that);
+  }
+  // If the links don't match anymore the layers, discard them
+  if (that->_layers != NULL && !NNLinksMatchLayers(that))
+    VecFree(&(that->_layers));
+}
+
+// Bind the links description of the NeuraNet 'that' to 'links', 
+// without copying nor sorting them
+// 'links' must be in the order of NNLinks(that) after NNSetLinks: 
+// active links first, in increasing value of input id and output id,
+// the input id not higher than the output id, then inactive links
+void NNBindLinks(NeuraNet* const that, const VecLong* const links) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (links == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'links' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (VecGetDim(output) != that->_nbOutputVal) {
+  if (VecGetDim(links) != that->_nbMaxLinks * NN_NBPARAMLINK) {
     NeuraNetErr->_type = PBErrTypeInvalidArg;
     sprintf(NeuraNetErr->_msg, 
-      "'output' 's dimension is invalid (%ld!=%d)", 
-      VecGetDim(output), that->_nbOutputVal);
+      "'links' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(links), that->_nbMaxLinks * NN_NBPARAMLINK);
     PBErrCatch(NeuraNetErr);
   }
-#endif
-  // Reset the hidden values and output
-  if (NNGetNbMaxHidden(that) > 0)
-    VecSetNull(that->_hidVal);
-  VecSetNull(output);
-  // If there are links in the network
-  if (VecGet(that->_links, 0) != -1) {
-    // Declare two variables to memorize the starting index of hidden 
-    // values and output values in the link definition
-    long startHid = NNGetNbInput(that);
-    long startOut = NNGetNbMaxHidden(that) + NNGetNbInput(that);
-    // Declare a variable to memorize the previous link
-    long prevLink[2] = {-1, -1};
-    // Declare a variable to memorize the previous output value
-    float prevOut = 1.0;
-    // Loop on links
-    long iLink = 0;
-    while (iLink < NNGetNbMaxLinks(that) && 
-      VecGet(that->_links, NN_NBPARAMLINK * iLink) != -1) {
-      // Declare a variable for optimization
-      long jLink = NN_NBPARAMLINK * iLink;
-      // If this link has different input or output than previous link
-      // and we are not on the first link
-      if (iLink != 0 && 
-        (VecGet(that->_links, jLink + 1) != prevLink[0] ||
-        VecGet(that->_links, jLink + 2) != prevLink[1])) {
-        // Add the previous output value to the output of the previous 
-        // link
-        if (prevLink[1] < startOut) {
-          long iVal = prevLink[1] - startHid;
-          float nVal = MIN(1.0, MAX(-1.0, VecGet(that->_hidVal, iVal) + prevOut));
-          VecSet(that->_hidVal, iVal, nVal);
-        } else { 
-          long iVal = prevLink[1] - startOut;
-          float nVal = VecGet(output, iVal) + prevOut;
-          VecSet(output, iVal, nVal);
-        }
-        // Reset the previous output 
-        prevOut = 1.0;
-      }
-      // Update the previous link
-      prevLink[0] = VecGet(that->_links, jLink + 1);
-      prevLink[1] = VecGet(that->_links, jLink + 2);
-      // Multiply the previous output by the evaluation of the current 
-      // link with the base function of the link and the normalised 
-      // input value
-      float* param = that->_bases->_val + 
-        VecGet(that->_links, jLink) * NN_NBPARAMBASE;
-      float x = 0.0;
-      if (prevLink[0] < startHid)
-        x = VecGet(input, prevLink[0]);
-      else
-        x = NNGetHiddenValue(that, prevLink[0] - startHid);
-      prevOut *= NNBaseFun(param, x);
-      // Move to the next link
-      ++iLink;
-    }
-    // Update the output of the last link
-    if (prevLink[1] < startOut) {
-      long iVal = prevLink[1] - startHid;
-      float nVal = 
-        MIN(1.0, MAX(-1.0, VecGet(that->_hidVal, iVal) + prevOut));
-      VecSet(that->_hidVal, iVal, nVal);
-    } else { 
-      long iVal = prevLink[1] - startOut;
-      float nVal = VecGet(output, iVal) + prevOut;
-      VecSet(output, iVal, nVal);
+  bool isActive = true;
+  for (long iLink = 0; iLink < that->_nbMaxLinks; ++iLink) {
+    const long* link = links->_val + iLink * NN_NBPARAMLINK;
+    const long* prev = (iLink > 0 ? link - NN_NBPARAMLINK : link);
+    if (link[0] == -1) {
+      isActive = false;
+    } else if (!isActive || link[1] > link[2] || prev[1] > link[1] || 
+      (prev[1] == link[1] && prev[2] > link[2])) {
+      NeuraNetErr->_type = PBErrTypeInvalidArg;
+      sprintf(NeuraNetErr->_msg, 
+        "'links' is not sorted (link %ld)", iLink);
+      PBErrCatch(NeuraNetErr);
     }
   }
+#endif
+  // The links may not match anymore the geometry of the convolution 
+  // layers, discard it
+  NNConvGeometryFree(&(that->_conv));
+  // Allocate the links if they were implicit, the allocated links 
+  // are kept aside for when the links are unbound
+  NNAllocateLinks(that);
+  // Set aside the links of the NeuraNet if they are not bound yet
+  if (that->_ownLinks == NULL)
+    that->_ownLinks = that->_links;
+  // Bind the links
+  that->_links = (VecLong*)links;
+  // Reset the origin of the links and update the execution plan
+  NNResetLinksOrigin(that);
+  NNUpdatePlan(that);
+  // If the links don't match anymore the layers, discard them
+  if (that->_layers != NULL && !NNLinksMatchLayers(that))
+    VecFree(&(that->_layers));
 }
 
-// Function which return the JSON encoding of 'that' 
-JSONNode* NNEncodeAsJSON(const NeuraNet* const that) {
+// Unbind the links description of the NeuraNet 'that' by copying it 
+// in the memory of the NeuraNet
+// Do nothing if it is not bound
+void NNUnbindLinks(const NeuraNet* const that) {
 #if BUILDMODE == 0
   if (that == NULL) {
-    PBMathErr->_type = PBErrTypeNullPointer;
-    sprintf(PBMathErr->_msg, "'that' is null");
-    PBErrCatch(PBMathErr);
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Create the JSON structure
-  JSONNode* json = JSONCreate();
-  // Declare a buffer to convert value into string
-  char val[100];
-  // Encode the nbInputVal
-  sprintf(val, "%d", that->_nbInputVal);
-  JSONAddProp(json, "_nbInputVal", val);
-  // Encode the nbOutputVal
-  sprintf(val, "%d", that->_nbOutputVal);
-  JSONAddProp(json, "_nbOutputVal", val);
-  // Encode the nbMaxHidVal
-  sprintf(val, "%ld", that->_nbMaxHidVal);
-  JSONAddProp(json, "_nbMaxHidVal", val);
-  // Encode the nbMaxBases
-  sprintf(val, "%ld", that->_nbMaxBases);
-  JSONAddProp(json, "_nbMaxBases", val);
-  // Encode the nbMaxLinks
-  sprintf(val, "%ld", that->_nbMaxLinks);
-  JSONAddProp(json, "_nbMaxLinks", val);
-  // Encode the bases
-  JSONAddProp(json, "_bases", VecEncodeAsJSON(that->_bases));
-  // Encode the links
-  JSONAddProp(json, "_links", VecEncodeAsJSON(that->_links));
-  // Return the created JSON 
-  return json;
+  // If the links are not bound
+  if (that->_ownLinks == NULL)
+    // Nothing to do
+    return;
+  // Copy the bound links in the links of the NeuraNet, the execution
+  // plan stays the same
+  VecCopy(that->_ownLinks, that->_links);
+  *(VecLong**)&(that->_links) = that->_ownLinks;
+  *(VecLong**)&(that->_ownLinks) = NULL;
 }
 
-// Function which decode from JSON encoding 'json' to 'that'
-bool NNDecodeAsJSON(NeuraNet** that, const JSONNode* const json) {
+// Create a new NNPlanCache of 'nbEntry' entries for NeuraNets of the 
+// same dimensions as the NeuraNet 'that'
+NNPlanCache* NNPlanCacheCreate(const NeuraNet* const that, 
+  const long nbEntry) {
 #if BUILDMODE == 0
   if (that == NULL) {
-    PBMathErr->_type = PBErrTypeNullPointer;
-    sprintf(PBMathErr->_msg, "'that' is null");
-    PBErrCatch(PBMathErr);
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
+    PBErrCatch(NeuraNetErr);
   }
-  if (json == NULL) {
-    PBMathErr->_type = PBErrTypeNullPointer;
-    sprintf(PBMathErr->_msg, "'json' is null");
-    PBErrCatch(PBMathErr);
+  if (nbEntry <= 0) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'nbEntry' is invalid (0<%ld)", nbEntry);
+    PBErrCatch(NeuraNetErr);
   }
 #endif
-  // If 'that' is already allocated
-  if (*that != NULL)
-    // Free memory
-    NeuraNetFree(that);
-  // Decode the nbInputVal
-  JSONNode* prop = JSONProperty(json, "_nbInputVal");
-  if (prop == NULL) {
-    return false;
-  }
-  int nbInputVal = atoi(JSONLblVal(prop));
-  // Decode the nbOutputVal
-  prop = JSONProperty(json, "_nbOutputVal");
-  if (prop == NULL) {
-    return false;
-  }
-  int nbOutputVal = atoi(JSONLblVal(prop));
-  // Decode the nbMaxHidVal
-  prop = JSONProperty(json, "_nbMaxHidVal");
-  if (prop == NULL) {
-    return false;
-  }
-  long nbMaxHidVal = atol(JSONLblVal(prop));
-  // Decode the nbMaxBases
-  prop = JSONProperty(json, "_nbMaxBases");
-  if (prop == NULL) {
-    return false;
-  }
-  long nbMaxBases = atol(JSONLblVal(prop));
-  // Decode the nbMaxLinks
-  prop = JSONProperty(json, "_nbMaxLinks");
-  if (prop == NULL) {
-    return false;
-  }
-  long nbMaxLinks = atol(JSONLblVal(prop));
-  // Allocate memory
-  *that = NeuraNetCreate(nbInputVal, nbOutputVal, nbMaxHidVal, 
-    nbMaxBases, nbMaxLinks);
-  // Decode the bases
-  prop = JSONProperty(json, "_bases");
-  if (prop == NULL) {
-    return false;
-  }
-  if (!VecDecodeAsJSON(&((*that)->_bases), prop)) {
-    return false;
-  }
-  // Decode the links
-  prop = JSONProperty(json, "_links");
-  if (prop == NULL) {
-    return false;
+  // Declare the new NNPlanCache
+  NNPlanCache* cache = PBErrMalloc(NeuraNetErr, sizeof(NNPlanCache));
+  // Set properties
+  *(int*)&(cache->_nbInputVal) = NNGetNbInput(that);
+  *(int*)&(cache->_nbOutputVal) = NNGetNbOutput(that);
+  *(long*)&(cache->_nbMaxHidVal) = NNGetNbMaxHidden(that);
+  *(long*)&(cache->_nbMaxBases) = NNGetNbMaxBases(that);
+  *(long*)&(cache->_nbMaxLinks) = NNGetNbMaxLinks(that);
+  *(size_t*)&(cache->_sizeLinks) = NNArenaLinks(that, NULL);
+  *(long*)&(cache->_nbEntry) = nbEntry;
+  // The memory of the entries is allocated when they are used
+  cache->_entries = 
+    PBErrMalloc(NeuraNetErr, sizeof(NNPlanCacheEntry) * nbEntry);
+  for (long iEntry = nbEntry; iEntry--;) {
+    cache->_entries[iEntry]._links = NULL;
+    cache->_entries[iEntry]._linksArena = NULL;
   }
-  if (!VecDecodeAsJSON(&((*that)->_links), prop)) {
-    return false;
+  NNPlanCacheFlush(cache);
+  // Return the new NNPlanCache
+  return cache;
+}
+
+// Free the memory used by the NNPlanCache 'that'
+void NNPlanCacheFree(NNPlanCache** that) {
+  // Check argument
+  if (that == NULL || *that == NULL)
+    // Nothing to do
+    return;
+  // Free memory
+  for (long iEntry = (*that)->_nbEntry; iEntry--;) {
+    VecFree(&((*that)->_entries[iEntry]._links));
+    free((*that)->_entries[iEntry]._linksArena);
   }
-  // Return the success code
-  return true;
+  free((*that)->_entries);
+  free(*that);
+  *that = NULL;
 }
 
-// Save the NeuraNet 'that' to the stream 'stream'
-// If 'compact' equals true it saves in compact form, else it saves in 
-// readable form
-// Return true if the NeuraNet could be saved, false else
-bool NNSave(const NeuraNet* const that, FILE* const stream, const bool compact) {
+// Empty the NNPlanCache 'that' and reset its counters
+void NNPlanCacheFlush(NNPlanCache* const that) {
 #if BUILDMODE == 0
   if (that == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
     sprintf(NeuraNetErr->_msg, "'that' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (stream == NULL) {
-    NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'stream' is null");
-    PBErrCatch(NeuraNetErr);
-  }
 #endif
-  // Get the JSON encoding
-  JSONNode* json = NNEncodeAsJSON(that);
-  // Save the JSON
-  if (!JSONSave(json, stream, compact)) {
-    return false;
+  // Mark all the entries as unused, their memory is kept for reuse
+  for (long iEntry = that->_nbEntry; iEntry--;)
+    that->_entries[iEntry]._lastUse = 0;
+  // Reset the counters
+  that->_nbUse = 0;
+  that->_nbHit = 0;
+  that->_nbMiss = 0;
+}
+
+// Helper function for NNSetLinksCached
+// Return the hash of the links 'links', calculated with FNV-1a on one
+// key per link packing its values, or -1 if the link is inactive
+uint64_t NNPlanCacheHash(const VecLong* const links) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (long iLink = 0; iLink < VecGetDim(links) / NN_NBPARAMLINK; 
+    ++iLink) {
+    const long* link = links->_val + iLink * NN_NBPARAMLINK;
+    uint64_t key = (link[0] == -1 ? UINT64_MAX : 
+      (uint64_t)(link[0]) ^ ((uint64_t)(link[1]) << 21) ^ 
+      ((uint64_t)(link[2]) << 42));
+    hash = (hash ^ key) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Helper function for NNSetLinksCached
+// Return true if the links 'links' and 'linksB' are the same, that is
+// their active links are equal at the same indices, else false
+bool NNPlanCacheIsSameLinks(const VecLong* const links, 
+  const VecLong* const linksB) {
+  for (long iLink = 0; iLink < VecGetDim(links) / NN_NBPARAMLINK; 
+    ++iLink) {
+    const long* link = links->_val + iLink * NN_NBPARAMLINK;
+    const long* linkB = linksB->_val + iLink * NN_NBPARAMLINK;
+    if (link[0] != linkB[0] || 
+      (link[0] != -1 && (link[1] != linkB[1] || link[2] != linkB[2])))
+      return false;
   }
-  // Free memory
-  JSONFree(&json);
-  // Return success code
   return true;
 }
 
-// Load the NeuraNet 'that' from the stream 'stream'
-// If 'that' is not null the memory is first freed 
-// Return true if the NeuraNet could be loaded, false else
-bool NNLoad(NeuraNet** that, FILE* const stream) {
+// Set the links description of the NeuraNet 'that' to a copy of 
+// 'links' as NNSetLinks, using the NNPlanCache 'cache'
+// If the same links have already been set with 'cache' and are still
+// in it, the links and execution plan are copied from it instead of 
+// being sorted and built again, else they are built by NNSetLinks and
+// added to 'cache'
+void NNSetLinksCached(NeuraNet* const that, VecLong* const links, 
+  NNPlanCache* const cache) {
 #if BUILDMODE == 0
   if (that == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
     sprintf(NeuraNetErr->_msg, "'that' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (stream == NULL) {
+  if (links == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'stream' is null");
+    sprintf(NeuraNetErr->_msg, "'links' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (cache == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'cache' is null");
+    PBErrCatch(NeuraNetErr);
+  }
+  if (VecGetDim(links) != that->_nbMaxLinks * NN_NBPARAMLINK) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'links' 's dimension is invalid (%ld!=%ld)", 
+      VecGetDim(links), that->_nbMaxLinks);
+    PBErrCatch(NeuraNetErr);
+  }
+  if (NNGetNbInput(that) != cache->_nbInputVal ||
+    NNGetNbOutput(that) != cache->_nbOutputVal ||
+    NNGetNbMaxHidden(that) != cache->_nbMaxHidVal ||
+    NNGetNbMaxBases(that) != cache->_nbMaxBases ||
+    NNGetNbMaxLinks(that) != cache->_nbMaxLinks) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, 
+      "'cache' 's dimensions are different from the ones of 'that'");
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Declare a json to load the encoded data
-  JSONNode* json = JSONCreate();
-  // Load the whole encoded data
-  if (!JSONLoad(json, stream)) {
-    return false;
+  // Update the use counter
+  ++(cache->_nbUse);
+  // Search the links in the cache, and the least recently used entry
+  uint64_t hash = NNPlanCacheHash(links);
+  NNPlanCacheEntry* entry = NULL;
+  NNPlanCacheEntry* lru = cache->_entries;
+  for (long iEntry = 0; iEntry < cache->_nbEntry && entry == NULL; 
+    ++iEntry) {
+    NNPlanCacheEntry* e = cache->_entries + iEntry;
+    if (e->_lastUse != 0 && e->_hash == hash && 
+      NNPlanCacheIsSameLinks(e->_links, links))
+      entry = e;
+    else if (e->_lastUse < lru->_lastUse)
+      lru = e;
   }
-  // Decode the data from the JSON
-  if (!NNDecodeAsJSON(that, json)) {
-    return false;
+  // If the links are in the cache
+  if (entry != NULL) {
+    ++(cache->_nbHit);
+    // Prepare the links as NNSetLinks
+    NNConvGeometryFree(&(that->_conv));
+    NNReleaseLinks(that);
+    NNAllocateLinks(that);
+    // Copy the links and execution plan, they are laid out the same
+    // in the entry and in the NeuraNet
+    memcpy(that->_linksArena, entry->_linksArena, cache->_sizeLinks);
+    *(void**)&(that->_packedBases) = 
+      (entry->_hasPackedBases ? NNArenaPackedBases(that) : NULL);
+    *(long*)&(that->_nbPackedGroups) = entry->_nbPackedGroups;
+    *(long*)&(that->_nbPackedLinks) = entry->_nbPackedLinks;
+    *(long*)&(that->_nbActiveLinks) = entry->_nbActiveLinks;
+    // Update the plan per destination if it has been requested, it is
+    // not in the cache
+    if (that->_dstArena != NULL)
+      NNUpdatePlanPerDst(that);
+    // If the links don't match anymore the layers, discard them
+    if (that->_layers != NULL && !NNLinksMatchLayers(that))
+      VecFree(&(that->_layers));
+  // Else, the links are not in the cache
+  } else {
+    ++(cache->_nbMiss);
+    // Set the links
+    NNSetLinks(that, links);
+    // Replace the least recently used entry with the links, allocating
+    // its memory if it has never been used
+    entry = lru;
+    if (entry->_links == NULL) {
+      entry->_links = VecLongCreate(VecGetDim(links));
+      entry->_linksArena = 
+        NNErrAlignedMalloc(NeuraNetErr, cache->_sizeLinks);
+    }
+    entry->_hash = hash;
+    VecCopy(entry->_links, links);
+    memcpy(entry->_linksArena, that->_linksArena, cache->_sizeLinks);
+    entry->_nbPackedGroups = that->_nbPackedGroups;
+    entry->_nbPackedLinks = that->_nbPackedLinks;
+    entry->_nbActiveLinks = that->_nbActiveLinks;
+    entry->_hasPackedBases = (that->_packedBases != NULL);
   }
-  // Free the memory used by the JSON
-  JSONFree(&json);
-  // Return the success code
-  return true;
+  // Memorize the use of the entry
+  entry->_lastUse = cache->_nbUse;
 }
 
-// Print the NeuraNet 'that' to the stream 'stream'
-void NNPrintln(const NeuraNet* const that, FILE* const stream) {
+// Set the order of the groups of links evaluated by NNEval for the 
+// NeuraNet 'that' to 'order'
+// The links themselves are not reordered and the results are the 
+// same whatever the order
+// The NNLinkOrderOutputMajor order builds the execution plan per 
+// destination (see NNSetPlanPerDst)
+void NNSetLinkOrder(NeuraNet* const that, const NNLinkOrder order) {
 #if BUILDMODE == 0
   if (that == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
     sprintf(NeuraNetErr->_msg, "'that' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (stream == NULL) {
-    NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'stream' is null");
+  if (order != NNLinkOrderInputMajor && 
+    order != NNLinkOrderOutputMajor) {
+    NeuraNetErr->_type = PBErrTypeInvalidArg;
+    sprintf(NeuraNetErr->_msg, "'order' is invalid (%d)", order);
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  fprintf(stream, "nbInput: %d\n", that->_nbInputVal);
-  fprintf(stream, "nbOutput: %d\n", that->_nbOutputVal);
-  fprintf(stream, "nbHidden: %ld\n", that->_nbMaxHidVal);
-  fprintf(stream, "nbMaxBases: %ld\n", that->_nbMaxBases);
-  fprintf(stream, "nbMaxLinks: %ld\n", that->_nbMaxLinks);
-  fprintf(stream, "bases: ");
-  VecPrint(that->_bases, stream);
-  fprintf(stream, "\n");
-  fprintf(stream, "links: ");
-  VecPrint(that->_links, stream);
-  fprintf(stream, "\n");
-  fprintf(stream, "hidden values: ");
-  VecPrint(that->_hidVal, stream);
-  fprintf(stream, "\n");
+  // If the order doesn't change
+  if (that->_linkOrder == order)
+    // Nothing to do
+    return;
+  // Set the order
+  *(NNLinkOrder*)&(that->_linkOrder) = order;
+  // The output major order needs the plan per destination
+  if (order == NNLinkOrderOutputMajor)
+    NNSetPlanPerDst(that, true);
 }
 
-// Set the links description of the NeuraNet 'that' to a copy of 'links'
-// Links with a base function equals to -1 are ignored
-// If the input id is higher than the output id they are swap
-// The links description in the NeuraNet are ordered in increasing 
-// value of input id and output id, but 'links' doesn't have to be 
-// sorted
-// Each link is defined by (base index, input index, output index)
-// If base index equals -1 it means the link is inactive
-void NNSetLinks(NeuraNet* const that, VecLong* const links) {
+// Allocate and build the execution plan per destination of the 
+// NeuraNet 'that' if 'flag' is true, else free it
+// It is kept while the NeuraNet is in the NNLinkOrderOutputMajor order
+void NNSetPlanPerDst(NeuraNet* const that, const bool flag) {
 #if BUILDMODE == 0
   if (that == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
     sprintf(NeuraNetErr->_msg, "'that' is null");
     PBErrCatch(NeuraNetErr);
   }
-  if (links == NULL) {
-    NeuraNetErr->_type = PBErrTypeNullPointer;
-    sprintf(NeuraNetErr->_msg, "'links' is null");
-    PBErrCatch(NeuraNetErr);
+#endif
+  // If the plan per destination is requested and not allocated yet
+  if (flag && that->_dstArena == NULL) {
+    // Allocate it
+    size_t size = NNArenaPlanPerDst(that, NULL);
+    that->_dstArena = NNErrAlignedMalloc(NeuraNetErr, size);
+    NNArenaPlanPerDst(that, that->_dstArena);
+    // Build it with the levels, which may be outdated, if the links
+    // are explicit, else it will be built when they are expanded
+    if (that->_links != NULL)
+      NNUpdateLevels(that);
+  // Else, if the plan per destination is not requested anymore and 
+  // the order of the links doesn't need it
+  } else if (!flag && that->_dstArena != NULL && 
+    that->_linkOrder != NNLinkOrderOutputMajor) {
+    // Free it
+    free(that->_dstArena);
+    that->_dstArena = NULL;
+    that->_dstPlan = NULL;
+    that->_dstBase = NULL;
+    that->_dstLinkStart = NULL;
+    that->_dstPos = NULL;
   }
-  if (VecGetDim(links) != that->_nbMaxLinks * NN_NBPARAMLINK) {
-    NeuraNetErr->_type = PBErrTypeInvalidArg;
-    sprintf(NeuraNetErr->_msg, 
-      "'links' 's dimension is invalid (%ld!=%ld)", 
-      VecGetDim(links), that->_nbMaxLinks);
+}
+
+// Get the number of dependency levels of the NeuraNet 'that'
+// Return -1 if the levels are unavailable
+// The levels are rebuilt if they have been outdated by NNUpdateLinks,
+// which modifies the NeuraNet, it must not happen concurrently with 
+// another use of the NeuraNet
+long NNGetNbLevel(const NeuraNet* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    NeuraNetErr->_type = PBErrTypeNullPointer;
+    sprintf(NeuraNetErr->_msg, "'that' is null");
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Declare a GSet to sort the links
-  GSet set = GSetCreateStatic();
-  // Declare a variable to memorize the maximum id
-  long maxId = NNGetNbInput(that) + NNGetNbMaxHidden(that) + 
-    NNGetNbOutput(that);
-  // Loop on links
-  for (long iLink = 0; iLink < NNGetNbMaxLinks(that) * NN_NBPARAMLINK; 
-    iLink += NN_NBPARAMLINK) {
-    // If this link is active
-    if (VecGet(links, iLink) != -1) {
-      // Declare two variables to memorize the effective input and output
-      long in = VecGet(links, iLink + 1);
-      long out = VecGet(links, iLink + 2);
-      // If the input is greater than the output
-      if (in > out) {
-        // Swap the input and output
-        swap(in, out);
-      }
-      // Add the link to the set, sorting on input and ouput
-      float sortVal = (float)(in * maxId + out);
-      GSetAddSort(&set, links->_val + iLink, sortVal);
-    }
-  }
-  // Declare a variable to memorize the number of active links
-  long nbLink = GSetNbElem(&set);
-  // If there are active links
-  if (nbLink > 0) {
-    // loop on active sorted links
-    GSetIterForward iter = GSetIterForwardCreateStatic(&set);
-    long iLink = 0;
-    do {
-      long *link = GSetIterGet(&iter);
-      VecSet(that->_links, iLink * NN_NBPARAMLINK, link[0]);
-      if (link[1] <= link[2]) {
-        VecSet(that->_links, iLink * NN_NBPARAMLINK + 1, link[1]);
-        VecSet(that->_links, iLink * NN_NBPARAMLINK + 2, link[2]);
-      } else {
-        VecSet(that->_links, iLink * NN_NBPARAMLINK + 1, link[2]);
-        VecSet(that->_links, iLink * NN_NBPARAMLINK + 2, link[1]);
-      }
-      ++iLink;
-    } while (GSetIterStep(&iter));
-  }
-  // Reset the inactive links
-  for (long iLink = nbLink; iLink < NNGetNbMaxLinks(that); ++iLink)
-    VecSet(that->_links, iLink * NN_NBPARAMLINK, -1);
-  // Free the memory
-  GSetFlush(&set);
+  // Expand the links if they are implicit
+  NNExpandLinks(that);
+  // Rebuild the levels if they are outdated
+  if (VecGet(that->_levelStart, 0) == -2)
+    NNUpdateLevels(that);
+  // If the levels are unavailable
+  if (VecGet(that->_levelStart, 0) == -1)
+    return -1;
+  // Count the levels
+  long nbLevel = 0;
+  while (VecGet(that->_levelStart, nbLevel + 1) != -1)
+    ++nbLevel;
+  // Return the result
+  return nbLevel;
 }
 
 // Save the links of the NeuraNet 'that' into the file at 'url' in a 
@@ -1001,8 +6705,11 @@ float NNGetHiddenValSimpsonDiv(const NeuraNet* const that) {
 }
 
 // Prune the NeuraNet 'that' by removing the useless links (those with 
-// no influence on outputs
-void NNPrune(const NeuraNet* const that) {
+// no influence on outputs) and return the statistics of the pruning
+// The links are sorted on their input, so all the links using a 
+// hidden value come after the links producing it, and a single 
+// backward sweep on the links finds the useful ones
+NNPruneStats NNPrune(const NeuraNet* const that) {
 #if BUILDMODE == 0
   if (that == NULL) {
     NeuraNetErr->_type = PBErrTypeNullPointer;
@@ -1010,29 +6717,89 @@ void NNPrune(const NeuraNet* const that) {
     PBErrCatch(NeuraNetErr);
   }
 #endif
-  // Declare a variable to memorise the start index of output
-  long startOut = NNGetNbInput(that) + NNGetNbMaxHidden(that);
-  // Loop on links
-  for (int iLink = NNGetNbMaxLinks(that); iLink--;) {
-    // If the output of this link is not an output and it's active
-    if (VecGet(NNLinks(that), iLink * NN_NBPARAMLINK) != -1 &&
-      VecGet(NNLinks(that), iLink * NN_NBPARAMLINK + 2) < startOut) {
-      // Search in following links one that use the output of this link
-      // as an input
-      bool flag = false;
-      for (int jLink = iLink + 1; 
-        !flag && jLink < NNGetNbMaxLinks(that); ++jLink) {
-        if (VecGet(NNLinks(that), iLink * NN_NBPARAMLINK + 2) ==
-          VecGet(NNLinks(that), jLink * NN_NBPARAMLINK + 1)) {
-          flag = true;
-        }
-      }
-      // If the output of this link is never used
-      if (!flag)
-        // Disactivate it
-        VecSet(that->_links, iLink * NN_NBPARAMLINK, -1);
+  // Declare a variable to memorize the statistics
+  NNPruneStats stats = {._nbLinkRemoved = 0, ._nbHiddenFreed = 0};
+  // Expand the links if they are implicit, or unbind them if they are
+  // bound
+  NNExpandLinks(that);
+  NNUnbindLinks(that);
+  // Declare variables for optimization
+  long nbMaxLinks = NNGetNbMaxLinks(that);
+  long startHid = NNGetNbInput(that);
+  long startOut = startHid + NNGetNbMaxHidden(that);
+  long endOut = startOut + NNGetNbOutput(that);
+  long* links = that->_links->_val;
+  // Declare a variable to memorize per hidden value flags for its 
+  // influence on outputs, its use before pruning and its use after 
+  // pruning
+  const long flagLive = 1;
+  const long flagUsedBefore = 2;
+  const long flagUsedAfter = 4;
+  long* flags = PBErrMalloc(NeuraNetErr, 
+    sizeof(long) * (NNGetNbMaxHidden(that) + 1));
+  memset(flags, 0, sizeof(long) * NNGetNbMaxHidden(that));
+  // Loop backward on the links
+  for (long iLink = nbMaxLinks; iLink--;) {
+    long* link = links + iLink * NN_NBPARAMLINK;
+    // Skip the inactive links
+    if (link[0] == -1)
+      continue;
+    long in = link[1];
+    long out = link[2];
+    bool isHidIn = (in >= startHid && in < startOut);
+    bool isHidOut = (out >= startHid && out < startOut);
+    // Memorize the use of its hidden values
+    if (isHidIn)
+      flags[in - startHid] |= flagUsedBefore;
+    if (isHidOut)
+      flags[out - startHid] |= flagUsedBefore;
+    // If the link is in the execution plan and its output is an 
+    // output value or a hidden value having influence on outputs
+    if (in >= 0 && in < startOut && out < endOut && 
+      (out >= startOut || (isHidOut && (flags[out - startHid] & flagLive)))) {
+      // Its input, if hidden, has influence on outputs
+      if (isHidIn)
+        flags[in - startHid] |= flagLive | flagUsedAfter;
+      if (isHidOut)
+        flags[out - startHid] |= flagUsedAfter;
+    // Else, the link is useless
+    } else {
+      // Disactivate it
+      link[0] = -1;
+      ++(stats._nbLinkRemoved);
     }
   }
+  // Count the hidden values not used anymore
+  for (long iHid = NNGetNbMaxHidden(that); iHid--;)
+    if ((flags[iHid] & flagUsedBefore) && !(flags[iHid] & flagUsedAfter))
+      ++(stats._nbHiddenFreed);
+  free(flags);
+  // If links have been removed
+  if (stats._nbLinkRemoved > 0) {
+    // Move the active links before the inactive ones, keeping their 
+    // order
+    long jLink = 0;
+    for (long iLink = 0; iLink < nbMaxLinks; ++iLink)
+      if (links[iLink * NN_NBPARAMLINK] != -1) {
+        if (iLink != jLink)
+          for (int iParam = NN_NBPARAMLINK; iParam--;) {
+            long v = links[jLink * NN_NBPARAMLINK + iParam];
+            links[jLink * NN_NBPARAMLINK + iParam] = 
+              links[iLink * NN_NBPARAMLINK + iParam];
+            links[iLink * NN_NBPARAMLINK + iParam] = v;
+          }
+        ++jLink;
+      }
+    // The links don't match anymore the geometry of the convolution 
+    // layers or the dense layers, discard them
+    NNConvGeometryFree((NNConvGeometry**)&(that->_conv));
+    VecFree((VecLong**)&(that->_layers));
+  }
+  // Reset the origin of the links and update the execution plan
+  NNResetLinksOrigin(that);
+  NNUpdatePlan(that);
+  // Return the statistics
+  return stats;
 }
 
 // Helper functions to propagate recursively the accuracy in the nework
@@ -1101,6 +6868,13 @@ VecFloat* NNGetMutabilityBases(const NeuraNet* const that,
     PBErrCatch(NeuraNetErr);
   }
 #endif
+  // If the links are implicit, use a clone with expanded links
+  NeuraNet* expanded = NNCloneWithExpandedLinks(that);
+  if (expanded != NULL) {
+    VecFloat* ret = NNGetMutabilityBases(expanded, accuracy);
+    NeuraNetFree(&expanded);
+    return ret;
+  }
   // Create the mutability vector
   VecFloat* ret = VecFloatCreate(NNGetNbMaxBases(that) * NN_NBPARAMBASE);
   // Loop on output
@@ -1143,6 +6917,13 @@ VecFloat* NNGetMutabilityLinks(const NeuraNet* const that,
     PBErrCatch(NeuraNetErr);
   }
 #endif
+  // If the links are implicit, use a clone with expanded links
+  NeuraNet* expanded = NNCloneWithExpandedLinks(that);
+  if (expanded != NULL) {
+    VecFloat* ret = NNGetMutabilityLinks(expanded, accuracy);
+    NeuraNetFree(&expanded);
+    return ret;
+  }
   // Create the mutability vector
   VecFloat* ret = VecFloatCreate(NNGetNbMaxLinks(that) * NN_NBPARAMLINK);
   // Loop on output
@@ -1162,6 +6943,8 @@ VecFloat* NNGetMutabilityLinks(const NeuraNet* const that,
 
 // Set the bounds of the GenAlg 'ga' to be used for bases parameters of 
 // the NeuraNet 'that'
+// The parameters of the bases of the pooling stages of a convolution 
+// NeuraNet are fixed (see NeuraNetCreateConvolutionWithPooling)
 void NNSetGABoundsBases(const NeuraNet* const that, GenAlg* const ga) {
 #if BUILDMODE == 0
   if (that == NULL) {
@@ -1190,6 +6973,24 @@ void NNSetGABoundsBases(const NeuraNet* const that, GenAlg* const ga) {
   for (long iGene = NNGetGAAdnFloatLength(that); iGene--;)
     // Set the bounds
     GASetBoundsAdnFloat(ga, iGene, &bounds);
+  // If the NeuraNet has pooling stages
+  if (that->_conv != NULL && 
+    NNConvGeometryGetNbBasesPool(that->_conv) > 0) {
+    // Get the parameters of the bases of the pooling stages
+    VecFloat* bases = VecClone(NNBases(that));
+    long iStartBase = NNConvSetBasesPool(that, bases);
+    long iEndBase = 
+      iStartBase + NNConvGeometryGetNbBasesPool(that->_conv);
+    // Fix the genes of these bases to their parameters
+    for (long iGene = iStartBase * NN_NBPARAMBASE; 
+      iGene < iEndBase * NN_NBPARAMBASE; ++iGene) {
+      VecSet(&bounds, 0, VecGet(bases, iGene)); 
+      VecSet(&bounds, 1, VecGet(bases, iGene));
+      GASetBoundsAdnFloat(ga, iGene, &bounds);
+    }
+    // Free memory
+    VecFree(&bases);
+  }
 }
 
 // Set the bounds of the GenAlg 'ga' to be used for links description of 
@@ -10,6 +10,8 @@
 #include <math.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "pberr.h"
 #include "pbcextension.h"
 #include "pbmath.h"
@@ -34,15 +36,130 @@ static inline
 #endif
 float NNBaseFun(const float* const param, const float x);
 
+// Calculate the linear form of the base function of parameters 
+// 'param', such as NNBaseFun(param,x)=slope*x+offset, and memorize it
+// in 'slope' and 'offset'
+// slope=tan(param[0]*NN_THETA), offset=slope*param[1]+param[2]
+#if BUILDMODE != 0
+static inline
+#endif
+void NNBaseFunCoeff(const float* const param, float* const slope, 
+  float* const offset);
+
 // ----- NeuraNet
 
 // ================= Define ==================
 
 #define NN_NBPARAMBASE 3
 #define NN_NBPARAMLINK 3
+#define NN_NBCOEFFBASE 2
+// Size in bytes of a cache line, the arrays of a NeuraNet are aligned 
+// on it
+#define NN_CACHELINE 64
 
 // ================= Data structure ===================
 
+// Kind of the values referenced by the execution plan
+typedef enum NNValKind {
+  NNValInput, NNValHidden, NNValOutput
+} NNValKind;
+#define NN_NBVALKIND 3
+
+// Layout of the samples in the buffers of NNEvalBatch
+typedef enum NNBatchLayout {
+  // The values of one sample are contiguous
+  NNBatchRowMajor,
+  // The values of one input (or output) for all samples are contiguous
+  NNBatchColMajor
+} NNBatchLayout;
+// Nb of samples evaluated together by NNEvalBatch
+#define NN_BATCHTILE 64
+// Nb of candidates evaluated together by NNPopulationEval, a multiple
+// of 16 (the width of the AVX-512 kernels)
+#define NN_POPTILE 16
+// Nb of destination values of a layer evaluated together by 
+// NNEvalBatch on a NeuraNet made of dense layers
+#define NN_DENSEBLOCK 32
+
+// Kernels used by NNEvalBatch for the loops on samples
+typedef enum NNEvalKernel {
+  NNEvalKernelScalar, NNEvalKernelSSE, NNEvalKernelAVX2, 
+  NNEvalKernelAVX512
+} NNEvalKernel;
+#define NN_NBEVALKERNEL 4
+
+// Order of the groups of links evaluated by NNEval
+typedef enum NNLinkOrder {
+  // Groups in the order of the links, sorted on input then output
+  NNLinkOrderInputMajor,
+  // Groups sorted on output then input, the contributions to one 
+  // value are contiguous and accumulated before being stored
+  NNLinkOrderOutputMajor
+} NNLinkOrder;
+
+// Minimum nb of destination values evaluated per thread in one 
+// dependency level by NNEvalParallel
+#define NN_PARALLELMINDST 16
+
+// Nb of updates of an output value by NNEvalDelta after which it is 
+// re-evaluated from all its groups of links
+#define NN_DELTAREFRESH 256
+
+// Max nb of links moved by NNUpdateLinks one by one while patching 
+// the execution plan in place, above which they are moved all at once
+// and the execution plan is rebuilt
+#define NN_MAXMOVEDLINKS 16
+
+// Nb of fractional bits of the fixed-point values of a NNQuantized
+// The input and hidden values in [-1,1] fit in int16, the link values
+// and output values are saturated to the int32 range
+#define NN_QSHIFT 14
+#define NN_QONE (1L << NN_QSHIFT)
+#define NN_QMAXACC 2147483647L
+// Bounds of the per-base shift of the coefficients of a NNQuantized
+#define NN_QMINSHIFTBASE -16
+#define NN_QMAXSHIFTBASE 30
+
+// Kind of the pooling stage following a convolution level
+typedef enum NNPoolKind {
+  // No pooling
+  NNPoolNone,
+  // Average of the values in the pooling window
+  NNPoolAvg,
+  // Maximum of the values in the pooling window
+  NNPoolMax
+} NNPoolKind;
+#define NN_NBPOOLKIND 3
+// Nb of base functions used by a pooling stage per kind of pooling
+#define NN_NBBASEPOOLAVG 1
+#define NN_NBBASEPOOLMAX 5
+
+// Geometry of the convolution layers of a NeuraNet created with 
+// NeuraNetCreateConvolution, used to evaluate them with a sliding 
+// window kernel instead of the links
+typedef struct NNConvGeometry {
+  // Dimension of the input values
+  VecShort* _dimIn;
+  // Dimension of the convolution cells
+  VecShort* _dimCell;
+  // Nb of convolution levels
+  int _depthConv;
+  // Nb of convolutions in parallel per level
+  int _thickConv;
+  // Stride of the convolution cells along each dimension, per level
+  // Null if there is no convolution level
+  VecShort* _stride;
+  // Kind of pooling (NNPoolKind) following each level
+  // Null if there is no convolution level
+  VecShort* _poolKind;
+  // Size of the pooling window along each dimension, per level
+  // Null if there is no convolution level
+  VecShort* _poolSize;
+} NNConvGeometry;
+
+// The NeuraNet and its arrays are allocated in one block of memory, 
+// the arrays being aligned on cache lines, in the order of the 
+// structure below
 typedef struct NeuraNet {
   // Nb of input values
   const int _nbInputVal;
@@ -57,18 +174,334 @@ typedef struct NeuraNet {
   // VecFloat describing the base functions
   // NN_NBPARAMBASE values per base function
   VecFloat* _bases;
+  // VecFloat caching the linear form of the base functions, refreshed 
+  // each time the bases are modified
+  // NN_NBCOEFFBASE values per base function (slope, offset) such as
+  // NNBaseFun(param,x)=slope*x+offset
+  VecFloat* _basesCoeff;
   // VecShort describing the links
   // NN_NBPARAMLINK values per link (base id, input id, output id)
   // if (base id equals -1 the link is inactive)
+  // Null, as well as the execution plan below, while the links are 
+  // implicitly described by the geometry of the convolution layers 
+  // (see NNExpandLinks)
+  // Either owned by the NeuraNet or bound with NNBindLinks
   VecLong* _links;
+  // VecLong owned by the NeuraNet and set aside while the links are 
+  // bound with NNBindLinks, null else
+  VecLong* _ownLinks;
+  // Memory holding the links and the execution plan, at the end of 
+  // the memory of the NeuraNet, or allocated apart if the links were 
+  // implicit at the creation of the NeuraNet
+  // Null while the links are not allocated
+  void* _linksArena;
   // Hidden values
   VecFloat* _hidVal;
   // Nb bases used for convolution
   const long _nbBasesConv;
   // Nb bases per cell used for convolution
   const long _nbBasesCellConv;
+  // VecLong of the index of the first group of each destination value
+  // (hidden values followed by output values) in _dstPlan, built with
+  // the plan
+  // The groups of the 'iDst'-th destination are the groups 
+  // _dstGroupStart[iDst] to _dstGroupStart[iDst+1]-1 of _dstPlan, in 
+  // increasing order of their input
+  // Outdated while the levels are outdated (see below)
+  VecLong* _dstGroupStart;
+  // Memory holding the execution plan per destination below, 
+  // allocated apart on request (see NNSetPlanPerDst)
+  // Null, as well as the arrays below, if it has not been requested
+  void* _dstArena;
+  // Execution plan reordered per destination value, built with the 
+  // plan, in the same format as _packedPlan
+  void* _dstPlan;
+  // Base function index of the links in the order of _dstPlan, as 
+  // unsigned integers of _packedWidth bytes
+  void* _dstBase;
+  // Index in _dstBase of the first link of each group of _dstPlan, as 
+  // unsigned integers of _packedWidth bytes
+  void* _dstLinkStart;
+  // Index in _dstPlan of each group of _packedPlan, as unsigned 
+  // integers of _packedWidth bytes
+  void* _dstPos;
+  // VecLong of the index of the first group of _packedPlan having for 
+  // input the 'iVal'-th value (input values followed by hidden values)
+  // The groups of the 'iVal'-th value are the groups 
+  // _srcGroupStart[iVal] to _srcGroupStart[iVal+1]-1 of _packedPlan, 
+  // only if the levels are available (see below)
+  VecLong* _srcGroupStart;
+  // VecLong describing the dependency levels of the destination 
+  // values, built with the plan
+  // The destination values of the 'iLevel'-th level are 
+  // _levelDst[_levelStart[iLevel]..._levelStart[iLevel+1]-1]
+  // The destination values of a level depend only on the values of 
+  // the previous levels (and on themselves), hence can be evaluated 
+  // in parallel
+  // if (_levelStart[iLevel+1] equals -1 there is no more level)
+  // if (_levelStart[0] equals -1 the levels are unavailable because 
+  // the links are not sorted)
+  // if (_levelStart[0] equals -2 the levels are outdated by 
+  // NNUpdateLinks and rebuilt when needed, only while the plan per 
+  // destination has not been requested)
+  VecLong* _levelStart;
+  VecLong* _levelDst;
+  // VecLong of the level of each destination value, 0 if it has no 
+  // group, valid with the levels
+  VecLong* _dstLevel;
+  // VecLong of the index of each active link of _links in the links 
+  // given to NNSetLinks and NNUpdateLinks, or its own index if the 
+  // links have been set otherwise
+  VecLong* _linksOrigin;
+  // VecLong of the index in _links of each link given to NNSetLinks 
+  // and NNUpdateLinks, -1 if it's inactive (reverse of _linksOrigin)
+  VecLong* _linksPos;
+  // Scratch memory reused by each update of the links (sort of the 
+  // links, cursors of the destinations, destinations whose level must
+  // be updated), allocated apart on its first use and kept with the 
+  // NeuraNet, null until then
+  // Two indices of link per link followed by one index per value plus
+  // three
+  long* _scratch;
+  // Execution plan of the links, built from the links each time they
+  // are modified
+  // Three unsigned integers of _packedWidth bytes per group of 
+  // consecutive links sharing the same input and output, in the order
+  // of the links (input id, output id, nb of links), the ids being 
+  // those of the links
+  void* _packedPlan;
+  // Base function index of the links of the plan, as unsigned 
+  // integers of _packedWidth bytes, in the order of the plan
+  // Null if the base function index of each link is equal to its index
+  // in the plan
+  void* _packedBases;
+  // Nb of groups in the plan
+  const long _nbPackedGroups;
+  // Nb of links in the plan
+  const long _nbPackedLinks;
+  // Nb of active links at the beginning of _links when the plan was 
+  // built, equal to _nbPackedLinks unless some groups of links refer 
+  // to values out of bounds and are left out of the plan
+  const long _nbActiveLinks;
+  // Size in bytes of the packed integers, 2 if all the ids and base 
+  // function indices fit in 16 bits, 4 else
+  const int _packedWidth;
+  // Order of the groups of links evaluated by NNEval, the plan per 
+  // destination is used for NNLinkOrderOutputMajor
+  // The plan is evaluated in input major order, whatever this order, 
+  // if the levels are unavailable
+  const NNLinkOrder _linkOrder;
+  // Geometry of the convolution layers
+  // Null if the NeuraNet has not been created by 
+  // NeuraNetCreateConvolution or if its links have been modified since
+  // If the links are null they are implicitly described by this 
+  // geometry
+  NNConvGeometry* _conv;
+  // VecLong of the nb of values of the layers of a NeuraNet created 
+  // with NeuraNetCreateFullyConnected (input layer, hidden layers and
+  // output layer), used to evaluate it as dense layers instead of the
+  // links
+  // Null if the NeuraNet has not been created by 
+  // NeuraNetCreateFullyConnected or if its links don't match anymore
+  // its layers
+  VecLong* _layers;
 } NeuraNet;
 
+// Scratch memory used to evaluate a NeuraNet without modifying it, 
+// one context per thread allows to evaluate the same NeuraNet 
+// concurrently
+typedef struct NNEvalContext {
+  // Hidden values
+  VecFloat* _hidVal;
+  // Values of a tile of samples for NNEvalBatchCtx
+  VecFloat* _tile;
+} NNEvalContext;
+
+typedef struct NNThreadTeam NNThreadTeam;
+
+// Worker thread of a NNThreadTeam
+typedef struct NNThreadTeamWorker {
+  // Team of the worker
+  NNThreadTeam* _team;
+  // Index of the worker in the team
+  int _iThread;
+  // Thread of the worker
+  pthread_t _thread;
+} NNThreadTeamWorker;
+
+// Team of threads used by NNEvalParallel to evaluate the dependency 
+// levels of a NeuraNet in parallel
+// The calling thread is the first member of the team, the other 
+// members are worker threads waiting for evaluations
+struct NNThreadTeam {
+  // Nb of threads in the team, including the calling thread
+  int _nbThread;
+  // Worker threads (_nbThread - 1)
+  NNThreadTeamWorker* _workers;
+  // Barrier synchronizing the team between dependency levels
+  pthread_barrier_t _barrier;
+  // NeuraNet currently evaluated
+  const NeuraNet* _nn;
+  // Values (input, hidden, output) currently evaluated
+  float* _val[NN_NBVALKIND];
+  // Flag to stop the worker threads
+  bool _quit;
+};
+
+// State of the evaluation of a NeuraNet, memorizing a reference 
+// evaluation and its intermediate results to re-evaluate only what's 
+// affected by the inputs differing from the reference with 
+// NNEvalSparse and NNEvalDelta
+typedef struct NNEvalState {
+  // Input values
+  VecFloat* _input;
+  // Hidden values
+  VecFloat* _hidVal;
+  // Output values
+  VecFloat* _output;
+  // Output values of the reference evaluation
+  VecFloat* _refOutput;
+  // Product of the links of each group of the plan per destination in
+  // the reference evaluation
+  VecFloat* _prod;
+  // Value of the destination after adding each group of the plan per 
+  // destination in the reference evaluation
+  VecFloat* _acc;
+  // Index in the plan per destination of the first group to 
+  // re-evaluate per hidden value, -1 if the hidden value is up to date
+  VecLong* _dirtyFrom;
+  // Binary heap of the hidden values to re-evaluate, in increasing 
+  // order of their index
+  VecLong* _heap;
+  // Nb of hidden values in the heap
+  long _nbHeap;
+  // Hidden values re-evaluated by the last evaluation
+  VecLong* _touched;
+  // Nb of hidden values re-evaluated by the last evaluation
+  long _nbTouched;
+  // Inputs differing from the reference evaluation
+  VecLong* _nonZero;
+  // Nb of inputs differing from the reference evaluation, -1 if the 
+  // reference evaluation is not the one for all input values equal 
+  // to 0.0
+  long _nbNonZero;
+  // Nb of updates of each output value since it has been evaluated 
+  // from all its groups
+  VecLong* _nbOutputUpdate;
+} NNEvalState;
+
+// Fixed-point copy of a NeuraNet for inference with integer arithmetic
+// The input and hidden values are in the int16 range with NN_QSHIFT 
+// fractional bits. The slope and offset of each base function are int16 sharing 
+// a per-base shift, such as slope=_basesCoeff[2*iBase]*2^-shift and 
+// offset=_basesCoeff[2*iBase+1]*2^-shift, with 
+// shift=_basesShift[iBase]
+// The link values, products of groups of links and output values are 
+// calculated in fixed-point with NN_QSHIFT fractional bits, saturated 
+// to the int32 range
+typedef struct NNQuantized {
+  // Nb of input values
+  int _nbInputVal;
+  // Nb of output values
+  int _nbOutputVal;
+  // Nb max of hidden values
+  long _nbMaxHidVal;
+  // Quantized slope and offset of the base functions
+  VecShort* _basesCoeff;
+  // Shift of the quantized coefficients of the base functions
+  VecShort* _basesShift;
+  // Copy of the execution plan of the NeuraNet (see NeuraNet)
+  void* _packedPlan;
+  // Copy of the base function index of the links of the execution 
+  // plan of the NeuraNet, null if they are implicit
+  void* _packedBases;
+  // Nb of groups in the packed plan
+  long _nbPackedGroups;
+  // Size in bytes of the packed integers, 2 or 4
+  int _packedWidth;
+} NNQuantized;
+
+// Scratch memory used to evaluate a NNQuantized without modifying it,
+// one context per thread allows to evaluate the same NNQuantized 
+// concurrently
+typedef struct NNQuantizedContext {
+  // Input values followed by hidden values and output values, in 
+  // fixed-point with NN_QSHIFT fractional bits
+  VecLong* _val;
+} NNQuantizedContext;
+
+// Population of candidate NeuraNets sharing the links of a NeuraNet 
+// and each having its own base functions, evaluated together by 
+// NNPopulationEval
+typedef struct NNPopulation {
+  // Clone of the NeuraNet whose links are shared by the candidates
+  NeuraNet* _nn;
+  // Nb of candidates
+  const long _nbCandidate;
+  // VecFloat of the linear form of the base functions of the 
+  // candidates, organised per tile of NN_POPTILE candidates, then per 
+  // base function and coefficient (slope, offset), then per candidate
+  // of the tile
+  // The candidates completing the last tile have null base functions
+  VecFloat* _basesCoeff;
+} NNPopulation;
+
+// Statistics of NNPrune
+typedef struct NNPruneStats {
+  // Nb of links removed
+  long _nbLinkRemoved;
+  // Nb of hidden values used by the links before pruning and not used 
+  // anymore after pruning
+  long _nbHiddenFreed;
+} NNPruneStats;
+
+// Entry of a NNPlanCache
+typedef struct NNPlanCacheEntry {
+  // Hash of the links of the entry
+  uint64_t _hash;
+  // Copy of the links given to NNSetLinksCached, null if the entry is
+  // unused
+  VecLong* _links;
+  // Copy of the memory of the links and execution plan built by 
+  // NNSetLinks from the links of the entry
+  void* _linksArena;
+  // Nb of groups and links of the execution plan in _linksArena, and
+  // nb of active links when it was built
+  long _nbPackedGroups;
+  long _nbPackedLinks;
+  long _nbActiveLinks;
+  // Flag to memorize if the execution plan has base function indices
+  bool _hasPackedBases;
+  // Value of the use counter of the NNPlanCache at the last use of 
+  // the entry
+  unsigned long _lastUse;
+} NNPlanCacheEntry;
+
+// Cache of the links and execution plans built by NNSetLinks, for 
+// NeuraNets of the same dimensions, reused by NNSetLinksCached when 
+// the same links are set again
+// The least recently used entry is replaced when the cache is full
+typedef struct NNPlanCache {
+  // Dimensions of the NeuraNets using the cache
+  const int _nbInputVal;
+  const int _nbOutputVal;
+  const long _nbMaxHidVal;
+  const long _nbMaxBases;
+  const long _nbMaxLinks;
+  // Size in bytes of the links and execution plan of one entry
+  const size_t _sizeLinks;
+  // Nb of entries
+  const long _nbEntry;
+  // Entries
+  NNPlanCacheEntry* _entries;
+  // Use counter, incremented at each call to NNSetLinksCached
+  unsigned long _nbUse;
+  // Nb of calls to NNSetLinksCached which found their links in the 
+  // cache (hit) or not (miss)
+  unsigned long _nbHit;
+  unsigned long _nbMiss;
+} NNPlanCache;
+
 // ================ Functions declaration ====================
 
 // Create a new NeuraNet with 'nbInput' input values, 'nbOutput' 
@@ -80,6 +513,19 @@ NeuraNet* NeuraNetCreate(const int nbInput, const int nbOutput,
 // Free the memory used by the NeuraNet 'that'
 void NeuraNetFree(NeuraNet** that);
 
+// Return a clone of the NeuraNet 'that'
+// The clone doesn't share any memory with 'that', the links bound to 
+// 'that', if any, are copied in the clone
+NeuraNet* NNClone(const NeuraNet* const that);
+
+// Copy the NeuraNet 'src' into the NeuraNet 'that', reusing the 
+// memory of 'that'
+// 'that' and 'src' must have the same nb of input, output, hidden 
+// values, base functions and links
+// The links bound to 'src', if any, are copied in 'that', those bound
+// to 'that' are unbound without being copied
+void NNCloneInto(NeuraNet* const that, const NeuraNet* const src);
+
 // Create a new NeuraNet with 'nbInput' input values, 'nbOutput' 
 // output values and a set of hidden layers described by 
 // 'hiddenLayers' as follow:
@@ -93,6 +539,9 @@ void NeuraNetFree(NeuraNet** that);
 // toward each hidden values in the first hidden layer, then from each 
 // hidden values of the first hidden layer to each hidden value of the 
 // 2nd hidden layer and so on until each values of the output
+// The NeuraNet keeps its layers and is evaluated by NNEval, NNEvalCtx
+// and NNEvalBatch as dense layers, with the same results as with its 
+// links, as long as its links are left unchanged
 NeuraNet* NeuraNetCreateFullyConnected(const int nbIn, const int nbOut, 
   const VecLong* const hiddenLayers);
 
@@ -139,7 +588,62 @@ NeuraNet* NeuraNetCreateFullyConnected(const int nbIn, const int nbOut,
 NeuraNet* NeuraNetCreateConvolution(const VecShort* const dimIn, 
   const int nbOutput, const VecShort* const dimCell, 
   const int depthConv, const int thickConv);
+
+// Create a NeuraNet using convolution as NeuraNetCreateConvolution, 
+// with a stride and a pooling stage per convolution level
+// The convolution cells of the 'iConv'-th level move by 
+// 'stride'[iConv] positions along each dimension, hence the output 
+// layer of the level has (dimIn-dimCell)/stride+1 values along each 
+// dimension
+// If 'poolKind'[iConv] is not NNPoolNone the output layer of the 
+// 'iConv'-th level is reduced by non overlapping windows of 
+// 'poolSize'[iConv] values along each dimension, into their average 
+// (NNPoolAvg) or maximum (NNPoolMax), and the reduced layer is the 
+// input of the next level
+// 'stride', 'poolKind' and 'poolSize' are of dimension 'depthConv', 
+// any of them can be null to use the default (stride 1, no pooling)
+// The pooling stages are made of links using base functions with 
+// fixed parameters, located between the bases of the convolutions and 
+// the ones of the fully connected layer and set by this function. 
+// These bases must be left unchanged, NNSetGABoundsBases sets bounds 
+// which keep them fixed
+// A maximum pooling is calculated with pairs of hidden values per 
+// value in the window (max(a,b)=a+(min(1,max(-1,b-a-1))+1)), exactly 
+// up to the float rounding of the base functions
+NeuraNet* NeuraNetCreateConvolutionWithPooling(
+  const VecShort* const dimIn, const int nbOutput, 
+  const VecShort* const dimCell, const int depthConv, 
+  const int thickConv, const VecShort* const stride, 
+  const VecShort* const poolKind, const VecShort* const poolSize);
   
+// Create a new NNConvGeometry for convolution layers on input values 
+// of dimension 'dimIn', with cells of dimension 'dimCell', 'depthConv'
+// levels and 'thickConv' convolutions in parallel per level
+// 'stride', 'poolKind' and 'poolSize' are the stride and pooling per 
+// level (see NeuraNetCreateConvolutionWithPooling), null for the 
+// default
+NNConvGeometry* NNConvGeometryCreate(const VecShort* const dimIn, 
+  const VecShort* const dimCell, const int depthConv, 
+  const int thickConv, const VecShort* const stride, 
+  const VecShort* const poolKind, const VecShort* const poolSize);
+
+// Free the memory used by the NNConvGeometry 'that'
+void NNConvGeometryFree(NNConvGeometry** that);
+
+// Return true if the NNConvGeometry 'that' is valid, i.e. along each 
+// dimension the input of each level is at least as large as the cell 
+// and the output of its pooling stage is not empty, else false
+// NeuraNetCreateConvolutionWithPooling requires a valid geometry
+bool NNConvGeometryIsValid(const NNConvGeometry* const that);
+
+// Get the geometry of the convolution layers of the NeuraNet 'that'
+// Return null if the NeuraNet is not evaluated as a convolution 
+// network (see NeuraNet::_conv)
+#if BUILDMODE != 0
+static inline
+#endif
+const NNConvGeometry* NNConv(const NeuraNet* const that);
+
 // Get the nb of input values of the NeuraNet 'that'
 #if BUILDMODE != 0
 static inline
@@ -190,6 +694,7 @@ static inline
 const VecFloat* NNBases(const NeuraNet* const that);
 
 // Get the links description of the NeuraNet 'that'
+// If the links are implicit they are expanded first
 #if BUILDMODE != 0
 static inline
 #endif
@@ -224,16 +729,205 @@ static inline
 #endif
 void NNBasesSet(NeuraNet* const that, const long iBase, const float base);
 
+// Update the cached slope and offset of the 'iBase'-th base function 
+// of the NeuraNet 'that' according to its parameters
+// slope=tan(param[0]*NN_THETA), offset=slope*param[1]+param[2]
+#if BUILDMODE != 0
+static inline
+#endif
+void NNUpdateBaseCoeff(const NeuraNet* const that, const long iBase);
+
 // Set the links description of the NeuraNet 'that' to a copy of 'links'
 // Links with a base function equals to -1 are ignored
+// The geometry of the convolution layers, if any, is discarded
+// The dense layers, if any, are discarded unless the links still match
+// them
 // If the input id is higher than the output id they are swap
 // The links description in the NeuraNet are ordered in increasing 
 // value of input id and output id, but 'links' doesn't have to be 
 // sorted
+// Links with the same input id and output id keep their relative 
+// order
 // Each link is defined by (base index, input index, output index)
 // If base index equals -1 it means the link is inactive
 void NNSetLinks(NeuraNet* const that, VecLong* const links);
 
+// Update the links of the NeuraNet 'that' as if the links last given
+// to NNSetLinks had been modified by replacing their 'indices'-th 
+// links with the links in 'links' and given again to NNSetLinks
+// 'links' contains NN_NBPARAMLINK values per index in 'indices', 
+// the indices must be different
+// If the links of 'that' have not been set with NNSetLinks, their 
+// indices are those in NNLinks(that)
+// If only the base function of the modified links is modified, they 
+// are patched in place in the execution plan in time proportional to
+// the nb of links sharing their input, unless the base function 
+// indices of the plan can't stay implicit or some links out of bounds
+// are left out of the plan, which costs O(L) for L active links
+// Else, if at most NN_MAXMOVEDLINKS links are moved, all in bounds, 
+// they are moved one by one: the links between their old and new 
+// position are shifted, the groups of the plan and of the plan per 
+// destination are patched in place, which shifts the groups and
+// indices following the modified ones, and only the levels of the 
+// destinations whose groups are created or removed, and of the 
+// destinations depending on them, are updated
+// Without plan per destination, the levels are only flagged as 
+// outdated and rebuilt when needed (see NNGetNbLevel)
+// Else, the k modified links are moved to their new position in 
+// O(L+k.log(k)) and the execution plan and dependency levels are 
+// rebuilt in O(L), only the sort of all the links by NNSetLinks is 
+// saved
+// The geometry of the convolution layers, if any, is discarded
+// The dense layers, if any, are discarded unless the links still match
+// them
+void NNUpdateLinks(NeuraNet* const that, const VecLong* const indices,
+  const VecLong* const links);
+
+// Bind the links description of the NeuraNet 'that' to 'links', 
+// without copying nor sorting them
+// 'links' must be in the order of NNLinks(that) after NNSetLinks: 
+// active links first, in increasing value of input id and output id,
+// the input id not higher than the output id, then inactive links
+// 'links' is used by the NeuraNet until it is bound again, unbound or 
+// freed, it must not be freed meanwhile and must be bound again 
+// after being modified
+// The NeuraNet never modifies 'links', NNUpdateLinks and NNPrune 
+// unbind it first, NNSetLinks and NNSetLinksCached replace it without
+// copying it back
+// The indices of the links for NNUpdateLinks are those in 'links'
+// The geometry of the convolution layers, if any, is discarded
+// The dense layers, if any, are discarded unless the links still match
+// them
+void NNBindLinks(NeuraNet* const that, const VecLong* const links);
+
+// Unbind the links description of the NeuraNet 'that' by copying it 
+// in the memory of the NeuraNet
+// Do nothing if it is not bound
+void NNUnbindLinks(const NeuraNet* const that);
+
+// Create a new NNPlanCache of 'nbEntry' entries for NeuraNets of the 
+// same dimensions as the NeuraNet 'that'
+NNPlanCache* NNPlanCacheCreate(const NeuraNet* const that, 
+  const long nbEntry);
+
+// Free the memory used by the NNPlanCache 'that'
+void NNPlanCacheFree(NNPlanCache** that);
+
+// Empty the NNPlanCache 'that' and reset its counters
+void NNPlanCacheFlush(NNPlanCache* const that);
+
+// Get the nb of calls to NNSetLinksCached with the NNPlanCache 'that'
+// which found their links in it
+#if BUILDMODE != 0
+static inline
+#endif
+unsigned long NNPlanCacheGetNbHit(const NNPlanCache* const that);
+
+// Get the nb of calls to NNSetLinksCached with the NNPlanCache 'that'
+// which didn't find their links in it
+#if BUILDMODE != 0
+static inline
+#endif
+unsigned long NNPlanCacheGetNbMiss(const NNPlanCache* const that);
+
+// Get the ratio of calls to NNSetLinksCached with the NNPlanCache 
+// 'that' which found their links in it, 0.0 if it hasn't been used
+#if BUILDMODE != 0
+static inline
+#endif
+float NNPlanCacheGetHitRate(const NNPlanCache* const that);
+
+// Set the links description of the NeuraNet 'that' to a copy of 
+// 'links' as NNSetLinks, using the NNPlanCache 'cache'
+// If the same links have already been set with 'cache' and are still
+// in it, the links and execution plan are copied from it instead of 
+// being sorted and built again, else they are built by NNSetLinks and
+// added to 'cache'
+// Links are the same if their active links are equal at the same 
+// indices, the ids of inactive links are ignored
+// 'that' must have the same dimensions as the NeuraNet 'cache' has 
+// been created with
+// The NNPlanCache must not be used concurrently by several threads
+void NNSetLinksCached(NeuraNet* const that, VecLong* const links, 
+  NNPlanCache* const cache);
+
+// Expand the links implicitly described by the geometry of the 
+// convolution layers of the NeuraNet 'that' into its links 
+// description and execution plan
+// Do nothing if the links are already expanded
+// The evaluation functions (NNEval, NNEvalCtx, NNEvalBatch, 
+// NNEvalBatchCtx, NNEvalParallel and the NNEvalState functions) never
+// expand the links, they evaluate the convolution layers directly 
+// and can be used concurrently on the same NeuraNet. NNQuantize, 
+// NNSaveAsC, NNPrintln, NNGetMutabilityBases and NNGetMutabilityLinks
+// use a clone with expanded links and leave the NeuraNet unmodified. 
+// The other functions using the links (NNLinks, NNPrune, ...) expand 
+// them on demand
+// The expansion modifies the NeuraNet, it must not happen concurrently 
+// with another use of the NeuraNet: call NNExpandLinks before sharing 
+// the NeuraNet between threads if the links are needed, for example 
+// to evaluate it in parallel with NNEvalParallel or per difference 
+// with NNEvalSparse and NNEvalDelta
+void NNExpandLinks(const NeuraNet* const that);
+
+// Update the execution plan of the NeuraNet 'that' according to its
+// current links, and the dependency levels and plan per destination
+// built from it
+// Groups of links referring to values out of bounds of the input,
+// hidden or output values are left out of the plan
+void NNUpdatePlan(const NeuraNet* const that);
+
+// Update the index of the groups per destination value, the 
+// dependency levels and, if it has been requested, the execution plan
+// per destination of the NeuraNet 'that' according to its current 
+// execution plan
+// The levels are unavailable if the links are not sorted as done by 
+// NNSetLinks
+void NNUpdateLevels(const NeuraNet* const that);
+
+// Set the order of the groups of links evaluated by NNEval for the 
+// NeuraNet 'that' to 'order'
+// The links themselves are not reordered and the results are the 
+// same whatever the order
+// The NNLinkOrderOutputMajor order evaluates the execution plan per 
+// destination, hence builds it (see NNSetPlanPerDst)
+void NNSetLinkOrder(NeuraNet* const that, const NNLinkOrder order);
+
+// Get the order of the groups of links evaluated by NNEval for the 
+// NeuraNet 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+NNLinkOrder NNGetLinkOrder(const NeuraNet* const that);
+
+// Get the number of dependency levels of the NeuraNet 'that'
+// Return -1 if the levels are unavailable
+// The levels are rebuilt if they have been outdated by NNUpdateLinks,
+// which modifies the NeuraNet, it must not happen concurrently with 
+// another use of the NeuraNet
+long NNGetNbLevel(const NeuraNet* const that);
+
+// Allocate and build the execution plan per destination of the 
+// NeuraNet 'that' if 'flag' is true, else free it
+// The plan per destination is used by NNEvalParallel, NNEvalSparse, 
+// NNEvalDelta and the NNLinkOrderOutputMajor order of links, it costs
+// 12 to 24 bytes per link (for 16 or 32 bits packed integers) in 
+// addition to the 48 to 56 bytes per link of the links and execution 
+// plan, hence it is not built unless requested
+// NNSetLinkOrder requests it for the NNLinkOrderOutputMajor order, 
+// and it is kept while the NeuraNet is in this order
+// It is rebuilt with the execution plan and copied by NNClone and 
+// NNCloneInto
+void NNSetPlanPerDst(NeuraNet* const that, const bool flag);
+
+// Return true if the execution plan per destination of the NeuraNet 
+// 'that' is built and usable (see NNSetPlanPerDst), else false
+// It is unusable while the levels are unavailable
+#if BUILDMODE != 0
+static inline
+#endif
+bool NNHasPlanPerDst(const NeuraNet* const that);
+
 // Calculate the output values for the input values 'input' for the 
 // NeuraNet 'that' and memorize the result in 'output'
 // input values in [-1,1] and output values in [-1,1]
@@ -242,6 +936,246 @@ void NNSetLinks(NeuraNet* const that, VecLong* const links);
 // are ignored
 void NNEval(const NeuraNet* const that, const VecFloat* const input, VecFloat* const output);
 
+// Create a new NNEvalContext to evaluate the NeuraNet 'that' 
+// The context can be used with any NeuraNet having the same number 
+// of input, hidden and output values as 'that'
+NNEvalContext* NNEvalContextCreate(const NeuraNet* const that);
+
+// Free the memory used by the NNEvalContext 'that'
+void NNEvalContextFree(NNEvalContext** that);
+
+// Get the hidden values of the NNEvalContext 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalContextHiddenValues(
+  const NNEvalContext* const that);
+
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output', using the 
+// NNEvalContext 'ctx' to memorize the hidden values
+// Same as NNEval but the NeuraNet is never modified, hence it can be 
+// called concurrently on the same NeuraNet with one context per thread
+void NNEvalCtx(const NeuraNet* const that, NNEvalContext* const ctx,
+  const VecFloat* const input, VecFloat* const output);
+
+// Create a new NNThreadTeam of 'nbThread' threads, including the 
+// calling thread
+NNThreadTeam* NNThreadTeamCreate(const int nbThread);
+
+// Free the memory used by the NNThreadTeam 'that' and stop its threads
+void NNThreadTeamFree(NNThreadTeam** that);
+
+// Get the number of threads of the NNThreadTeam 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int NNThreadTeamGetNbThread(const NNThreadTeam* const that);
+
+// Calculate the output values for the input values 'input' for the 
+// NeuraNet 'that' and memorize the result in 'output', using the 
+// NNEvalContext 'ctx' to memorize the hidden values
+// Same as NNEvalCtx but the dependency levels of the NeuraNet are 
+// evaluated one after the other, the destination values of each 
+// level being distributed among the threads of 'team'
+// A team can be used by only one evaluation at a time
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+// If the levels are unavailable, or if the NeuraNet is a convolution 
+// network whose links have not been expanded (see NNExpandLinks), the
+// evaluation is the one of NNEvalCtx
+void NNEvalParallel(const NeuraNet* const that, 
+  NNEvalContext* const ctx, NNThreadTeam* const team,
+  const VecFloat* const input, VecFloat* const output);
+
+// Create a new NNEvalState for the NeuraNet 'that', initialised with 
+// the evaluation of 'that' for all input values equal to 0.0
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+NNEvalState* NNEvalStateCreate(const NeuraNet* const that);
+
+// Free the memory used by the NNEvalState 'that'
+void NNEvalStateFree(NNEvalState** that);
+
+// Reset the NNEvalState 'that' to the evaluation of the NeuraNet 'nn'
+// for all input values equal to 0.0
+// Must be called each time the bases or links of the NeuraNet have 
+// been modified, including by NNExpandLinks and NNSetPlanPerDst
+// The links of a convolution network are not expanded (see 
+// NNExpandLinks), while they are implicit all the links are 
+// re-evaluated by NNEvalSparse and NNEvalDelta
+void NNEvalStateReset(NNEvalState* const that, const NeuraNet* const nn);
+
+// Get the input values of the NNEvalState 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalStateInput(const NNEvalState* const that);
+
+// Get the hidden values of the NNEvalState 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecFloat* NNEvalStateHiddenValues(const NNEvalState* const that);
+
+// Calculate the output values for the input values of index 'iInputs'
+// equal to 'values' and all other input values equal to 0.0 for the 
+// NeuraNet 'that', and memorize the result in 'output'
+// 'iInputs' and 'values' have same dimension, 'iInputs' has no 
+// duplicate
+// The evaluation starts from the evaluation for all input values 
+// equal to 0.0 memorized in 'state', and only the groups of links 
+// affected by the non null inputs are re-evaluated
+// Hidden values are re-evaluated from their first affected group, 
+// hence are exactly the same as NNEval, output values are updated 
+// with the difference of product of their affected groups, hence are 
+// the same as NNEval up to the rounding errors on float
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+// If the links of the NeuraNet are not sorted as done by NNSetLinks, 
+// all the links are re-evaluated
+void NNEvalSparse(const NeuraNet* const that, NNEvalState* const state,
+  const VecLong* const iInputs, const VecFloat* const values,
+  VecFloat* const output);
+
+// Set the input values of index 'iInputs' of the last evaluation 
+// memorized in the NNEvalState 'state' to 'values' and calculate the 
+// output values of the NeuraNet 'that', memorized in 'output'
+// 'iInputs' and 'values' have same dimension
+// The last evaluation becomes the reference evaluation and only the 
+// groups of links affected by the modified inputs are re-evaluated
+// Hidden values are re-evaluated from their first affected group, 
+// hence are exactly the same as NNEval, output values are updated 
+// with the difference of product of their affected groups, hence are 
+// the same as NNEval up to the rounding errors on float. To avoid the 
+// accumulation of these errors, an output value is re-evaluated from 
+// all its groups once it has been updated NN_DELTAREFRESH times
+// The execution plan per destination of the NeuraNet must have been 
+// requested (see NNSetPlanPerDst)
+// If the links of the NeuraNet are not sorted as done by NNSetLinks, 
+// all the links are re-evaluated
+void NNEvalDelta(const NeuraNet* const that, NNEvalState* const state,
+  const VecLong* const iInputs, const VecFloat* const values,
+  VecFloat* const output);
+
+// Calculate the output values for the 'nbSample' samples of input 
+// values 'inputs' for the NeuraNet 'that' and memorize the result in 
+// 'outputs'
+// 'inputs' is of dimension nbSample * nbInput, 'outputs' of dimension
+// nbSample * nbOutput, both organised according to 'layout'
+// The results are the same as calling NNEval on each sample, but 
+// links are evaluated in the outer loop and samples in the inner loop,
+// by tiles of NN_BATCHTILE samples
+// The dense layers of a NeuraNet created with 
+// NeuraNetCreateFullyConnected are evaluated by blocks of 
+// NN_DENSEBLOCK destination values of a layer
+// A convolution network whose links have not been expanded (see 
+// NNExpandLinks) is evaluated one sample after the other as NNEval 
+// does
+// The hidden values of the NeuraNet are not modified
+void NNEvalBatch(const NeuraNet* const that, const long nbSample,
+  const VecFloat* const inputs, const NNBatchLayout layout, 
+  VecFloat* const outputs);
+
+// Same as NNEvalBatch but use the NNEvalContext 'ctx' as scratch 
+// memory instead of allocating it at each call
+void NNEvalBatchCtx(const NeuraNet* const that, 
+  NNEvalContext* const ctx, const long nbSample,
+  const VecFloat* const inputs, const NNBatchLayout layout, 
+  VecFloat* const outputs);
+
+// Create a new NNPopulation of 'nbCandidate' candidates sharing the 
+// links of the NeuraNet 'that', all initialised with the base 
+// functions of 'that'
+// Later modifications of 'that' have no effect on the NNPopulation
+NNPopulation* NNPopulationCreate(const NeuraNet* const that, 
+  const long nbCandidate);
+
+// Free the memory used by the NNPopulation 'that'
+void NNPopulationFree(NNPopulation** that);
+
+// Set the parameters of the base functions of the 'iCandidate'-th 
+// candidate of the NNPopulation 'that' to 'bases'
+// 'bases' must be of dimension nbMaxBases * NN_NBPARAMBASE of the
+// NeuraNet the NNPopulation has been created from
+void NNPopulationSetBases(NNPopulation* const that, 
+  const long iCandidate, const VecFloat* const bases);
+
+// Calculate the output values of each candidate of the NNPopulation 
+// 'that' for the 'nbSample' samples of input values 'inputs' and 
+// memorize the result in 'outputs'
+// 'inputs' is of dimension nbSample * nbInput, organised according to
+// 'layout'
+// 'outputs' is of dimension nbCandidate * nbSample * nbOutput, the 
+// outputs of the 'iCandidate'-th candidate starting at 
+// iCandidate * nbSample * nbOutput, organised according to 'layout'
+// The results are the same as NNEvalBatch on the NeuraNet with the 
+// base functions of each candidate, but the samples are evaluated by
+// tiles of NN_BATCHTILE samples staying in cache while all the 
+// candidates are evaluated on them, by tiles of NN_POPTILE candidates
+// evaluated together with the kernel selected by NNSetEvalKernel, the 
+// parameters of a link being loaded once per tile of samples
+void NNPopulationEval(const NNPopulation* const that, 
+  const long nbSample, const VecFloat* const inputs, 
+  const NNBatchLayout layout, VecFloat* const outputs);
+
+// Create a new NNQuantized, fixed-point copy of the current bases and
+// links of the NeuraNet 'that'
+// The NNQuantized must be created again to take into account later 
+// modifications of the NeuraNet
+// If the links of 'that' are implicit, a clone with expanded links is
+// quantized, 'that' is not modified
+NNQuantized* NNQuantize(const NeuraNet* const that);
+
+// Free the memory used by the NNQuantized 'that'
+void NNQuantizedFree(NNQuantized** that);
+
+// Create a new NNQuantizedContext to evaluate the NNQuantized 'that'
+// The context can be used with any NNQuantized having the same number 
+// of input, hidden and output values as 'that'
+NNQuantizedContext* NNQuantizedContextCreate(
+  const NNQuantized* const that);
+
+// Free the memory used by the NNQuantizedContext 'that'
+void NNQuantizedContextFree(NNQuantizedContext** that);
+
+// Calculate the output values for the input values 'input' for the 
+// NNQuantized 'that' and memorize the result in 'output', using the 
+// NNQuantizedContext 'ctx' to memorize the values
+// Input values are rounded to the nearest fixed-point value and 
+// clamped to [-1,1]
+// The result approximates NNEval on the quantized NeuraNet, 
+// NNQuantizedGetMaxDeviation gives the error on a dataset
+// The NNQuantized is never modified, hence it can be evaluated 
+// concurrently with one context per thread
+void NNQuantizedEval(const NNQuantized* const that, 
+  NNQuantizedContext* const ctx, const VecFloat* const input, 
+  VecFloat* const output);
+
+// Get the maximum absolute difference between the output values 
+// calculated by the NNQuantized 'that' and the NeuraNet 'nn' it has
+// been created from, for the 'nbSample' samples of input values 
+// 'inputs' (organised as NNBatchRowMajor for NNEvalBatch)
+float NNQuantizedGetMaxDeviation(const NNQuantized* const that, 
+  const NeuraNet* const nn, const long nbSample, 
+  const VecFloat* const inputs);
+
+// Select the kernel 'kernel' for the evaluation of the loops on 
+// samples in NNEvalBatch
+// By default the fastest kernel supported by the CPU is used
+// Return true if the kernel is supported by the CPU and has been 
+// selected, false else
+// The kernel must not be selected while NeuraNets are evaluated by 
+// other threads
+bool NNSetEvalKernel(const NNEvalKernel kernel);
+
+// Get the kernel currently used for the evaluation of the loops on 
+// samples in NNEvalBatch
+NNEvalKernel NNGetEvalKernel(void);
+
+// Return true if the kernel 'kernel' is supported by the CPU, false else
+bool NNIsEvalKernelSupported(const NNEvalKernel kernel);
+
 // Function which return the JSON encoding of 'that' 
 JSONNode* NNEncodeAsJSON(const NeuraNet* const that);
 
@@ -259,6 +1193,16 @@ bool NNSave(const NeuraNet* const that, FILE* const stream, const bool compact);
 // Return true if the NeuraNet could be loaded, false else
 bool NNLoad(NeuraNet** that, FILE* const stream);
 
+// Save the NeuraNet 'that' to the stream 'stream' as C code defining
+// the function nn_eval(const float* input, float* output) which 
+// calculates the output values for the input values as NNEval, and the
+// constants nn_nb_input and nn_nb_output equal to the nb of input and 
+// output values
+// The code is straight-line: the base functions' coefficients are 
+// inlined and the hidden values are local variables
+// Return true if the NeuraNet could be saved, false else
+bool NNSaveAsC(const NeuraNet* const that, FILE* const stream);
+
 // Print the NeuraNet 'that' to the stream 'stream'
 void NNPrintln(const NeuraNet* const that, FILE* const stream);
 
@@ -280,8 +1224,15 @@ bool NNSaveLinkAsCloudGraph(const NeuraNet* const that, const char* url);
 float NNGetHiddenValSimpsonDiv(const NeuraNet* const that);
 
 // Prune the NeuraNet 'that' by removing the useless links (those with 
-// no influence on outputs
-void NNPrune(const NeuraNet* const that);
+// no influence on outputs) and return the statistics of the pruning
+// A link is useless if its output is neither an output value nor a 
+// hidden value used by a useful link, or if it is out of the 
+// execution plan, hence whole chains of useless links are removed
+// The remaining links are moved before the removed ones, keeping their
+// order, and their indices for NNUpdateLinks are those in 
+// NNLinks(that)
+// The links must be sorted as done by NNSetLinks
+NNPruneStats NNPrune(const NeuraNet* const that);
 
 // Get the mutability vector for bases of the NeuraNet 'that' according 
 // to output's 'accuracy'
@@ -321,6 +1272,8 @@ long NNGetGAAdnIntLength(const NeuraNet* const that);
 
 // Set the bounds of the GenAlg 'ga' to be used for bases parameters of 
 // the NeuraNet 'that'
+// The parameters of the bases of the pooling stages of a convolution 
+// NeuraNet are fixed (see NeuraNetCreateConvolutionWithPooling)
 void NNSetGABoundsBases(const NeuraNet* const that, GenAlg* const ga);
 
 // Set the bounds of the GenAlg 'ga' to be used for links description of 
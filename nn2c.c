@@ -0,0 +1,53 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pberr.h"
+#include "neuranet.h"
+
+int main(int argc, char **argv) {
+  char* NNUrl = NULL;
+  char* CUrl = "./nn.c";
+  // Decode arguments
+  for (int iArg = 0; iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg] , "-nn") == 0 && iArg + 1 < argc) {
+      NNUrl = argv[iArg + 1];
+      ++iArg;
+    } else if (strcmp(argv[iArg] , "-c") == 0 && iArg + 1 < argc) {
+      CUrl = argv[iArg + 1];
+      ++iArg;
+    } else if (strcmp(argv[iArg] , "-help") == 0) {
+      printf("arguments : -nn <NeuraNet file url> ");
+      printf("[-c <C code file url, default ./nn.c>]\n");
+      // Stop here
+      return 0;
+    }
+  }
+  if (NNUrl == NULL)
+    return 1;
+  FILE* fd = fopen(NNUrl, "r");
+  if (fd == NULL) {
+    fprintf(stderr, "Failed to open the NeuraNet %s\n", NNUrl);
+    return 1;
+  }
+  NeuraNet* nn = NULL;
+  if (NNLoad(&nn, fd) == false) {
+    fprintf(stderr, "Failed to load the NeuraNet %s\n", NNUrl);
+    fclose(fd);
+    return 1;
+  }
+  fclose(fd);
+  // Remove the links with no influence on the outputs
+  NNPrune(nn);
+  fd = fopen(CUrl, "w");
+  if (fd == NULL || NNSaveAsC(nn, fd) == false) {
+    fprintf(stderr, "Failed to save the C code %s\n", CUrl);
+    if (fd != NULL)
+      fclose(fd);
+    NeuraNetFree(&nn);
+    return 1;
+  }
+  fclose(fd);
+  NeuraNetFree(&nn);
+  // Return success code
+  return 0;
+}
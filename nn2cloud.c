@@ -32,8 +32,11 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Failed to open the NeuraNet %s\n", NNUrl);
   }
   fclose(fd);
-  if (flagPrune)
-    NNPrune(nn);
+  if (flagPrune) {
+    NNPruneStats stats = NNPrune(nn);
+    printf("Pruned %ld links, freed %ld hidden values\n", 
+      stats._nbLinkRemoved, stats._nbHiddenFreed);
+  }
   char* cloudUrl = "./cloud.txt";
   if (NNSaveLinkAsCloudGraph(nn, cloudUrl) == false) {
     fprintf(stderr, "Failed to save the CloudGraph %s\n", cloudUrl);
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "pberr.h"
+#include "neuranet.h"
+
+// Get the current time in seconds
+double BenchNow(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)(t.tv_sec) + (double)(t.tv_nsec) * 1e-9;
+}
+
+// Benchmark of the creation of convolution NeuraNets and the expansion
+// of their links, on 2D inputs of increasing size with 3x3 cells,
+// 4 levels of convolution and 10 outputs
+void BenchConvExpand(void) {
+  printf("input      links   create (ms)   expand (ms)\n");
+  VecShort* dimIn = VecShortCreate(2);
+  VecShort* dimCell = VecShortCreate(2);
+  VecSet(dimCell, 0, 3);
+  VecSet(dimCell, 1, 3);
+  for (short size = 32; size <= 512; size *= 2) {
+    VecSet(dimIn, 0, size);
+    VecSet(dimIn, 1, size);
+    double best[2] = {1e9, 1e9};
+    long nbLinks = 0;
+    // Keep the best of a few runs, less for the largest inputs
+    int nbRun = (size <= 128 ? 5 : 2);
+    for (int iRun = 0; iRun < nbRun; ++iRun) {
+      double t0 = BenchNow();
+      NeuraNet* nn = NeuraNetCreateConvolution(dimIn, 10, dimCell, 
+        4, 1);
+      double t1 = BenchNow();
+      NNExpandLinks(nn);
+      double t2 = BenchNow();
+      nbLinks = NNGetNbActiveLinks(nn);
+      NeuraNetFree(&nn);
+      if (t1 - t0 < best[0])
+        best[0] = t1 - t0;
+      if (t2 - t1 < best[1])
+        best[1] = t2 - t1;
+    }
+    printf("%3dx%-3d %10ld %13.3f %13.3f\n", size, size, nbLinks,
+      best[0] * 1e3, best[1] * 1e3);
+  }
+  VecFree(&dimIn);
+  VecFree(&dimCell);
+}
+
+// Benchmark of NNEval with the input major and output major orders 
+// of links on the NeuraNet saved in the file 'url', on random inputs
+// Return false if the NeuraNet couldn't be loaded
+bool BenchLinkOrder(const char* const url) {
+  FILE* fd = fopen(url, "r");
+  if (fd == NULL) {
+    fprintf(stderr, "Failed to open the NeuraNet %s\n", url);
+    return false;
+  }
+  NeuraNet* nn = NULL;
+  if (NNLoad(&nn, fd) == false) {
+    fprintf(stderr, "Failed to load the NeuraNet %s\n", url);
+    fclose(fd);
+    return false;
+  }
+  fclose(fd);
+  VecFloat* input = VecFloatCreate(NNGetNbInput(nn));
+  VecFloat* output[2] = {
+    VecFloatCreate(NNGetNbOutput(nn)),
+    VecFloatCreate(NNGetNbOutput(nn))};
+  srandom(1);
+  for (int iInput = NNGetNbInput(nn); iInput--;)
+    VecSet(input, iInput, (float)(random() % 2001) / 1000.0 - 1.0);
+  NNLinkOrder order[2] = {NNLinkOrderInputMajor, NNLinkOrderOutputMajor};
+  double best[2] = {1e9, 1e9};
+  // Alternate the orders on short runs and keep the best time per 
+  // evaluation of each order
+  for (int iRun = 0; iRun < 60; ++iRun) {
+    for (int iOrder = 0; iOrder < 2; ++iOrder) {
+      NNSetLinkOrder(nn, order[iOrder]);
+      long nbEval = 0;
+      double t0 = BenchNow();
+      double t = 0.0;
+      do {
+        NNEval(nn, input, output[iOrder]);
+        ++nbEval;
+        t = BenchNow() - t0;
+      } while (t < 0.01);
+      if (t / (double)nbEval < best[iOrder])
+        best[iOrder] = t / (double)nbEval;
+    }
+  }
+  bool same = VecIsEqual(output[0], output[1]);
+  printf("%s: in %d hid %ld out %d links %ld\n", url, NNGetNbInput(nn),
+    NNGetNbMaxHidden(nn), NNGetNbOutput(nn), NNGetNbActiveLinks(nn));
+  printf("  input major %.0f ns, output major %.0f ns (%s)\n", 
+    best[0] * 1e9, best[1] * 1e9, 
+    (same ? "same outputs" : "different outputs"));
+  VecFree(&input);
+  VecFree(output);
+  VecFree(output + 1);
+  NeuraNetFree(&nn);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool conv = false;
+  int nbNN = 0;
+  // Decode arguments
+  for (int iArg = 0; iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg] , "-conv") == 0) {
+      conv = true;
+    } else if (strcmp(argv[iArg] , "-order") == 0 && iArg + 1 < argc) {
+      // The NeuraNet files are read after the decoding
+      ++nbNN;
+      ++iArg;
+    } else if (strcmp(argv[iArg] , "-help") == 0) {
+      printf("arguments : [-conv] [-order <NeuraNet file url>]*\n");
+      printf("-conv : time the creation and expansion of convolution ");
+      printf("NeuraNets\n");
+      printf("-order : time NNEval with each order of links on the ");
+      printf("NeuraNet\n");
+      // Stop here
+      return 0;
+    }
+  }
+  if (conv == false && nbNN == 0) {
+    fprintf(stderr, "Nothing to benchmark, see -help\n");
+    return 1;
+  }
+  if (conv == true)
+    BenchConvExpand();
+  for (int iArg = 0; iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg] , "-order") == 0 && iArg + 1 < argc) {
+      if (BenchLinkOrder(argv[iArg + 1]) == false)
+        return 1;
+      ++iArg;
+    }
+  }
+  // Return success code
+  return 0;
+}